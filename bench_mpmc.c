@@ -0,0 +1,271 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, pthread_barrier_t
+
+#include <pthread.h>
+#include <time.h>
+
+#include "generic.h"
+#include "dict.h"
+#include "mpmc.h"
+#include "queue.h"
+#include "vector.h"
+
+/*
+ * Contention benchmark: producers push items through a bounded queue to
+ * consumers, once through umpmc_queue_t and once through uqueue_t guarded
+ * by a mutex and two condition variables (bounded to the same capacity),
+ * and prints results as JSON:
+ *
+ *     {"config": {...}, "results": [{"consumers": 2, "ns_per_item": 95.1,
+ *      "producers": 2, "queue": "umpmc_queue"}, ...]}
+ *
+ * Usage: bench_mpmc [items [capacity]]
+ *
+ * items (default 10^6) are split between producers and consumers evenly.
+ * Numbers depend on the build flags and on the number of cores, use the
+ * -O3 CFLAGS line in Makefile for meaningful numbers.
+ */
+
+#define BENCH_DEFAULT_ITEMS 1000000
+#define BENCH_LIMIT_ITEMS 1000000000
+#define BENCH_DEFAULT_CAPACITY 1024
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uqueue_t *q;
+    size_t capacity;
+} _locked_queue_t;
+
+typedef struct {
+    const char *name;
+    void (*enq)(void *q, ugeneric_t e);
+    ugeneric_t (*deq)(void *q);
+} bench_queue_t;
+
+typedef struct {
+    const bench_queue_t *queue;
+    void *q;
+    size_t items;
+    pthread_barrier_t *start;
+} _worker_t;
+
+static void _locked_enq(void *ctx, ugeneric_t e)
+{
+    _locked_queue_t *lq = ctx;
+    pthread_mutex_lock(&lq->lock);
+    while (uqueue_get_size(lq->q) == lq->capacity)
+    {
+        pthread_cond_wait(&lq->not_full, &lq->lock);
+    }
+    uqueue_enq(lq->q, e);
+    pthread_cond_signal(&lq->not_empty);
+    pthread_mutex_unlock(&lq->lock);
+}
+
+static ugeneric_t _locked_deq(void *ctx)
+{
+    _locked_queue_t *lq = ctx;
+    pthread_mutex_lock(&lq->lock);
+    while (uqueue_is_empty(lq->q))
+    {
+        pthread_cond_wait(&lq->not_empty, &lq->lock);
+    }
+    ugeneric_t e = uqueue_deq(lq->q);
+    pthread_cond_signal(&lq->not_full);
+    pthread_mutex_unlock(&lq->lock);
+
+    return e;
+}
+
+static void _mpmc_enq(void *q, ugeneric_t e)
+{
+    umpmc_queue_enq(q, e);
+}
+
+static ugeneric_t _mpmc_deq(void *q)
+{
+    return umpmc_queue_deq(q);
+}
+
+static const bench_queue_t _queues[] = {
+    {"umpmc_queue",   _mpmc_enq,   _mpmc_deq},
+    {"locked_uqueue", _locked_enq, _locked_deq},
+};
+
+static const size_t _configs[][2] = {
+    // producers, consumers
+    {1, 1}, {2, 2}, {4, 4}, {1, 4}, {4, 1}, {8, 8},
+};
+
+static void *_produce(void *arg)
+{
+    _worker_t *w = arg;
+    pthread_barrier_wait(w->start);
+    for (size_t i = 0; i < w->items; i++)
+    {
+        w->queue->enq(w->q, G_SIZE(i));
+    }
+
+    return NULL;
+}
+
+static void *_consume(void *arg)
+{
+    _worker_t *w = arg;
+    pthread_barrier_wait(w->start);
+    for (size_t i = 0; i < w->items; i++)
+    {
+        w->queue->deq(w->q);
+    }
+
+    return NULL;
+}
+
+static double _now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Share of items the i-th of n threads takes.
+static size_t _share(size_t items, size_t n, size_t i)
+{
+    return items / n + (i < items % n);
+}
+
+static udict_t *_run(const bench_queue_t *queue, size_t producers,
+                     size_t consumers, size_t items, size_t capacity)
+{
+    _locked_queue_t lq;
+    void *q;
+    if (queue->enq == _mpmc_enq)
+    {
+        q = umpmc_queue_create(capacity);
+    }
+    else
+    {
+        pthread_mutex_init(&lq.lock, NULL);
+        pthread_cond_init(&lq.not_empty, NULL);
+        pthread_cond_init(&lq.not_full, NULL);
+        lq.q = uqueue_create();
+        lq.capacity = capacity;
+        uqueue_reserve_capacity(lq.q, capacity);
+        q = &lq;
+    }
+
+    size_t nthreads = producers + consumers;
+    pthread_t *threads = umalloc(nthreads * sizeof(threads[0]));
+    _worker_t *workers = umalloc(nthreads * sizeof(workers[0]));
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, nthreads + 1);
+
+    for (size_t i = 0; i < nthreads; i++)
+    {
+        bool is_producer = i < producers;
+        workers[i] = (_worker_t){
+            .queue = queue,
+            .q = q,
+            .items = is_producer ? _share(items, producers, i)
+                                 : _share(items, consumers, i - producers),
+            .start = &start,
+        };
+        if (pthread_create(&threads[i], NULL,
+                           is_producer ? _produce : _consume, &workers[i]))
+        {
+            fprintf(stderr, "failed to start a thread\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_barrier_wait(&start);
+    double t = _now_ns();
+    for (size_t i = 0; i < nthreads; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = _now_ns() - t;
+
+    pthread_barrier_destroy(&start);
+    ufree(workers);
+    ufree(threads);
+    if (q == &lq)
+    {
+        uqueue_destroy(lq.q);
+        pthread_cond_destroy(&lq.not_full);
+        pthread_cond_destroy(&lq.not_empty);
+        pthread_mutex_destroy(&lq.lock);
+    }
+    else
+    {
+        umpmc_queue_destroy(q);
+    }
+
+    udict_t *r = udict_create();
+    udict_put(r, G_CSTR("queue"), G_CSTR(queue->name));
+    udict_put(r, G_CSTR("producers"), G_SIZE(producers));
+    udict_put(r, G_CSTR("consumers"), G_SIZE(consumers));
+    udict_put(r, G_CSTR("ns_per_item"), G_REAL(elapsed / items));
+
+    return r;
+}
+
+static size_t _parse_arg(const char *arg, size_t lo, size_t hi)
+{
+    char *end;
+    unsigned long long v = strtoull(arg, &end, 10);
+    if (*end || v < lo || v > hi)
+    {
+        fprintf(stderr, "argument '%s' is out of range [%zu, %zu]\n",
+                arg, lo, hi);
+        exit(EXIT_FAILURE);
+    }
+
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    size_t items = BENCH_DEFAULT_ITEMS;
+    size_t capacity = BENCH_DEFAULT_CAPACITY;
+
+    if (argc > 3)
+    {
+        fprintf(stderr, "usage: %s [items [capacity]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        items = _parse_arg(argv[1], 1, BENCH_LIMIT_ITEMS);
+    }
+    if (argc > 2)
+    {
+        capacity = _parse_arg(argv[2], 1, 1 << 24);
+    }
+
+    uvector_t *results = uvector_create();
+    for (size_t c = 0; c < ARR_LEN(_configs); c++)
+    {
+        for (size_t i = 0; i < ARR_LEN(_queues); i++)
+        {
+            udict_t *r = _run(&_queues[i], _configs[c][0], _configs[c][1],
+                              items, capacity);
+            uvector_append(results, G_DICT(r));
+        }
+    }
+
+    udict_t *config = udict_create();
+    udict_put(config, G_CSTR("items"), G_SIZE(items));
+    udict_put(config, G_CSTR("capacity"), G_SIZE(capacity));
+    udict_put(config, G_CSTR("spin_count"), G_SIZE(UMPMC_SPIN_COUNT));
+
+    udict_t *report = udict_create();
+    udict_put(report, G_CSTR("config"), G_DICT(config));
+    udict_put(report, G_CSTR("results"), G_VECTOR(results));
+    udict_print(report);
+    printf("\n");
+    udict_destroy(report);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,328 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+#include <time.h>
+
+#include "generic.h"
+#include "dict.h"
+#include "mem.h"
+#include "sort.h"
+#include "vector.h"
+
+/*
+ * Sort benchmark: runs every sorting algorithm over a set of input
+ * distributions and sizes and prints results as JSON:
+ *
+ *     {"config": {...}, "results": [{"algorithm": "hybrid_sort",
+ *      "allocations": 0, "comparisons": 8713, "distribution": "random",
+ *      "ns_per_element": 21.4, "size": 1000}, ...]}
+ *
+ * Usage: bench_sort [max_size [min_time_ms]]
+ *
+ * Sizes go from 10 to max_size (default 10^6, up to 10^8) by powers of ten.
+ * Inputs are generated from a fixed seed, so runs are reproducible. Every
+ * measurement is repeated until it takes at least min_time_ms (default 100)
+ * and the average is reported. Comparisons are counted in a separate run
+ * where every element is wrapped into G_PTR and compared by a counting
+ * comparator, allocations are taken from umalloc() family counters (the
+ * benchmark is built from library sources with UMEM_COUNT_ALLOCATIONS).
+ * Timing depends on the build flags, use the -O3 CFLAGS line in Makefile
+ * for meaningful numbers.
+ */
+
+#define BENCH_DEFAULT_MAX_SIZE 1000000
+#define BENCH_LIMIT_MAX_SIZE 100000000
+#define BENCH_DEFAULT_MIN_TIME_MS 100
+#define BENCH_SEED 0x9E3779B97F4A7C15ULL
+
+// O(n^2) algorithms are skipped above this size.
+#define BENCH_QUADRATIC_MAX_SIZE 10000
+
+typedef struct {
+    const char *name;
+    ugeneric_sorter_t sorter;
+    size_t max_size;
+} bench_algorithm_t;
+
+typedef void (*bench_generator_t)(ugeneric_t *base, size_t nmemb);
+
+typedef struct {
+    const char *name;
+    bench_generator_t generate;
+} bench_distribution_t;
+
+static unsigned long long _rng_state;
+
+static unsigned long long _rand(void)
+{
+    // xorshift64*
+    _rng_state ^= _rng_state >> 12;
+    _rng_state ^= _rng_state << 25;
+    _rng_state ^= _rng_state >> 27;
+    return _rng_state * 2685821657736338717ULL;
+}
+
+static void _gen_random(ugeneric_t *base, size_t nmemb)
+{
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        base[i] = G_INT((long)(_rand() >> 1));
+    }
+}
+
+static void _gen_sorted(ugeneric_t *base, size_t nmemb)
+{
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        base[i] = G_INT(i);
+    }
+}
+
+static void _gen_reversed(ugeneric_t *base, size_t nmemb)
+{
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        base[i] = G_INT(nmemb - i);
+    }
+}
+
+static void _gen_sawtooth(ugeneric_t *base, size_t nmemb)
+{
+    // Ascending runs of about sqrt(n) elements.
+    size_t tooth = 1;
+    while (tooth * tooth < nmemb)
+    {
+        tooth++;
+    }
+
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        base[i] = G_INT(i % tooth);
+    }
+}
+
+static void _gen_few_unique(ugeneric_t *base, size_t nmemb)
+{
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        base[i] = G_INT(_rand() % 8);
+    }
+}
+
+static void _gen_mixed(ugeneric_t *base, size_t nmemb)
+{
+    static const char *strings[] = {
+        "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf",
+        "hotel", "india", "juliett", "kilo", "lima", "mike", "november",
+        "oscar", "papa",
+    };
+
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        unsigned long long r = _rand();
+        switch (r % 4)
+        {
+            case 0:
+                base[i] = G_INT((long)(r >> 2));
+                break;
+            case 1:
+                base[i] = G_REAL((double)(r >> 11) / 7.0);
+                break;
+            case 2:
+                base[i] = G_SIZE(r >> 2);
+                break;
+            default:
+                base[i] = G_CSTR(strings[(r >> 2) % ARR_LEN(strings)]);
+                break;
+        }
+    }
+}
+
+static void _parallel_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    parallel_sort(base, nmemb, cmp, 0);
+}
+
+static void _network_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    network_sort(base, nmemb, cmp);
+}
+
+static const bench_algorithm_t _algorithms[] = {
+    {"quick_sort",     quick_sort,     SIZE_MAX},
+    {"merge_sort",     merge_sort,     SIZE_MAX},
+    {"hybrid_sort",    hybrid_sort,    SIZE_MAX},
+    {"timsort",        timsort,        SIZE_MAX},
+    {"radix_sort",     radix_sort,     SIZE_MAX},
+    {"parallel_sort",  _parallel_sort, SIZE_MAX},
+    {"network_sort",   _network_sort,  USORT_NETWORK_MAX},
+    {"insertion_sort", insertion_sort, BENCH_QUADRATIC_MAX_SIZE},
+    {"selection_sort", selection_sort, BENCH_QUADRATIC_MAX_SIZE},
+};
+
+static const bench_distribution_t _distributions[] = {
+    {"random",     _gen_random},
+    {"sorted",     _gen_sorted},
+    {"reversed",   _gen_reversed},
+    {"sawtooth",   _gen_sawtooth},
+    {"few_unique", _gen_few_unique},
+    {"mixed",      _gen_mixed},
+};
+
+static size_t _comparisons;
+
+static int _counting_cmp(const void *p1, const void *p2)
+{
+    _comparisons++;
+    return ugeneric_compare(*(const ugeneric_t *)p1, *(const ugeneric_t *)p2);
+}
+
+static double _now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static size_t _count_comparisons(const bench_algorithm_t *alg,
+                                 ugeneric_t *input, size_t nmemb)
+{
+    /*
+     * Native numeric elements are compared inline without calling cmp,
+     * wrapping them into G_PTR routes every comparison through it. This
+     * also disables radix_sort() and network_sort() fast paths, so their
+     * count is the one of the fallback.
+     */
+    ugeneric_t *wrapped = umalloc_large(nmemb * sizeof(ugeneric_t));
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        wrapped[i] = G_PTR(&input[i]);
+    }
+
+    _comparisons = 0;
+    if (alg->sorter == _parallel_sort)
+    {
+        // Counter is not atomic, count a single threaded run.
+        parallel_sort(wrapped, nmemb, _counting_cmp, 1);
+    }
+    else
+    {
+        alg->sorter(wrapped, nmemb, _counting_cmp);
+    }
+    size_t comparisons = _comparisons;
+    UASSERT(ugeneric_array_is_sorted(wrapped, nmemb, _counting_cmp));
+    ufree_large(wrapped, nmemb * sizeof(ugeneric_t));
+
+    return comparisons;
+}
+
+static udict_t *_run(const bench_algorithm_t *alg,
+                     const bench_distribution_t *dist,
+                     const ugeneric_t *input, size_t nmemb, double min_time_ns)
+{
+    size_t bytes = nmemb * sizeof(ugeneric_t);
+    ugeneric_t *work = umalloc_large(bytes);
+    double elapsed = 0;
+    size_t allocations = 0;
+    size_t reps = 0;
+
+    do
+    {
+        memcpy(work, input, bytes);
+        size_t a = libugeneric_get_allocation_count();
+        double t = _now_ns();
+        alg->sorter(work, nmemb, NULL);
+        elapsed += _now_ns() - t;
+        allocations += libugeneric_get_allocation_count() - a;
+        reps++;
+    } while (elapsed < min_time_ns);
+
+    UASSERT(ugeneric_array_is_sorted(work, nmemb, NULL));
+    ufree_large(work, bytes);
+
+    udict_t *r = udict_create();
+    udict_put(r, G_CSTR("algorithm"), G_CSTR(alg->name));
+    udict_put(r, G_CSTR("distribution"), G_CSTR(dist->name));
+    udict_put(r, G_CSTR("size"), G_SIZE(nmemb));
+    udict_put(r, G_CSTR("repetitions"), G_SIZE(reps));
+    udict_put(r, G_CSTR("ns_per_element"), G_REAL(elapsed / reps / nmemb));
+    udict_put(r, G_CSTR("allocations"), G_REAL((double)allocations / reps));
+    udict_put(r, G_CSTR("comparisons"),
+              G_SIZE(_count_comparisons(alg, (ugeneric_t *)input, nmemb)));
+
+    return r;
+}
+
+static size_t _parse_arg(const char *arg, size_t lo, size_t hi)
+{
+    char *end;
+    unsigned long long v = strtoull(arg, &end, 10);
+    if (*end || v < lo || v > hi)
+    {
+        fprintf(stderr, "argument '%s' is out of range [%zu, %zu]\n",
+                arg, lo, hi);
+        exit(EXIT_FAILURE);
+    }
+
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_size = BENCH_DEFAULT_MAX_SIZE;
+    size_t min_time_ms = BENCH_DEFAULT_MIN_TIME_MS;
+
+    if (argc > 3)
+    {
+        fprintf(stderr, "usage: %s [max_size [min_time_ms]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (argc > 1)
+    {
+        max_size = _parse_arg(argv[1], 10, BENCH_LIMIT_MAX_SIZE);
+    }
+    if (argc > 2)
+    {
+        min_time_ms = _parse_arg(argv[2], 0, 60 * 1000);
+    }
+
+    uvector_t *results = uvector_create();
+    ugeneric_t *input = umalloc_large(max_size * sizeof(ugeneric_t));
+
+    for (size_t d = 0; d < ARR_LEN(_distributions); d++)
+    {
+        for (size_t n = 10; n <= max_size; n *= 10)
+        {
+            _rng_state = BENCH_SEED;
+            _distributions[d].generate(input, n);
+
+            for (size_t a = 0; a < ARR_LEN(_algorithms); a++)
+            {
+                if (n > _algorithms[a].max_size)
+                {
+                    continue;
+                }
+                udict_t *r = _run(&_algorithms[a], &_distributions[d], input, n,
+                                  min_time_ms * 1e6);
+                uvector_append(results, G_DICT(r));
+            }
+        }
+    }
+
+    ufree_large(input, max_size * sizeof(ugeneric_t));
+
+    udict_t *config = udict_create();
+    udict_put(config, G_CSTR("max_size"), G_SIZE(max_size));
+    udict_put(config, G_CSTR("min_time_ms"), G_SIZE(min_time_ms));
+    udict_put(config, G_CSTR("seed"), G_SIZE(BENCH_SEED));
+    udict_put(config, G_CSTR("hybrid_threshold"), G_SIZE(USORT_HYBRID_THRESHOLD));
+    udict_put(config, G_CSTR("radix_threshold"), G_SIZE(USORT_RADIX_THRESHOLD));
+
+    udict_t *report = udict_create();
+    udict_put(report, G_CSTR("config"), G_DICT(config));
+    udict_put(report, G_CSTR("results"), G_VECTOR(results));
+    udict_print(report);
+    printf("\n");
+    udict_destroy(report);
+
+    return EXIT_SUCCESS;
+}
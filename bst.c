@@ -631,6 +631,37 @@ bool ubst_is_empty(ubst_t *b)
     return b->size == 0;
 }
 
+umemusage_t ubst_get_memory_usage(const ubst_t *b)
+{
+    UASSERT_INPUT(b);
+
+    umemusage_t u = {0};
+    u.structure = sizeof(*b) + b->size * sizeof(ubst_node_t);
+    if (b->is_data_owner && b->root)
+    {
+        // Walk the tree without recursion.
+        ustack_t *s = ustack_create();
+        ustack_push(s, G_PTR(b->root));
+        while (!ustack_is_empty(s))
+        {
+            ubst_node_t *node = G_AS_PTR(ustack_pop(s));
+            umemusage_add(&u, ugeneric_get_memory_usage(node->k));
+            umemusage_add(&u, ugeneric_get_memory_usage(node->v));
+            if (node->left)
+            {
+                ustack_push(s, G_PTR(node->left));
+            }
+            if (node->right)
+            {
+                ustack_push(s, G_PTR(node->right));
+            }
+        }
+        ustack_destroy(s);
+    }
+
+    return u;
+}
+
 void ubst_destroy(ubst_t *b)
 {
     if (b)
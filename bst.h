@@ -40,6 +40,7 @@ ugeneric_t ubst_get_min(ubst_t *b);
 ugeneric_t ubst_get_max(ubst_t *b);
 size_t ubst_get_size(ubst_t *b);
 bool ubst_is_empty(ubst_t *b);
+umemusage_t ubst_get_memory_usage(const ubst_t *b);
 void ubst_clear(ubst_t *b);
 ugeneric_t ubst_get_inorder_predecessor(ubst_t *b,
                                         ugeneric_t k, ugeneric_t vdef);
@@ -20,6 +20,7 @@ static const udict_vtable_t _uhtbl_vtable = {
     .fprint              = (f_udict_fprint)uhtbl_fprint,
     .get_base            = (f_udict_get_base)uhtbl_get_base,
     .get_items           = (f_udict_get_items)uhtbl_get_items,
+    .get_memory_usage    = (f_udict_get_memory_usage)uhtbl_get_memory_usage,
 };
 
 static const udict_vtable_t _ubst_vtable = {
@@ -36,6 +37,7 @@ static const udict_vtable_t _ubst_vtable = {
     .fprint              = (f_udict_fprint)ubst_fprint,
     .get_base            = (f_udict_get_base)uhtbl_get_base,
     .get_items           = (f_udict_get_items)ubst_get_items,
+    .get_memory_usage    = (f_udict_get_memory_usage)ubst_get_memory_usage,
 };
 
 static const udict_iterator_vtable_t _uhtbl_iterator_vtable = {
@@ -117,6 +119,16 @@ void udict_update(udict_t *d, udict_t *update)
     udict_iterator_destroy(di);
 }
 
+umemusage_t udict_get_memory_usage(const udict_t *d)
+{
+    UASSERT_INPUT(d);
+
+    umemusage_t u = d->vtable->get_memory_usage(d->vobj);
+    u.structure += sizeof(*d);
+
+    return u;
+}
+
 void udict_destroy(udict_t *d)
 {
     UASSERT_INPUT(d);
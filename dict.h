@@ -38,6 +38,7 @@ typedef int        (*f_udict_print)(const void *d);
 typedef int        (*f_udict_fprint)(const void *d, FILE *out);
 typedef ugeneric_base_t *(*f_udict_get_base)(void *d);
 typedef uvector_t *(*f_udict_get_items)(const void *d, udict_items_kind_t kind, bool deep);
+typedef umemusage_t (*f_udict_get_memory_usage)(const void *d);
 
 typedef ugeneric_kv_t (*f_udict_iterator_get_next)(void *di);
 typedef bool          (*f_udict_iterator_has_next)(const void *di);
@@ -57,6 +58,7 @@ typedef struct {
     f_udict_fprint              fprint;
     f_udict_get_base            get_base;
     f_udict_get_items           get_items;
+    f_udict_get_memory_usage    get_memory_usage;
 } udict_vtable_t;
 
 typedef struct {
@@ -99,6 +101,7 @@ static inline char *udict_as_str(const udict_t *d) {return d->vtable->as_str(d->
 static inline int udict_fprint(const udict_t *d, FILE *out) {return d->vtable->fprint(d->vobj, out);}
 static inline int udict_print(const udict_t *d) {return udict_fprint(d, stdout); }
 static inline uvector_t *udict_get_items(const udict_t *d, udict_items_kind_t kind, bool deep) {return d->vtable->get_items(d->vobj, kind, deep);}
+umemusage_t udict_get_memory_usage(const udict_t *d);
 void udict_destroy(udict_t *d);
 int udict_compare(const udict_t *d1, const udict_t *d2);
 void udict_set_void_hasher(udict_t *d, void_hasher_t hasher);
@@ -1,7 +1,12 @@
+#define _POSIX_C_SOURCE 200809L // getline(), mkstemp()
+
 #include "file_utils.h"
 
 #include "asserts.h"
+#include "heap.h"
 #include "mem.h"
+#include "sort.h"
+#include <unistd.h>
 
 struct ufile_reader_opaq {
     FILE *file;
@@ -9,6 +14,8 @@ struct ufile_reader_opaq {
     size_t read_offset;
     void *buffer;
     size_t buffer_size;
+    char *line;         // allocated by getline(), not by umalloc()
+    size_t line_capacity;
 };
 
 struct ufile_writer_opaq {
@@ -267,6 +274,8 @@ ugeneric_t ufile_reader_create(const char *path, size_t buffer_size)
     fr->file = file;
     fr->read_offset = 0;
     fr->file_size = file_size;
+    fr->line = NULL;
+    fr->line_capacity = 0;
 
     return G_PTR(fr);
 }
@@ -305,6 +314,33 @@ ugeneric_t ufile_reader_read(ufile_reader_t *fr, size_t size, void *buffer)
     return (buffer ? G_MEMCHUNK(buffer, r) : G_MEMCHUNK(fr->buffer, r));
 }
 
+/*
+ * Returns the next line without trailing '\n' as a null terminated memory
+ * chunk which stays valid until the next read, G_NULL() at the end of file.
+ */
+ugeneric_t ufile_reader_read_line(ufile_reader_t *fr)
+{
+    UASSERT_INPUT(fr);
+
+    ssize_t r = getline(&fr->line, &fr->line_capacity, fr->file);
+    if (r == -1)
+    {
+        if (ferror(fr->file))
+        {
+            return _error_handler(G_ERROR_IO, _error_handler_ctx);
+        }
+        return G_NULL();
+    }
+    fr->read_offset += r;
+
+    if ((r > 0) && (fr->line[r - 1] == '\n'))
+    {
+        fr->line[--r] = 0;
+    }
+
+    return G_MEMCHUNK(fr->line, r);
+}
+
 bool ufile_reader_has_next(const ufile_reader_t *fr)
 {
     return fr->read_offset < fr->file_size;
@@ -347,6 +383,7 @@ ugeneric_t ufile_reader_destroy(ufile_reader_t *fr)
     {
         g = ufile_close(fr->file);
         ufree(fr->buffer);
+        free(fr->line);
         ufree(fr);
     }
 
@@ -419,3 +456,370 @@ void libugeneric_set_file_error_handler(ufile_error_handler_t error_handler,
     _error_handler = error_handler;
     _error_handler_ctx = error_handler_ctx;
 }
+
+/*
+ * External merge sort.
+ *
+ * Input is read line by line into a run arena of memory_budget bytes: line
+ * data grows from the front and a cell per line grows from the back, so a
+ * run never takes more than the budget. Full runs are sorted with
+ * parallel_sort() (libugeneric_set_sort_threads() controls the threads),
+ * its merge buffer is taken from the arena too: with more than one thread
+ * every line reserves a second cell in front of the cells. Sorted runs are
+ * spilled to temporary files, which are then merged by a heap, at most
+ * UFILE_SORT_MAX_FANOUT of them at once. Input which fits into a single run
+ * is never spilled.
+ */
+
+typedef struct {
+    char *arena;
+    size_t size;
+    size_t used;
+    size_t nlines;
+    size_t cells_per_line; // 2 if the sort needs a scratch cell per line
+} _sort_run_t;
+
+typedef struct {
+    ufile_reader_t *reader;
+    char *buf;          // [run index][line]
+    size_t buf_size;
+} _merge_src_t;
+
+static inline ugeneric_t *_run_get_cells(const _sort_run_t *run)
+{
+    return (ugeneric_t *)(run->arena + run->size) - run->nlines;
+}
+
+static inline ugeneric_t *_run_get_scratch(const _sort_run_t *run)
+{
+    return (run->cells_per_line > 1) ? _run_get_cells(run) - run->nlines : NULL;
+}
+
+static bool _run_add_line(_sort_run_t *run, umemchunk_t line, void_cmp_t cmp)
+{
+    size_t cell_size = run->cells_per_line * sizeof(ugeneric_t);
+    size_t free_space = run->size - run->used - run->nlines * cell_size;
+    if (line.size + 1 + cell_size > free_space)
+    {
+        return false;
+    }
+
+    char *dst = run->arena + run->used;
+    memcpy(dst, line.data, line.size);
+    dst[line.size] = 0;
+    run->used += line.size + 1;
+    run->nlines++;
+    *_run_get_cells(run) = cmp ? G_PTR(dst) : G_CSTR(dst);
+
+    return true;
+}
+
+static ugeneric_t _write_line(const char *line, size_t size, void *writer)
+{
+    ugeneric_t g = ufile_writer_write(writer, (umemchunk_t){(void *)line, size});
+    if (G_IS_ERROR(g))
+    {
+        return g;
+    }
+
+    return ufile_writer_write(writer, (umemchunk_t){"\n", 1});
+}
+
+static ugeneric_t _create_temp_file(void)
+{
+    const char *dir = getenv("TMPDIR");
+    char *path = ustring_fmt("%s/ugeneric_sort_XXXXXX", dir ? dir : "/tmp");
+
+    int fd = mkstemp(path);
+    if (fd == -1)
+    {
+        ufree(path);
+        return _error_handler(G_ERROR_IO, _error_handler_ctx);
+    }
+    close(fd);
+
+    return G_STR(path);
+}
+
+static ugeneric_t _spill_run(const _sort_run_t *run, uvector_t *paths)
+{
+    ugeneric_t g = _create_temp_file();
+    if (G_IS_ERROR(g))
+    {
+        return g;
+    }
+    uvector_append(paths, g);
+
+    if (G_IS_ERROR(g = ufile_writer_create(G_AS_STR(g))))
+    {
+        return g;
+    }
+    ufile_writer_t *fw = G_AS_PTR(g);
+
+    ugeneric_t *cells = _run_get_cells(run);
+    for (size_t i = 0; (i < run->nlines) && !G_IS_ERROR(g); i++)
+    {
+        const char *line = G_AS_PTR(cells[i]);
+        g = _write_line(line, strlen(line), fw);
+    }
+
+    ugeneric_t e = ufile_writer_destroy(fw);
+
+    return G_IS_ERROR(g) ? g : e;
+}
+
+/* Reads the next line of source i and pushes it to the heap. Each source
+ * has at most one line in the heap at a time, so the line is kept in the
+ * source's own buffer prefixed with the source index, heap elements are
+ * pointers to lines and can be compared by the user comparator as is.
+ */
+static ugeneric_t _merge_src_next(_merge_src_t *srcs, size_t i, uheap_t *h,
+                                  void_cmp_t cmp)
+{
+    ugeneric_t g = ufile_reader_read_line(srcs[i].reader);
+    if (G_IS_ERROR(g) || G_IS_NULL(g))
+    {
+        return g;
+    }
+
+    umemchunk_t line = G_AS_MEMCHUNK(g);
+    size_t size = sizeof(i) + line.size + 1;
+    if (srcs[i].buf_size < size)
+    {
+        srcs[i].buf = urealloc(srcs[i].buf, size);
+        srcs[i].buf_size = size;
+    }
+    memcpy(srcs[i].buf, &i, sizeof(i));
+    memcpy(srcs[i].buf + sizeof(i), line.data, line.size + 1);
+
+    char *dst = srcs[i].buf + sizeof(i);
+    uheap_push(h, cmp ? G_PTR(dst) : G_CSTR(dst));
+
+    return G_NULL();
+}
+
+static ugeneric_t _merge_runs(const ugeneric_t *paths, size_t npaths,
+                              void_cmp_t cmp, ufile_line_handler_t handler,
+                              void *ctx)
+{
+    _merge_src_t *srcs = ucalloc(npaths, sizeof(*srcs));
+    uheap_t *h = uheap_create_ext(npaths, UHEAP_TYPE_MIN);
+    uheap_drop_data_ownership(h);
+    uheap_set_void_comparator(h, cmp);
+    ugeneric_t g = G_NULL();
+
+    for (size_t i = 0; (i < npaths) && !G_IS_ERROR(g); i++)
+    {
+        g = ufile_reader_create(G_AS_STR(paths[i]), BUFSIZ);
+        if (!G_IS_ERROR(g))
+        {
+            srcs[i].reader = G_AS_PTR(g);
+            g = _merge_src_next(srcs, i, h, cmp);
+        }
+    }
+
+    while (!G_IS_ERROR(g) && !uheap_is_empty(h))
+    {
+        const char *line = G_AS_PTR(uheap_pop(h));
+        size_t i;
+        memcpy(&i, line - sizeof(i), sizeof(i));
+        g = handler(line, strlen(line), ctx);
+        if (!G_IS_ERROR(g))
+        {
+            g = _merge_src_next(srcs, i, h, cmp);
+        }
+    }
+
+    for (size_t i = 0; i < npaths; i++)
+    {
+        ugeneric_t e = ufile_reader_destroy(srcs[i].reader);
+        if (!G_IS_ERROR(g))
+        {
+            g = e;
+        }
+        else
+        {
+            ugeneric_destroy(e);
+        }
+        ufree(srcs[i].buf);
+    }
+    uheap_destroy(h);
+    ufree(srcs);
+
+    return g;
+}
+
+/* Merges the oldest runs into a new one until at most UFILE_SORT_MAX_FANOUT
+ * runs are left, i.e. every pass goes through the whole data once. Merged
+ * runs are replaced with G_NULL(), *first is the index of the oldest run
+ * left.
+ */
+static ugeneric_t _reduce_runs(uvector_t *paths, size_t *first, void_cmp_t cmp)
+{
+    ugeneric_t g = G_NULL();
+
+    while (uvector_get_size(paths) - *first > UFILE_SORT_MAX_FANOUT)
+    {
+        if (G_IS_ERROR(g = _create_temp_file()))
+        {
+            return g;
+        }
+        uvector_append(paths, g);
+
+        if (G_IS_ERROR(g = ufile_writer_create(G_AS_STR(g))))
+        {
+            return g;
+        }
+        ufile_writer_t *fw = G_AS_PTR(g);
+
+        g = _merge_runs(uvector_get_cells(paths) + *first, UFILE_SORT_MAX_FANOUT,
+                        cmp, _write_line, fw);
+        ugeneric_t e = ufile_writer_destroy(fw);
+
+        for (size_t i = 0; i < UFILE_SORT_MAX_FANOUT; i++, (*first)++)
+        {
+            remove(G_AS_STR(uvector_get_at(paths, *first)));
+            uvector_set_at(paths, *first, G_NULL());
+        }
+
+        if (G_IS_ERROR(g))
+        {
+            ugeneric_destroy(e);
+            return g;
+        }
+        if (G_IS_ERROR(e))
+        {
+            return e;
+        }
+    }
+
+    return g;
+}
+
+ugeneric_t ufile_sort_ext(const char *in_path, ufile_line_handler_t handler,
+                          void *ctx, void_cmp_t cmp, size_t memory_budget)
+{
+    UASSERT_INPUT(in_path);
+    UASSERT_INPUT(handler);
+
+    if (memory_budget == 0)
+    {
+        memory_budget = UFILE_SORT_DEFAULT_MEMORY_BUDGET;
+    }
+    UASSERT_INPUT(memory_budget >= UFILE_SORT_MIN_MEMORY_BUDGET);
+
+    ugeneric_t g = ufile_reader_create(in_path, BUFSIZ);
+    if (G_IS_ERROR(g))
+    {
+        return g;
+    }
+    ufile_reader_t *fr = G_AS_PTR(g);
+
+    _sort_run_t run = {0};
+    run.size = memory_budget - memory_budget % sizeof(ugeneric_t);
+    run.arena = umalloc_large(run.size);
+    uvector_t *paths = uvector_create();
+    size_t nthreads = libugeneric_get_sort_threads();
+    run.cells_per_line = (nthreads == 1) ? 1 : 2;
+
+    for (;;)
+    {
+        if (G_IS_ERROR(g = ufile_reader_read_line(fr)))
+        {
+            break;
+        }
+        bool is_eof = G_IS_NULL(g);
+        umemchunk_t line = is_eof ? (umemchunk_t){0} : G_AS_MEMCHUNK(g);
+
+        if (is_eof || !_run_add_line(&run, line, cmp))
+        {
+            parallel_sort_ext(_run_get_cells(&run), run.nlines, cmp, nthreads,
+                              _run_get_scratch(&run));
+            if (is_eof && uvector_is_empty(paths))
+            {
+                // Everything fits in memory, no need to spill.
+                ugeneric_t *cells = _run_get_cells(&run);
+                for (size_t i = 0; (i < run.nlines) && !G_IS_ERROR(g); i++)
+                {
+                    const char *line = G_AS_PTR(cells[i]);
+                    g = handler(line, strlen(line), ctx);
+                }
+                break;
+            }
+
+            if (run.nlines)
+            {
+                if (G_IS_ERROR(g = _spill_run(&run, paths)))
+                {
+                    break;
+                }
+                run.used = 0;
+                run.nlines = 0;
+            }
+
+            if (is_eof)
+            {
+                size_t first = 0;
+                if (!G_IS_ERROR(g = _reduce_runs(paths, &first, cmp)))
+                {
+                    g = _merge_runs(uvector_get_cells(paths) + first,
+                                    uvector_get_size(paths) - first, cmp,
+                                    handler, ctx);
+                }
+                break;
+            }
+
+            // Line which did not fit goes to the new run.
+            if (!_run_add_line(&run, line, cmp))
+            {
+                g = G_ERROR(ustring_fmt("line of %zu bytes exceeds memory budget",
+                                        line.size));
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < uvector_get_size(paths); i++)
+    {
+        ugeneric_t path = uvector_get_at(paths, i);
+        if (G_IS_STRING(path))
+        {
+            remove(G_AS_STR(path));
+        }
+    }
+    uvector_destroy(paths);
+    ufree_large(run.arena, run.size);
+
+    ugeneric_t e = ufile_reader_destroy(fr);
+    if (G_IS_ERROR(g))
+    {
+        ugeneric_destroy(e);
+        return g;
+    }
+
+    return e;
+}
+
+ugeneric_t ufile_sort(const char *in_path, const char *out_path,
+                      void_cmp_t cmp, size_t memory_budget)
+{
+    UASSERT_INPUT(in_path);
+    UASSERT_INPUT(out_path);
+
+    ugeneric_t g = ufile_writer_create(out_path);
+    if (G_IS_ERROR(g))
+    {
+        return g;
+    }
+    ufile_writer_t *fw = G_AS_PTR(g);
+
+    g = ufile_sort_ext(in_path, _write_line, fw, cmp, memory_budget);
+    ugeneric_t e = ufile_writer_destroy(fw);
+    if (G_IS_ERROR(g))
+    {
+        ugeneric_destroy(e);
+        return g;
+    }
+
+    return e;
+}
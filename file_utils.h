@@ -42,4 +42,27 @@ ugeneric_t ufile_writer_get_position(const ufile_writer_t *fw);
 ugeneric_t ufile_writer_set_position(ufile_writer_t *fw, size_t position);
 ugeneric_t ufile_writer_destroy(ufile_writer_t *fw);
 
+#ifndef UFILE_SORT_DEFAULT_MEMORY_BUDGET
+#define UFILE_SORT_DEFAULT_MEMORY_BUDGET (64 * 1024 * 1024)
+#endif
+#define UFILE_SORT_MIN_MEMORY_BUDGET 1024
+#define UFILE_SORT_MAX_FANOUT 64
+
+/* Receives sorted lines one by one, returning G_ERROR stops the sort. */
+typedef ugeneric_t (*ufile_line_handler_t)(const char *line, size_t size, void *ctx);
+
+/*
+ * External merge sort of lines of a text file, input may be far larger than
+ * memory: sorted runs of at most memory_budget bytes (0 means default) are
+ * spilled to temporary files in $TMPDIR (or /tmp) and merged afterwards.
+ * Lines are compared with strcmp() or, if cmp is given, with cmp applied to
+ * the null terminated lines. Lines must not contain null bytes, output lines
+ * always end with '\n'. With more than one sort thread, the merge buffer of
+ * the parallel sort is also taken out of the budget.
+ */
+ugeneric_t ufile_sort(const char *in_path, const char *out_path,
+                      void_cmp_t cmp, size_t memory_budget);
+ugeneric_t ufile_sort_ext(const char *in_path, ufile_line_handler_t handler,
+                          void *ctx, void_cmp_t cmp, size_t memory_budget);
+
 #endif
@@ -276,6 +276,39 @@ ugeneric_t ugeneric_copy_v(ugeneric_t g, void_cpy_t cpy)
     return ret;
 }
 
+/*
+ * Memory referenced by the generic, the generic itself is not accounted.
+ * Size of void data is not known, so G_PTR contributes nothing.
+ */
+umemusage_t ugeneric_get_memory_usage(ugeneric_t g)
+{
+    umemusage_t u = {0};
+
+    switch (ugeneric_get_type(g))
+    {
+        case G_STR_T:
+            u.payload = strlen(G_AS_STR(g)) + 1;
+            break;
+
+        case G_MEMCHUNK_T:
+            u.payload = G_AS_MEMCHUNK_SIZE(g);
+            break;
+
+        case G_VECTOR_T:
+            u = uvector_get_memory_usage(G_AS_PTR(g));
+            break;
+
+        case G_DICT_T:
+            u = udict_get_memory_usage(G_AS_PTR(g));
+            break;
+
+        default:
+            break;
+    }
+
+    return u;
+}
+
 int ugeneric_fprint_v(ugeneric_t g, FILE *out, void_s8r_t void_serializer)
 {
     UASSERT_INPUT(out);
@@ -876,6 +909,11 @@ size_t ugeneric_hash(ugeneric_t g, void_hasher_t hasher)
             return G_AS_INT(g);
 
         case G_REAL_T:
+            // -0.0 and 0.0 are equal, so they must hash the same.
+            if (G_AS_REAL(g) == 0)
+            {
+                return 0;
+            }
             data = &G_AS_REAL(g);
             size = sizeof(G_AS_REAL(g));
             break;
@@ -141,6 +141,11 @@ typedef char *(*void_s8r_t)(const void *ptr, size_t *output_size);
 typedef size_t (*void_hasher_t)(const void *ptr);
 typedef bool (*ugeneric_kv_iter_t)(ugeneric_t k, ugeneric_t v, void *data);
 typedef void (*ugeneric_sorter_t)(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
+typedef ugeneric_t (*ugeneric_key_extractor_t)(ugeneric_t g, void *ctx);
+typedef ugeneric_t (*ugeneric_mapper_t)(ugeneric_t g, void *ctx);
+typedef bool (*ugeneric_predicate_t)(ugeneric_t g, void *ctx);
+typedef ugeneric_t (*ugeneric_reducer_t)(ugeneric_t acc, ugeneric_t g, void *ctx);
+typedef void (*ugeneric_visitor_t)(ugeneric_t *g, void *ctx);
 
 void ugeneric_swap(ugeneric_t *g1, ugeneric_t *g2);
 size_t ugeneric_hash(ugeneric_t g, void_hasher_t hasher);
@@ -165,6 +170,8 @@ void ugeneric_random_init_with_seed(unsigned int seed);
 int random_from_range(int start, int stop);
 int ugeneric_random_from_range(int l, int h);
 
+umemusage_t ugeneric_get_memory_usage(ugeneric_t g);
+
 char *ugeneric_as_str_v(ugeneric_t g, void_s8r_t void_serializer);
 void ugeneric_serialize_v(ugeneric_t g, ubuffer_t *buf, void_s8r_t void_serializer);
 int ugeneric_fprint_v(ugeneric_t g, FILE *out, void_s8r_t void_serializer);
@@ -197,6 +204,7 @@ typedef enum {
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
 #define ARR_LEN(a) sizeof(a)/sizeof(a[0])
+#define IS_POWER_OF_TWO(n) ((n) && !((n) & ((n) - 1)))
 #define SCALE_FACTOR 1.5
 
 typedef struct {
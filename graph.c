@@ -2,7 +2,7 @@
 
 #include "bitmap.h"
 #include "dsu.h"
-#include "heap.h"
+#include "iheap.h"
 #include "list.h"
 #include "mem.h"
 #include "queue.h"
@@ -132,6 +132,24 @@ size_t ugraph_get_vertex_count(const ugraph_t *g)
     return g->n;
 }
 
+umemusage_t ugraph_get_memory_usage(const ugraph_t *g)
+{
+    UASSERT_INPUT(g);
+
+    // Adjacency lists and edges are void data for the containers,
+    // account them explicitly.
+    umemusage_t u = uvector_get_memory_usage(g->adj);
+    u.structure += sizeof(*g);
+    for (size_t i = 0; i < g->n; i++)
+    {
+        ulist_t *adj = G_AS_PTR(uvector_get_at(g->adj, i));
+        umemusage_add(&u, ulist_get_memory_usage(adj));
+        u.payload += ulist_get_size(adj) * sizeof(ugraph_edge_t);
+    }
+
+    return u;
+}
+
 void ugraph_destroy(ugraph_t *g)
 {
     if (g)
@@ -341,44 +359,13 @@ exit:
 #define _DIJ_INF SIZE_MAX        // infinite distance
 #define _DIJ_EMPTY_PREV SIZE_MAX // non-existing previous node
 
-// Aux structure for being stored in min heap.
-typedef struct {
-    size_t n; // node number in the graph
-    size_t d; // least known distance from root node to node n
-} _dist_t;
-
-static _dist_t *_alloc_dist(size_t n, size_t dist)
-{
-    _dist_t *d = umalloc(sizeof(*d));
-    d->n = n;
-    d->d = dist;
-    return d;
-}
-
-// distance/node pairs are ordered by distance in the heap
-int _dist_cmp(const void *ptr1, const void *ptr2)
-{
-    const _dist_t *d1 = ptr1;
-    const _dist_t *d2 = ptr2;
-
-    if (d1->d < d2->d) return -1;
-    if (d1->d > d2->d) return  1;
-    return  0;
-}
-
-char *_dist_s8r(const void *ptr, size_t *output_size)
-{
-    const _dist_t *d = ptr;
-    return ustring_fmt_sized("(node: %d, dist: %d)", output_size, d->n, d->d);
-}
-
 uvector_t *ugraph_dijkstra(const ugraph_t *g, size_t from, size_t to)
 {
     UASSERT_INPUT(g);
     UASSERT_INPUT(from < g->n);
     UASSERT_INPUT(to < g->n);
 
-    size_t n, d;
+    size_t n;
     uvector_t *path;
     const ugraph_edge_t *e = NULL;
     ugraph_edge_iterator_t *ei = NULL;
@@ -393,27 +380,15 @@ uvector_t *ugraph_dijkstra(const ugraph_t *g, size_t from, size_t to)
     }
     dist[from] = 0;
 
-    // Create and initialize priority queue for storing dist_t structures.
-    uheap_t *h = uheap_create();
-    uheap_set_void_comparator(h, _dist_cmp);
-    uheap_set_void_destroyer(h, ufree);
-    //uheap_set_void_serializer(h, _dist_s8r);
-    uheap_push(h, G_PTR(_alloc_dist(from, 0)));
+    // Priority queue of nodes keyed by the least known distance, every node
+    // is in the queue at most once.
+    uiheap_t *h = uiheap_create_ext(g->n, UHEAP_TYPE_MIN);
+    uiheap_push(h, from, G_SIZE(0));
 
     // Loop and calculates shortest paths to all nodes from the root node.
-    while (!uheap_is_empty(h))
+    while (!uiheap_is_empty(h))
     {
-        _dist_t *dst = G_AS_PTR(uheap_pop(h));
-        n = dst->n;
-        d = dst->d;
-        ufree(dst);
-
-        if (d != dist[n])
-        {
-            // Filter out odd pairs, see comment below.
-            continue;
-        }
-
+        n = uiheap_pop(h, NULL);
         if (n == to)
         {
             // Last vertex is reached.
@@ -427,19 +402,16 @@ uvector_t *ugraph_dijkstra(const ugraph_t *g, size_t from, size_t to)
             size_t new_dist = dist[n] + e->w;
             if (new_dist < dist[e->t])
             {
-                // This code handles distance relaxation for node e->t. As
-                // distance relaxation may happen more than once for the same
-                // node during algorithm execution there can be many
-                // (node, distance) pairs on the heap for the same node but
-                // with different distances. Alternative approach would be to
-                // perform decreasing of the distance for the node within
-                // the heap but this operation (decrease_priority) is not
-                // normally provided by heap implementation. Instead this code
-                // filters out odd (node, distance) pairs by comparing the distance
-                // stored in the heap and the distance stored in the dist array.
                 dist[e->t] = new_dist;
                 prev[e->t] = e->f;
-                uheap_push(h, G_PTR(_alloc_dist(e->t, new_dist)));
+                if (uiheap_contains(h, e->t))
+                {
+                    uiheap_decrease_key(h, e->t, G_SIZE(new_dist));
+                }
+                else
+                {
+                    uiheap_push(h, e->t, G_SIZE(new_dist));
+                }
             }
         }
         ugraph_edge_iterator_destroy(ei);
@@ -461,7 +433,7 @@ exit:
         uvector_reverse(path);
     }
 
-    uheap_destroy(h);
+    uiheap_destroy(h);
     ufree(dist);
     ufree(prev);
 
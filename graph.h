@@ -28,6 +28,7 @@ void ugraph_remove_edge(ugraph_t *g, size_t from, size_t to);
 const ugraph_edge_t *ugraph_get_edge(const ugraph_t *g, size_t from, size_t to);
 size_t ugraph_get_edge_count(const ugraph_t *g);
 size_t ugraph_get_vertex_count(const ugraph_t *g);
+umemusage_t ugraph_get_memory_usage(const ugraph_t *g);
 uvector_t *ugraph_get_vertices(const ugraph_t *g);
 uvector_t *ugraph_get_edges(const ugraph_t *g); // vector of *ugraph_edge_t
 uvector_t *ugraph_get_min_cut(const ugraph_t *g, size_t iterations);
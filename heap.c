@@ -73,6 +73,42 @@ void uheap_push(uheap_t *h, ugeneric_t e)
     }
 }
 
+static void _percolate_down(const uheap_t *h, ugeneric_t *a, size_t n)
+{
+    size_t i = 0;
+    size_t t = 0;
+    size_t l = LCHILD_IDX(i);
+    size_t r = RCHILD_IDX(i);
+
+    void_cmp_t cmp = uvector_get_void_comparator(h->data);
+    while (l < n || r < n) // percolate the root down to the right position
+    {
+        if (r < n)
+        {
+            t = LCHILD_IDX(i);
+            if (h->type * ugeneric_compare_v(a[l], a[r], cmp) > 0)
+            {
+                t = RCHILD_IDX(i);
+            }
+        }
+        else if (l < n)
+        {
+            t = LCHILD_IDX(i);
+        }
+        if (h->type * ugeneric_compare_v(a[i], a[t], cmp) > 0)
+        {
+            ugeneric_swap(&a[i], &a[t]);
+            i = t;
+            l = LCHILD_IDX(i);
+            r = RCHILD_IDX(i);
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
 ugeneric_t uheap_pop(uheap_t *h)
 {
     UASSERT_INPUT(h);
@@ -85,44 +121,34 @@ ugeneric_t uheap_pop(uheap_t *h)
 
     if (n)
     {
-        size_t i = 0;
-        size_t t = 0;
-        size_t l = LCHILD_IDX(i);
-        size_t r = RCHILD_IDX(i);
         a[0] = e1; // move the last element to the root
-
-        void_cmp_t cmp = uvector_get_void_comparator(h->data);
-        while (l < n || r < n) // percolate the root down to the right position
-        {
-            if (r < n)
-            {
-                t = LCHILD_IDX(i);
-                if (h->type * ugeneric_compare_v(a[l], a[r], cmp) > 0)
-                {
-                    t = RCHILD_IDX(i);
-                }
-            }
-            else if (l < n)
-            {
-                t = LCHILD_IDX(i);
-            }
-            if (h->type * ugeneric_compare_v(a[i], a[t], cmp) > 0)
-            {
-                ugeneric_swap(&a[i], &a[t]);
-                i = t;
-                l = LCHILD_IDX(i);
-                r = RCHILD_IDX(i);
-            }
-            else
-            {
-                break;
-            }
-        }
+        _percolate_down(h, a, n);
     }
 
     return e;
 }
 
+ugeneric_t uheap_pushpop(uheap_t *h, ugeneric_t e)
+{
+    UASSERT_INPUT(h);
+
+    ugeneric_t *a = uvector_get_cells(h->data);
+    size_t n = uvector_get_size(h->data);
+    void_cmp_t cmp = uvector_get_void_comparator(h->data);
+
+    // e would be popped right away, heap is left intact.
+    if ((n == 0) || (h->type * ugeneric_compare_v(e, a[0], cmp) <= 0))
+    {
+        return e;
+    }
+
+    ugeneric_t top = a[0];
+    a[0] = e;
+    _percolate_down(h, a, n);
+
+    return top;
+}
+
 ugeneric_t uheap_peek(const uheap_t *h)
 {
     UASSERT_INPUT(h);
@@ -148,6 +174,16 @@ size_t uheap_get_capacity(const uheap_t *h)
     return uvector_get_capacity(h->data);
 }
 
+umemusage_t uheap_get_memory_usage(const uheap_t *h)
+{
+    UASSERT_INPUT(h);
+
+    umemusage_t u = uvector_get_memory_usage(h->data);
+    u.structure += sizeof(*h);
+
+    return u;
+}
+
 void uheap_reserve_capacity(uheap_t *h, size_t new_capacity)
 {
     UASSERT_INPUT(h);
@@ -21,11 +21,15 @@ void uheap_destroy(uheap_t *h);
 void uheap_clear(uheap_t *h);
 void uheap_push(uheap_t *h, ugeneric_t e);
 ugeneric_t uheap_pop(uheap_t *h);
+// Same as push followed by pop but with a single percolation, handy to keep
+// the k largest (with a min heap) or smallest (with a max heap) elements.
+ugeneric_t uheap_pushpop(uheap_t *h, ugeneric_t e);
 size_t uheap_get_size(const uheap_t *h);
 bool uheap_is_empty(const uheap_t *h);
 ugeneric_t uheap_peek(const uheap_t *h);
 
 size_t uheap_get_capacity(const uheap_t *h);
+umemusage_t uheap_get_memory_usage(const uheap_t *h);
 void uheap_reserve_capacity(uheap_t *h, size_t new_capacity);
 ugeneric_t *uheap_get_cells(const uheap_t *h);
 
@@ -83,7 +83,7 @@ static const uhtbl_vtable_t _uhtbl_c_table = {
 
 static ugeneric_kv_t *_oa_allocate_buckets(size_t count)
 {
-    ugeneric_kv_t *buckets = umalloc(count * sizeof(*buckets));
+    ugeneric_kv_t *buckets = umalloc_large(count * sizeof(*buckets));
     for (size_t i = 0; i < count; i++)
     {
         _SET_TO_EMPTY(buckets + i);
@@ -400,7 +400,8 @@ static void _resize(uhtbl_t *h)
                     _oa_put(&new_table, kv->k, kv->v);
                 }
             }
-            ufree(h->oa_buckets);
+            ufree_large(h->oa_buckets,
+                        h->number_of_buckets * sizeof(h->oa_buckets[0]));
             break;
         default:
             UABORT("internal error");
@@ -534,7 +535,8 @@ void uhtbl_destroy(uhtbl_t *h)
                 ufree(h->c_buckets);
                 break;
             case UHTBL_TYPE_OPEN_ADDRESSING:
-                ufree(h->oa_buckets);
+                ufree_large(h->oa_buckets,
+                            h->number_of_buckets * sizeof(h->oa_buckets[0]));
                 break;
             default:
                 UABORT("internal error");
@@ -747,6 +749,44 @@ bool uhtbl_is_empty(const uhtbl_t *h)
     return h->number_of_records == 0;
 }
 
+umemusage_t uhtbl_get_memory_usage(const uhtbl_t *h)
+{
+    UASSERT_INPUT(h);
+
+    umemusage_t u = {0};
+    switch (h->type)
+    {
+        case UHTBL_TYPE_CHAINING:
+            u.structure = sizeof(*h) +
+                          h->number_of_buckets * sizeof(h->c_buckets[0]) +
+                          h->number_of_records * sizeof(uhtbl_record_t);
+            break;
+        case UHTBL_TYPE_OPEN_ADDRESSING:
+            // Buckets which are either empty or tombstones are slack.
+            u.structure = sizeof(*h) +
+                          h->number_of_records * sizeof(h->oa_buckets[0]);
+            u.slack = (h->number_of_buckets - h->number_of_records) *
+                      sizeof(h->oa_buckets[0]);
+            break;
+        default:
+            UABORT("internal error");
+    }
+
+    if (h->is_data_owner)
+    {
+        uhtbl_iterator_t *hi = uhtbl_iterator_create(h);
+        while (uhtbl_iterator_has_next(hi))
+        {
+            ugeneric_kv_t kv = uhtbl_iterator_get_next(hi);
+            umemusage_add(&u, ugeneric_get_memory_usage(kv.k));
+            umemusage_add(&u, ugeneric_get_memory_usage(kv.v));
+        }
+        uhtbl_iterator_destroy(hi);
+    }
+
+    return u;
+}
+
 bool uhtbl_has_key(const uhtbl_t *h, ugeneric_t k)
 {
     UASSERT_INPUT(h);
@@ -34,6 +34,7 @@ bool uhtbl_remove(uhtbl_t *h, ugeneric_t k);
 bool uhtbl_has_key(const uhtbl_t *h, ugeneric_t k);
 size_t uhtbl_get_size(const uhtbl_t *h);
 bool uhtbl_is_empty(const uhtbl_t *h);
+umemusage_t uhtbl_get_memory_usage(const uhtbl_t *h);
 
 char *uhtbl_as_str(const uhtbl_t *h);
 void uhtbl_serialize(const uhtbl_t *h, ubuffer_t *buf);
@@ -0,0 +1,360 @@
+#include "iheap.h"
+
+#include "asserts.h"
+#include "mem.h"
+#include "string_utils.h"
+
+#define IHEAP_INITIAL_CAPACITY 16
+#define IHEAP_NO_POS SIZE_MAX // handle is not in the queue
+
+#define PARENT_IDX(i) (((i) - 1) / 2)
+#define LCHILD_IDX(i) (2 * (i) + 1)
+#define ROOT_IDX 0
+
+/*
+ * heap[0 .. size) holds handles in binary heap order, pos[handle] is the
+ * index of the handle in heap and priorities[handle] is its priority.
+ */
+
+struct uiheap_opaq {
+    uvoid_handlers_t void_handlers;
+    bool is_data_owner;
+    size_t *heap;
+    size_t size;
+    size_t *pos;
+    ugeneric_t *priorities;
+    size_t capacity;
+    uheap_type_t type;
+};
+
+uiheap_t *uiheap_create(void)
+{
+    return uiheap_create_ext(IHEAP_INITIAL_CAPACITY, UHEAP_TYPE_MIN);
+}
+
+uiheap_t *uiheap_create_ext(size_t capacity, uheap_type_t type)
+{
+    UASSERT_INPUT((type == UHEAP_TYPE_MIN) || (type == UHEAP_TYPE_MAX));
+
+    uiheap_t *h = umalloc(sizeof(*h));
+    memset(&h->void_handlers, 0, sizeof(h->void_handlers));
+    h->is_data_owner = true;
+    h->heap = NULL;
+    h->size = 0;
+    h->pos = NULL;
+    h->priorities = NULL;
+    h->capacity = 0;
+    h->type = type;
+    uiheap_reserve_capacity(h, capacity);
+
+    return h;
+}
+
+void uiheap_destroy(uiheap_t *h)
+{
+    if (h)
+    {
+        uiheap_clear(h);
+        ufree(h->heap);
+        ufree(h->pos);
+        ufree(h->priorities);
+        ufree(h);
+    }
+}
+
+void uiheap_clear(uiheap_t *h)
+{
+    UASSERT_INPUT(h);
+
+    for (size_t i = 0; i < h->size; i++)
+    {
+        size_t handle = h->heap[i];
+        if (h->is_data_owner)
+        {
+            ugeneric_destroy_v(h->priorities[handle], h->void_handlers.dtr);
+        }
+        h->pos[handle] = IHEAP_NO_POS;
+    }
+    h->size = 0;
+}
+
+void uiheap_reserve_capacity(uiheap_t *h, size_t new_capacity)
+{
+    UASSERT_INPUT(h);
+
+    if (h->capacity < new_capacity)
+    {
+        h->heap = urealloc(h->heap, new_capacity * sizeof(h->heap[0]));
+        h->pos = urealloc(h->pos, new_capacity * sizeof(h->pos[0]));
+        h->priorities = urealloc(h->priorities,
+                                 new_capacity * sizeof(h->priorities[0]));
+        for (size_t i = h->capacity; i < new_capacity; i++)
+        {
+            h->pos[i] = IHEAP_NO_POS;
+        }
+        h->capacity = new_capacity;
+    }
+}
+
+static inline bool _is_above(const uiheap_t *h, size_t handle1, size_t handle2)
+{
+    return h->type * ugeneric_compare_v(h->priorities[handle1],
+                                        h->priorities[handle2],
+                                        h->void_handlers.cmp) < 0;
+}
+
+static inline void _place(uiheap_t *h, size_t i, size_t handle)
+{
+    h->heap[i] = handle;
+    h->pos[handle] = i;
+}
+
+// Moves the handle at i up until its parent is not below it.
+static void _sift_up(uiheap_t *h, size_t i)
+{
+    size_t handle = h->heap[i];
+    while (i != ROOT_IDX)
+    {
+        size_t p = PARENT_IDX(i);
+        if (!_is_above(h, handle, h->heap[p]))
+        {
+            break;
+        }
+        _place(h, i, h->heap[p]);
+        i = p;
+    }
+    _place(h, i, handle);
+}
+
+// Moves the handle at i down until none of its children is above it.
+static void _sift_down(uiheap_t *h, size_t i)
+{
+    size_t handle = h->heap[i];
+    for (;;)
+    {
+        size_t c = LCHILD_IDX(i);
+        if (c >= h->size)
+        {
+            break;
+        }
+        if ((c + 1 < h->size) && _is_above(h, h->heap[c + 1], h->heap[c]))
+        {
+            c++;
+        }
+        if (!_is_above(h, h->heap[c], handle))
+        {
+            break;
+        }
+        _place(h, i, h->heap[c]);
+        i = c;
+    }
+    _place(h, i, handle);
+}
+
+void uiheap_push(uiheap_t *h, size_t handle, ugeneric_t priority)
+{
+    UASSERT_INPUT(h);
+    UASSERT_INPUT(handle != IHEAP_NO_POS);
+    UASSERT_INPUT(!uiheap_contains(h, handle));
+
+    if (handle >= h->capacity)
+    {
+        size_t new_capacity = MAX(2 * h->capacity, IHEAP_INITIAL_CAPACITY);
+        uiheap_reserve_capacity(h, MAX(new_capacity, handle + 1));
+    }
+
+    h->priorities[handle] = priority;
+    _place(h, h->size++, handle);
+    _sift_up(h, h->size - 1);
+}
+
+// Hands the priority over to the caller or destroys it.
+static void _release(uiheap_t *h, size_t handle, ugeneric_t *priority)
+{
+    if (priority)
+    {
+        *priority = h->priorities[handle];
+    }
+    else if (h->is_data_owner)
+    {
+        ugeneric_destroy_v(h->priorities[handle], h->void_handlers.dtr);
+    }
+}
+
+void uiheap_remove(uiheap_t *h, size_t handle, ugeneric_t *priority)
+{
+    UASSERT_INPUT(h);
+    UASSERT_INPUT(uiheap_contains(h, handle));
+
+    size_t i = h->pos[handle];
+    h->pos[handle] = IHEAP_NO_POS;
+    _release(h, handle, priority);
+
+    size_t last = h->heap[--h->size];
+    if (i < h->size)
+    {
+        // The last handle fills the hole and goes whichever way it has to.
+        _place(h, i, last);
+        _sift_up(h, i);
+        _sift_down(h, h->pos[last]);
+    }
+}
+
+size_t uiheap_pop(uiheap_t *h, ugeneric_t *priority)
+{
+    UASSERT_INPUT(h);
+    UASSERT_INPUT(h->size);
+
+    size_t handle = h->heap[ROOT_IDX];
+    uiheap_remove(h, handle, priority);
+
+    return handle;
+}
+
+size_t uiheap_peek(const uiheap_t *h, ugeneric_t *priority)
+{
+    UASSERT_INPUT(h);
+    UASSERT_INPUT(h->size);
+
+    size_t handle = h->heap[ROOT_IDX];
+    if (priority)
+    {
+        *priority = h->priorities[handle];
+    }
+
+    return handle;
+}
+
+bool uiheap_contains(const uiheap_t *h, size_t handle)
+{
+    UASSERT_INPUT(h);
+    return (handle < h->capacity) && (h->pos[handle] != IHEAP_NO_POS);
+}
+
+ugeneric_t uiheap_get_priority(const uiheap_t *h, size_t handle)
+{
+    UASSERT_INPUT(uiheap_contains(h, handle));
+    return h->priorities[handle];
+}
+
+void uiheap_update(uiheap_t *h, size_t handle, ugeneric_t priority)
+{
+    UASSERT_INPUT(uiheap_contains(h, handle));
+
+    // The same owned value may come back after it has been changed in place.
+    ugeneric_t old = h->priorities[handle];
+    bool is_same = (ugeneric_get_type(old) == ugeneric_get_type(priority)) &&
+                   (old.v.ptr == priority.v.ptr);
+    if (h->is_data_owner && !is_same)
+    {
+        ugeneric_destroy_v(old, h->void_handlers.dtr);
+    }
+    h->priorities[handle] = priority;
+    _sift_up(h, h->pos[handle]);
+    _sift_down(h, h->pos[handle]);
+}
+
+void uiheap_decrease_key(uiheap_t *h, size_t handle, ugeneric_t priority)
+{
+    UASSERT_INPUT(uiheap_contains(h, handle));
+    UASSERT_INPUT(ugeneric_compare_v(priority, h->priorities[handle],
+                                     h->void_handlers.cmp) <= 0);
+    uiheap_update(h, handle, priority);
+}
+
+void uiheap_increase_key(uiheap_t *h, size_t handle, ugeneric_t priority)
+{
+    UASSERT_INPUT(uiheap_contains(h, handle));
+    UASSERT_INPUT(ugeneric_compare_v(priority, h->priorities[handle],
+                                     h->void_handlers.cmp) >= 0);
+    uiheap_update(h, handle, priority);
+}
+
+size_t uiheap_get_size(const uiheap_t *h)
+{
+    UASSERT_INPUT(h);
+    return h->size;
+}
+
+bool uiheap_is_empty(const uiheap_t *h)
+{
+    UASSERT_INPUT(h);
+    return h->size == 0;
+}
+
+size_t uiheap_get_capacity(const uiheap_t *h)
+{
+    UASSERT_INPUT(h);
+    return h->capacity;
+}
+
+umemusage_t uiheap_get_memory_usage(const uiheap_t *h)
+{
+    UASSERT_INPUT(h);
+
+    // Every handle slot takes a heap cell, a position and a priority.
+    size_t slot = sizeof(h->heap[0]) + sizeof(h->pos[0]) +
+                  sizeof(h->priorities[0]);
+    umemusage_t u = {0};
+    u.structure = sizeof(*h) + h->size * slot;
+    u.slack = (h->capacity - h->size) * slot;
+    if (h->is_data_owner)
+    {
+        for (size_t i = 0; i < h->size; i++)
+        {
+            umemusage_add(&u, ugeneric_get_memory_usage(
+                                  h->priorities[h->heap[i]]));
+        }
+    }
+
+    return u;
+}
+
+void uiheap_serialize(const uiheap_t *h, ubuffer_t *buf)
+{
+    UASSERT_INPUT(h);
+    UASSERT_INPUT(buf);
+
+    ubuffer_append_byte(buf, '{');
+    for (size_t i = 0; i < h->size; i++)
+    {
+        size_t handle = h->heap[i];
+        ugeneric_serialize(G_SIZE(handle), buf);
+        ubuffer_append_data(buf, ": ", 2);
+        ugeneric_serialize_v(h->priorities[handle], buf, h->void_handlers.s8r);
+        if (i < h->size - 1)
+        {
+            ubuffer_append_data(buf, ", ", 2);
+        }
+    }
+    ubuffer_append_byte(buf, '}');
+}
+
+char *uiheap_as_str(const uiheap_t *h)
+{
+    UASSERT_INPUT(h);
+
+    ubuffer_t buf = {0};
+    uiheap_serialize(h, &buf);
+    ubuffer_null_terminate(&buf);
+
+    return buf.data;
+}
+
+int uiheap_fprint(const uiheap_t *h, FILE *out)
+{
+    UASSERT_INPUT(h);
+    UASSERT_INPUT(out);
+
+    char *str = uiheap_as_str(h);
+    int ret = fprintf(out, "%s\n", str);
+    ufree(str);
+
+    return ret;
+}
+
+ugeneric_base_t *uiheap_get_base(uiheap_t *h)
+{
+    UASSERT_INPUT(h);
+    return (ugeneric_base_t *)h;
+}
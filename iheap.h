@@ -0,0 +1,66 @@
+#ifndef UIHEAP_H__
+#define UIHEAP_H__
+
+#include "generic.h"
+#include "heap.h"
+
+/*
+ * Indexed priority queue: every element is a handle, a small integer
+ * chosen by the caller (a graph node, a task id), with a priority ordered
+ * like uheap orders its elements. The position of every handle in the
+ * heap is tracked, so priorities change and handles leave the queue in
+ * O(log n) without duplicate entries. Tables indexed by handles grow to
+ * the largest handle pushed, pushing never allocates below that.
+ *
+ * Priorities popped, removed or replaced are destroyed if the queue owns
+ * data, unless they are handed over to the caller. Updating a handle with
+ * its current priority (e.g. a string changed in place) keeps it.
+ */
+
+typedef struct uiheap_opaq uiheap_t;
+
+uiheap_t *uiheap_create(void);
+/* Queue with tables for handles [0, capacity) allocated upfront. */
+uiheap_t *uiheap_create_ext(size_t capacity, uheap_type_t type);
+void uiheap_destroy(uiheap_t *h);
+void uiheap_clear(uiheap_t *h);
+
+/* Handle must not be in the queue already. */
+void uiheap_push(uiheap_t *h, size_t handle, ugeneric_t priority);
+/* Take the handle on top, its priority is stored to priority if it is not
+ * NULL (and then it is not destroyed).
+ */
+size_t uiheap_pop(uiheap_t *h, ugeneric_t *priority);
+size_t uiheap_peek(const uiheap_t *h, ugeneric_t *priority);
+void uiheap_remove(uiheap_t *h, size_t handle, ugeneric_t *priority);
+bool uiheap_contains(const uiheap_t *h, size_t handle);
+ugeneric_t uiheap_get_priority(const uiheap_t *h, size_t handle);
+
+/* Change the priority of the handle in the queue. decrease/increase are
+ * about the priority order itself (not the heap type) and check that the
+ * new priority is not greater/less than the current one.
+ */
+void uiheap_update(uiheap_t *h, size_t handle, ugeneric_t priority);
+void uiheap_decrease_key(uiheap_t *h, size_t handle, ugeneric_t priority);
+void uiheap_increase_key(uiheap_t *h, size_t handle, ugeneric_t priority);
+
+size_t uiheap_get_size(const uiheap_t *h);
+bool uiheap_is_empty(const uiheap_t *h);
+size_t uiheap_get_capacity(const uiheap_t *h);
+void uiheap_reserve_capacity(uiheap_t *h, size_t new_capacity);
+umemusage_t uiheap_get_memory_usage(const uiheap_t *h);
+
+/* Serialized in heap order as {handle: priority, ...}. */
+char *uiheap_as_str(const uiheap_t *h);
+void uiheap_serialize(const uiheap_t *h, ubuffer_t *buf);
+int uiheap_fprint(const uiheap_t *h, FILE *out);
+static inline int uiheap_print(const uiheap_t *h) {return uiheap_fprint(h, stdout);}
+
+static void uiheap_take_data_ownership(uiheap_t *h);
+static void uiheap_drop_data_ownership(uiheap_t *h);
+static bool uiheap_is_data_owner(uiheap_t *h);
+
+ugeneric_base_t *uiheap_get_base(uiheap_t *h);
+DEFINE_BASE_FUNCS(uiheap)
+
+#endif
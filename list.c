@@ -1,66 +1,516 @@
 #include "list.h"
 #include "mem.h"
-
-/* head->[e{0}]->[e{1}]-> ... >[e{size-2}]->[e{size-1}]->NULL  */
-
-typedef struct ulist_item {
-    ugeneric_t data;
-    struct ulist_item *next;
-} ulist_item_t;
+#include "sort.h"
+
+#include <limits.h>
+
+/*
+ * Unrolled list: every node holds up to node_capacity elements in a row.
+ *
+ * NULL<-[e{0} ... e{k-1}]<->[e{k} ... ]<-> ... <->[ ... e{size-1}]->NULL
+ *        ^head                                     ^tail
+ *
+ * Nodes are never empty. The first node of a list starts with room for
+ * ULIST_INITIAL_NODE_CAPACITY elements and grows up to node_capacity, so
+ * short lists stay small. node_capacity of 1 gives the classic one element
+ * per node list.
+ *
+ * finger caches the node of the last positional access (and of the last
+ * modification) with the index of its first element, so index based loops
+ * walk a node or two per access instead of the whole list. Every
+ * modification either repoints the finger to a valid node or resets it.
+ */
+
+typedef struct ulist_node {
+    struct ulist_node *prev;
+    struct ulist_node *next;
+    size_t count;
+    size_t capacity;
+    ugeneric_t cells[];
+} ulist_node_t;
 
 struct ulist_opaq {
     uvoid_handlers_t void_handlers;
     bool is_data_owner;
     size_t size;
-    ulist_item_t *head;
+    size_t node_capacity;
+    ulist_node_t *head;
+    ulist_node_t *tail;
+    ulist_node_t *finger;
+    size_t finger_start;
 };
 
 struct ulist_iterator_opaq {
     const ulist_t *list;
-    ulist_item_t *next;
+    ulist_node_t *node;
+    size_t offset;
 };
 
-static inline ulist_item_t **_rewind_to(ulist_t *l, size_t i)
+static ulist_node_t *_node_create(size_t capacity)
+{
+    ulist_node_t *n = umalloc(sizeof(*n) + capacity * sizeof(n->cells[0]));
+    n->prev = NULL;
+    n->next = NULL;
+    n->count = 0;
+    n->capacity = capacity;
+
+    return n;
+}
+
+// Links n after prev, or makes it the head if prev is NULL.
+static void _link_after(ulist_t *l, ulist_node_t *prev, ulist_node_t *n)
 {
-    ulist_item_t **t = &l->head;
-    while (i--)
+    n->prev = prev;
+    n->next = prev ? prev->next : l->head;
+    if (n->next)
+    {
+        n->next->prev = n;
+    }
+    else
+    {
+        l->tail = n;
+    }
+    if (prev)
     {
-        t = &(*t)->next;
+        prev->next = n;
     }
+    else
+    {
+        l->head = n;
+    }
+}
 
-    return t;
+static void _unlink(ulist_t *l, ulist_node_t *n)
+{
+    if (n->prev)
+    {
+        n->prev->next = n->next;
+    }
+    else
+    {
+        l->head = n->next;
+    }
+    if (n->next)
+    {
+        n->next->prev = n->prev;
+    }
+    else
+    {
+        l->tail = n->prev;
+    }
+    ufree(n);
 }
 
-static ulist_t *_lcpy(const ulist_t *l, bool deep)
+// Reallocates node to the new capacity and fixes links pointing to it.
+static ulist_node_t *_node_resize(ulist_t *l, ulist_node_t *n, size_t capacity)
 {
-    UASSERT_INPUT(l);
+    n = urealloc(n, sizeof(*n) + capacity * sizeof(n->cells[0]));
+    n->capacity = capacity;
+    if (n->prev)
+    {
+        n->prev->next = n;
+    }
+    else
+    {
+        l->head = n;
+    }
+    if (n->next)
+    {
+        n->next->prev = n;
+    }
+    else
+    {
+        l->tail = n;
+    }
 
-    ulist_t *copy = ulist_create();
-    memcpy(copy, l, sizeof(*l));
-    ulist_item_t *from = l->head;
-    ulist_item_t **to = &copy->head;
+    return n;
+}
 
-    copy->is_data_owner = deep;
-    if (deep)
+static inline void _set_finger(ulist_t *l, ulist_node_t *n, size_t start)
+{
+    l->finger = n;
+    l->finger_start = start;
+}
+
+// Index of the first element of n, which is either the head, the tail or
+// the finger.
+static size_t _get_start(const ulist_t *l, const ulist_node_t *n)
+{
+    if (n == l->finger)
+    {
+        return l->finger_start;
+    }
+    else if (n == l->head)
+    {
+        return 0;
+    }
+
+    UASSERT_INTERNAL(n == l->tail);
+    return l->size - n->count;
+}
+
+static inline size_t _distance(size_t a, size_t b)
+{
+    return (a > b) ? a - b : b - a;
+}
+
+/*
+ * Finds the node holding element i and its offset in the node walking from
+ * the closest of the head, the tail and the finger, moves finger there.
+ */
+static ulist_node_t *_locate(const ulist_t *l, size_t i, size_t *offset)
+{
+    ulist_node_t *n = l->head;
+    size_t start = 0;
+
+    if (l->size - i < i)
+    {
+        n = l->tail;
+        start = l->size - n->count;
+    }
+    if (l->finger && (_distance(l->finger_start, i) < _distance(start, i)))
+    {
+        n = l->finger;
+        start = l->finger_start;
+    }
+
+    while (i >= start + n->count)
+    {
+        start += n->count;
+        n = n->next;
+    }
+    while (i < start)
+    {
+        n = n->prev;
+        start -= n->count;
+    }
+
+    // Finger is a cache, moving it does not change the list.
+    _set_finger((ulist_t *)l, n, start);
+    *offset = i - start;
+
+    return n;
+}
+
+static void _put(ulist_node_t *n, size_t offset, ugeneric_t e)
+{
+    memmove(&n->cells[offset + 1], &n->cells[offset],
+            (n->count - offset) * sizeof(n->cells[0]));
+    n->cells[offset] = e;
+    n->count++;
+}
+
+/*
+ * Puts e at the offset of the node (offset == count means after the last
+ * element), spilling to neighbours or splitting the node if it is full.
+ */
+static void _insert(ulist_t *l, ulist_node_t *n, size_t offset, ugeneric_t e)
+{
+    size_t start = n ? _get_start(l, n) : 0;
+    l->size++;
+
+    if (!n)
     {
-        while (from)
+        n = _node_create(MIN(ULIST_INITIAL_NODE_CAPACITY, l->node_capacity));
+        _link_after(l, NULL, n);
+    }
+
+    if (n->count == n->capacity && n->capacity < l->node_capacity)
+    {
+        n = _node_resize(l, n, MIN(2 * n->capacity, l->node_capacity));
+    }
+
+    if (n->count < n->capacity)
+    {
+        _put(n, offset, e);
+    }
+    else if (offset == 0 && n->prev && n->prev->count < n->prev->capacity)
+    {
+        _put(n->prev, n->prev->count, e);
+        start++;
+    }
+    else if (offset == n->count)
+    {
+        if (n->next && n->next->count < n->next->capacity)
         {
-            *to = umalloc(sizeof(**to));
-            (*to)->data = ugeneric_copy_v(from->data, l->void_handlers.cpy);
-            (*to)->next = NULL;
-            to = &(*to)->next;
-            from = from->next;
+            _put(n->next, 0, e);
+        }
+        else
+        {
+            ulist_node_t *t = _node_create(l->node_capacity);
+            _link_after(l, n, t);
+            _put(t, 0, e);
         }
     }
     else
     {
-        while (from)
+        // Move the upper half to a new node, n may come from another list
+        // with bigger nodes.
+        ulist_node_t *t = _node_create(MAX(l->node_capacity, n->capacity));
+        size_t keep = n->count / 2;
+        t->count = n->count - keep;
+        memcpy(t->cells, &n->cells[keep], t->count * sizeof(t->cells[0]));
+        n->count = keep;
+        _link_after(l, n, t);
+        if (offset <= keep)
+        {
+            _put(n, offset, e);
+        }
+        else
+        {
+            _put(t, offset - keep, e);
+        }
+    }
+
+    // Elements were added to n or after it, except the case handled above.
+    _set_finger(l, n, start);
+}
+
+// Moves elements of the node after left into left once both are half empty.
+static bool _try_merge(ulist_t *l, ulist_node_t *left)
+{
+    ulist_node_t *right = left->next;
+    if (!right || (left->count + right->count > l->node_capacity / 2) ||
+        (left->count + right->count > left->capacity))
+    {
+        return false;
+    }
+
+    memcpy(&left->cells[left->count], right->cells,
+           right->count * sizeof(right->cells[0]));
+    left->count += right->count;
+    if (l->finger == right)
+    {
+        l->finger = NULL;
+    }
+    _unlink(l, right);
+
+    return true;
+}
+
+/*
+ * Takes element at the offset out of the node, drops the node once it gets
+ * empty and merges it with a neighbour once both are half empty.
+ */
+static ugeneric_t _take(ulist_t *l, ulist_node_t *n, size_t offset)
+{
+    size_t start = _get_start(l, n);
+    ugeneric_t e = n->cells[offset];
+    n->count--;
+    memmove(&n->cells[offset], &n->cells[offset + 1],
+            (n->count - offset) * sizeof(n->cells[0]));
+    l->size--;
+
+    if (n->count == 0)
+    {
+        _set_finger(l, n->next, start);
+        _unlink(l, n);
+        return e;
+    }
+
+    _set_finger(l, n, start);
+    if (!_try_merge(l, n) && n->prev)
+    {
+        ulist_node_t *prev = n->prev;
+        size_t prev_start = start - prev->count;
+        if (_try_merge(l, prev))
         {
-            *to = umalloc(sizeof(**to));
-            (*to)->data = from->data;
-            (*to)->next = NULL;
-            to = &(*to)->next;
-            from = from->next;
+            _set_finger(l, prev, prev_start);
+        }
+    }
+
+    return e;
+}
+
+/*
+ * Makes element i the first one of its node splitting the node if needed,
+ * returns the node or NULL if i == size.
+ */
+static ulist_node_t *_split(ulist_t *l, size_t i)
+{
+    if (i == l->size)
+    {
+        return NULL;
+    }
+
+    size_t offset;
+    ulist_node_t *n = _locate(l, i, &offset);
+    if (offset == 0)
+    {
+        return n;
+    }
+
+    size_t count = n->count - offset;
+    ulist_node_t *t = _node_create(MAX(l->node_capacity, count));
+    memcpy(t->cells, &n->cells[offset], count * sizeof(t->cells[0]));
+    t->count = count;
+    n->count = offset;
+    _link_after(l, n, t);
+    _set_finger(l, t, i);
+
+    return t;
+}
+
+// Unlinks nodes first..last holding count elements, keeping them linked.
+static void _detach(ulist_t *l, ulist_node_t *first, ulist_node_t *last,
+                    size_t count)
+{
+    if (first->prev)
+    {
+        first->prev->next = last->next;
+    }
+    else
+    {
+        l->head = last->next;
+    }
+    if (last->next)
+    {
+        last->next->prev = first->prev;
+    }
+    else
+    {
+        l->tail = first->prev;
+    }
+    first->prev = NULL;
+    last->next = NULL;
+    l->size -= count;
+    l->finger = NULL;
+}
+
+// Links nodes first..last holding count elements before at (NULL: append).
+static void _attach(ulist_t *l, ulist_node_t *at, ulist_node_t *first,
+                    ulist_node_t *last, size_t count)
+{
+    ulist_node_t *prev = at ? at->prev : l->tail;
+    first->prev = prev;
+    last->next = at;
+    if (prev)
+    {
+        prev->next = first;
+    }
+    else
+    {
+        l->head = first;
+    }
+    if (at)
+    {
+        at->prev = last;
+    }
+    else
+    {
+        l->tail = last;
+    }
+    l->size += count;
+    l->finger = NULL;
+}
+
+// Sorted runs of nodes linked by next only, prev links are fixed at the end.
+typedef struct {
+    ulist_node_t *head;
+    ulist_node_t *tail;
+} _run_t;
+
+/*
+ * Stable merge of run a followed by run b. Elements are moved to the nodes
+ * already consumed by the merge (kept in spare), a new node is allocated
+ * only if there is none. With one element per node this is pure relinking.
+ */
+static _run_t _merge_runs(_run_t a, _run_t b, ulist_node_t **spare,
+                          size_t node_capacity, void_cmp_t cmp)
+{
+    if (ugeneric_compare_v(a.tail->cells[a.tail->count - 1], b.head->cells[0],
+                           cmp) <= 0)
+    {
+        a.tail->next = b.head;
+        a.tail = b.tail;
+        return a;
+    }
+
+    _run_t out = {NULL, NULL};
+    ulist_node_t *an = a.head;
+    ulist_node_t *bn = b.head;
+    size_t ai = 0;
+    size_t bi = 0;
+
+    while (an || bn)
+    {
+        ugeneric_t e;
+        ulist_node_t *consumed = NULL;
+
+        if (an && (!bn || ugeneric_compare_v(an->cells[ai], bn->cells[bi],
+                                             cmp) <= 0))
+        {
+            e = an->cells[ai];
+            if (++ai == an->count)
+            {
+                consumed = an;
+                an = an->next;
+                ai = 0;
+            }
+        }
+        else
+        {
+            e = bn->cells[bi];
+            if (++bi == bn->count)
+            {
+                consumed = bn;
+                bn = bn->next;
+                bi = 0;
+            }
+        }
+
+        if (consumed)
+        {
+            consumed->next = *spare;
+            *spare = consumed;
+        }
+
+        if (!out.tail || (out.tail->count == out.tail->capacity))
+        {
+            ulist_node_t *n = *spare;
+            if (n)
+            {
+                *spare = n->next;
+            }
+            else
+            {
+                n = _node_create(node_capacity);
+            }
+            n->count = 0;
+            n->next = NULL;
+            if (out.tail)
+            {
+                out.tail->next = n;
+            }
+            else
+            {
+                out.head = n;
+            }
+            out.tail = n;
+        }
+        out.tail->cells[out.tail->count++] = e;
+    }
+
+    return out;
+}
+
+static ulist_t *_lcpy(const ulist_t *l, bool deep)
+{
+    UASSERT_INPUT(l);
+
+    ulist_t *copy = ulist_create_ext(l->node_capacity);
+    copy->void_handlers = l->void_handlers;
+    copy->is_data_owner = deep;
+    for (ulist_node_t *n = l->head; n; n = n->next)
+    {
+        for (size_t i = 0; i < n->count; i++)
+        {
+            ugeneric_t e = n->cells[i];
+            if (deep)
+            {
+                e = ugeneric_copy_v(e, l->void_handlers.cpy);
+            }
+            _insert(copy, copy->tail, copy->tail ? copy->tail->count : 0, e);
         }
     }
 
@@ -69,37 +519,43 @@ static ulist_t *_lcpy(const ulist_t *l, bool deep)
 
 ulist_t *ulist_create(void)
 {
+    return ulist_create_ext(ULIST_DEFAULT_NODE_CAPACITY);
+}
+
+ulist_t *ulist_create_ext(size_t node_capacity)
+{
+    UASSERT_INPUT(node_capacity);
+
     ulist_t *l = umalloc(sizeof(*l));
 
     l->size = 0;
+    l->node_capacity = node_capacity;
     l->is_data_owner = true;
     l->head = NULL;
+    l->tail = NULL;
+    l->finger = NULL;
+    l->finger_start = 0;
     memset(&l->void_handlers, 0, sizeof(l->void_handlers));
 
     return l;
 }
 
-void ulist_append(ulist_t *l, ugeneric_t e)
+size_t ulist_get_node_capacity(const ulist_t *l)
 {
     UASSERT_INPUT(l);
-    ulist_item_t *li = umalloc(sizeof(*li));
-
-    li->data = e;
-    li->next = NULL;
+    return l->node_capacity;
+}
 
-    *_rewind_to(l, l->size) = li;
-    l->size++;
+void ulist_append(ulist_t *l, ugeneric_t e)
+{
+    UASSERT_INPUT(l);
+    _insert(l, l->tail, l->tail ? l->tail->count : 0, e);
 }
 
 void ulist_prepend(ulist_t *l, ugeneric_t e)
 {
     UASSERT_INPUT(l);
-    ulist_item_t *li = umalloc(sizeof(*li));
-
-    li->next = l->head;
-    li->data = e;
-    l->head = li;
-    l->size++;
+    _insert(l, l->head, 0, e);
 }
 
 ugeneric_t ulist_pop_back(ulist_t *l)
@@ -107,13 +563,7 @@ ugeneric_t ulist_pop_back(ulist_t *l)
     UASSERT_INPUT(l);
     UASSERT_INPUT(l->size);
 
-    ulist_item_t **t = _rewind_to(l, l->size - 1);
-    ugeneric_t e = (*t)->data;
-    ufree(*t);
-    *t = NULL;
-    l->size--;
-
-    return e;
+    return _take(l, l->tail, l->tail->count - 1);
 }
 
 ugeneric_t ulist_pop_front(ulist_t *l)
@@ -121,31 +571,13 @@ ugeneric_t ulist_pop_front(ulist_t *l)
     UASSERT_INPUT(l);
     UASSERT_INPUT(l->size);
 
-    ulist_item_t *li = l->head;
-    ugeneric_t e = li->data;
-    l->head = li->next;
-    ufree(li);
-    l->size--;
-
-    return e;
+    return _take(l, l->head, 0);
 }
 
 void ulist_destroy(ulist_t *l)
 {
     if (l)
     {
-        ulist_item_t *li = l->head;
-        ugeneric_t g;
-
-        if (l->is_data_owner)
-        {
-            while (li)
-            {
-                g = li->data;
-                ugeneric_destroy_v(g, l->void_handlers.dtr);
-                li = li->next;
-            }
-        }
         ulist_clear(l);
         ufree(l);
     }
@@ -155,16 +587,24 @@ void ulist_clear(ulist_t *l)
 {
     UASSERT_INPUT(l);
 
-    ulist_item_t *li = l->head;
-    ulist_item_t *t;
-
-    while (li)
+    ulist_node_t *n = l->head;
+    while (n)
     {
-        t = li;
-        li = li->next;
+        ulist_node_t *t = n;
+        n = n->next;
+        if (l->is_data_owner)
+        {
+            for (size_t i = 0; i < t->count; i++)
+            {
+                ugeneric_destroy_v(t->cells[i], l->void_handlers.dtr);
+            }
+        }
         ufree(t);
     }
     l->head = NULL;
+    l->tail = NULL;
+    l->finger = NULL;
+    l->size = 0;
 }
 
 bool ulist_is_empty(const ulist_t *l)
@@ -179,14 +619,37 @@ size_t ulist_get_size(const ulist_t *l)
     return l->size;
 }
 
+umemusage_t ulist_get_memory_usage(const ulist_t *l)
+{
+    UASSERT_INPUT(l);
+
+    umemusage_t u = {0};
+    u.structure = sizeof(*l);
+    for (ulist_node_t *n = l->head; n; n = n->next)
+    {
+        u.structure += sizeof(*n) + n->count * sizeof(n->cells[0]);
+        u.slack += (n->capacity - n->count) * sizeof(n->cells[0]);
+        if (l->is_data_owner)
+        {
+            for (size_t i = 0; i < n->count; i++)
+            {
+                umemusage_add(&u, ugeneric_get_memory_usage(n->cells[i]));
+            }
+        }
+    }
+
+    return u;
+}
+
 ugeneric_t ulist_get_at(const ulist_t *l, size_t i)
 {
     UASSERT_INPUT(l);
     UASSERT_INPUT(i < l->size);
 
-    ulist_item_t **t = _rewind_to((ulist_t *)l, i);
+    size_t offset;
+    ulist_node_t *n = _locate(l, i, &offset);
 
-    return (*t)->data;
+    return n->cells[offset];
 }
 
 void ulist_set_at(ulist_t *l, size_t i, ugeneric_t e)
@@ -194,23 +657,30 @@ void ulist_set_at(ulist_t *l, size_t i, ugeneric_t e)
     UASSERT_INPUT(l);
     UASSERT_INPUT(i < l->size);
 
-    ulist_item_t **t = _rewind_to(l, i);
-    (*t)->data = e;
+    size_t offset;
+    ulist_node_t *n = _locate(l, i, &offset);
+    if (l->is_data_owner)
+    {
+        ugeneric_destroy_v(n->cells[offset], l->void_handlers.dtr);
+    }
+    n->cells[offset] = e;
 }
 
 void ulist_insert_at(ulist_t *l, size_t i, ugeneric_t e)
 {
     UASSERT_INPUT(l);
-    UASSERT_INPUT(i < l->size);
-
-    ulist_item_t *li = umalloc(sizeof(*li));
-    li->data = e;
+    UASSERT_INPUT(i <= l->size);
 
-    ulist_item_t **t = _rewind_to(l, i);
-
-    li->next = *t;
-    *t = li;
-    l->size++;
+    if (i == l->size)
+    {
+        ulist_append(l, e);
+    }
+    else
+    {
+        size_t offset;
+        ulist_node_t *n = _locate(l, i, &offset);
+        _insert(l, n, offset, e);
+    }
 }
 
 void ulist_remove_at(ulist_t *l, size_t i)
@@ -218,36 +688,31 @@ void ulist_remove_at(ulist_t *l, size_t i)
     UASSERT_INPUT(l);
     UASSERT_INPUT(i < l->size);
 
-    ulist_item_t **t = _rewind_to(l, i);
-    ulist_item_t *f = *t;
-
-    *t = (*t)->next;
-    ufree(f);
-
-    l->size--;
+    size_t offset;
+    ulist_node_t *n = _locate(l, i, &offset);
+    ugeneric_t e = _take(l, n, offset);
+    if (l->is_data_owner)
+    {
+        ugeneric_destroy_v(e, l->void_handlers.dtr);
+    }
 }
 
 ugeneric_t *ulist_find(ulist_t *l, ugeneric_t e)
 {
     UASSERT_INPUT(l);
 
-    ulist_item_t *li = l->head;
-    ulist_item_t *t;
-
-    ugeneric_t *g = NULL;
-
-    while (li)
+    for (ulist_node_t *n = l->head; n; n = n->next)
     {
-        t = li;
-        li = li->next;
-        if (ugeneric_compare_v(t->data, e, l->void_handlers.cmp) == 0)
+        for (size_t i = 0; i < n->count; i++)
         {
-            g = &t->data;
-            break;
+            if (ugeneric_compare_v(n->cells[i], e, l->void_handlers.cmp) == 0)
+            {
+                return &n->cells[i];
+            }
         }
     }
 
-    return g;
+    return NULL;
 }
 
 bool ulist_contains(const ulist_t *l, ugeneric_t e)
@@ -258,12 +723,139 @@ bool ulist_contains(const ulist_t *l, ugeneric_t e)
 void ulist_reverse(ulist_t *l)
 {
     UASSERT_INPUT(l);
-    UABORT("not implemented");
-    ulist_item_t *li = l->head;
 
-    while (li)
+    ulist_node_t *n = l->head;
+    while (n)
+    {
+        ulist_node_t *next = n->next;
+        n->next = n->prev;
+        n->prev = next;
+        ugeneric_array_reverse(n->cells, n->count, 0, n->count - 1);
+        n = next;
+    }
+
+    n = l->head;
+    l->head = l->tail;
+    l->tail = n;
+    l->finger = NULL;
+}
+
+void ulist_splice(ulist_t *dst, size_t i, ulist_t *src, size_t begin,
+                  size_t end)
+{
+    UASSERT_INPUT(dst);
+    UASSERT_INPUT(src);
+    UASSERT_INPUT(begin <= end);
+    UASSERT_INPUT(end <= src->size);
+    UASSERT_INPUT(i <= dst->size);
+    UASSERT_INPUT((dst != src) || (i <= begin) || (i >= end));
+
+    if (begin == end)
+    {
+        return;
+    }
+
+    size_t count = end - begin;
+    ulist_node_t *after = _split(src, end);
+    ulist_node_t *first = _split(src, begin);
+    ulist_node_t *last = after ? after->prev : src->tail;
+    ulist_node_t *before = first->prev;
+
+    _detach(src, first, last, count);
+    if (before)
+    {
+        _try_merge(src, before);
+    }
+
+    if ((dst == src) && (i >= end))
+    {
+        i -= count;
+    }
+    _attach(dst, _split(dst, i), first, last, count);
+
+    // Boundary nodes may be left half empty by the splits.
+    _try_merge(dst, last);
+    if (first->prev)
+    {
+        _try_merge(dst, first->prev);
+    }
+}
+
+void ulist_concat(ulist_t *dst, ulist_t *src)
+{
+    UASSERT_INPUT(dst);
+    UASSERT_INPUT(src);
+    UASSERT_INPUT(dst != src);
+
+    ulist_splice(dst, dst->size, src, 0, src->size);
+}
+
+void ulist_sort(ulist_t *l)
+{
+    UASSERT_INPUT(l);
+
+    if (l->size < 2)
+    {
+        return;
+    }
+
+    /*
+     * Bottom-up merge sort: every node sorted in place is a run, runs[i]
+     * holds a run made of 2^i of them and merging works as a binary counter
+     * increment, so runs of similar length are merged.
+     */
+    _run_t runs[sizeof(size_t) * CHAR_BIT] = {{NULL, NULL}};
+    size_t nruns = 0;
+    ulist_node_t *spare = NULL;
+    void_cmp_t cmp = l->void_handlers.cmp;
+
+    ulist_node_t *n = l->head;
+    while (n)
+    {
+        ulist_node_t *next = n->next;
+        n->next = NULL;
+        insertion_sort(n->cells, n->count, cmp);
+
+        _run_t carry = {n, n};
+        size_t i = 0;
+        for (; runs[i].head; i++)
+        {
+            carry = _merge_runs(runs[i], carry, &spare, l->node_capacity, cmp);
+            runs[i].head = NULL;
+        }
+        runs[i] = carry;
+        nruns = MAX(nruns, i + 1);
+        n = next;
+    }
+
+    // Higher runs hold earlier elements.
+    _run_t result = {NULL, NULL};
+    for (size_t i = 0; i < nruns; i++)
+    {
+        if (runs[i].head)
+        {
+            result = result.head ? _merge_runs(runs[i], result, &spare,
+                                               l->node_capacity, cmp)
+                                 : runs[i];
+        }
+    }
+
+    while (spare)
     {
+        n = spare;
+        spare = spare->next;
+        ufree(n);
     }
+
+    ulist_node_t *prev = NULL;
+    for (n = result.head; n; n = n->next)
+    {
+        n->prev = prev;
+        prev = n;
+    }
+    l->head = result.head;
+    l->tail = prev;
+    l->finger = NULL;
 }
 
 int ulist_compare(const ulist_t *l1, const ulist_t *l2, void_cmp_t cmp)
@@ -271,20 +863,27 @@ int ulist_compare(const ulist_t *l1, const ulist_t *l2, void_cmp_t cmp)
     UASSERT_INPUT(l1);
     UASSERT_INPUT(l2);
 
-    ulist_item_t *l = l1->head;
-    ulist_item_t *r = l2->head;
+    ulist_node_t *l = l1->head;
+    ulist_node_t *r = l2->head;
+    size_t li = 0;
+    size_t ri = 0;
 
     while (l && r)
     {
-        int diff = ugeneric_compare_v(l->data, r->data, cmp);
-        if (diff == 0)
+        int diff = ugeneric_compare_v(l->cells[li], r->cells[ri], cmp);
+        if (diff)
+        {
+            return diff;
+        }
+        if (++li == l->count)
         {
             l = l->next;
-            r = r->next;
+            li = 0;
         }
-        else
+        if (++ri == r->count)
         {
-            return diff;
+            r = r->next;
+            ri = 0;
         }
     }
     return l1->size - l2->size;
@@ -317,16 +916,16 @@ void ulist_serialize(const ulist_t *l, ubuffer_t *buf)
     UASSERT_INPUT(l);
     UASSERT_INPUT(buf);
 
-    size_t i = 0;
-    ulist_item_t *li = l->head;
     ubuffer_append_byte(buf, '[');
-    while (li)
+    for (ulist_node_t *n = l->head; n; n = n->next)
     {
-        ugeneric_serialize_v(li->data, buf, l->void_handlers.s8r);
-        li = li->next;
-        if (i++ < l->size - 1)
+        for (size_t i = 0; i < n->count; i++)
         {
-            ubuffer_append_data(buf, ", ", 2);
+            ugeneric_serialize_v(n->cells[i], buf, l->void_handlers.s8r);
+            if (n->next || (i < n->count - 1))
+            {
+                ubuffer_append_data(buf, ", ", 2);
+            }
         }
     }
     ubuffer_append_byte(buf, ']');
@@ -349,7 +948,8 @@ ulist_iterator_t *ulist_iterator_create(const ulist_t *l)
     ulist_iterator_t *li = umalloc(sizeof(*li));
 
     li->list = l;
-    li->next = l->head;
+    li->node = l->head;
+    li->offset = 0;
 
     return li;
 }
@@ -358,17 +958,21 @@ ugeneric_t ulist_iterator_get_next(ulist_iterator_t *li)
 {
     UASSERT_INPUT(li);
     UASSERT_MSG(li->list->size, "container is empty");
-    UASSERT_MSG(li->next, "iteration is done");
+    UASSERT_MSG(li->node, "iteration is done");
 
-    ugeneric_t g = li->next->data;
-    li->next = li->next->next;
+    ugeneric_t g = li->node->cells[li->offset++];
+    if (li->offset == li->node->count)
+    {
+        li->node = li->node->next;
+        li->offset = 0;
+    }
 
     return g;
 }
 
 bool ulist_iterator_has_next(const ulist_iterator_t *li)
 {
-    return li->next;
+    return li->node;
 }
 
 void ulist_iterator_destroy(ulist_iterator_t *li)
@@ -381,7 +985,8 @@ void ulist_iterator_destroy(ulist_iterator_t *li)
 
 void ulist_iterator_reset(ulist_iterator_t *li)
 {
-    li->next = li->list->head;
+    li->node = li->list->head;
+    li->offset = 0;
 }
 
 ugeneric_base_t *ulist_get_base(ulist_t *l)
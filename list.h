@@ -3,10 +3,25 @@
 
 #include "generic.h"
 
+/* Maximum number of elements a list node holds by default. */
+#ifndef ULIST_DEFAULT_NODE_CAPACITY
+#define ULIST_DEFAULT_NODE_CAPACITY 32
+#endif
+
+/* Capacity the first node of a list is allocated with. */
+#ifndef ULIST_INITIAL_NODE_CAPACITY
+#define ULIST_INITIAL_NODE_CAPACITY 4
+#endif
+
 typedef struct ulist_opaq ulist_t;
 typedef struct ulist_iterator_opaq ulist_iterator_t;
 
 ulist_t *ulist_create(void);
+/* List with up to node_capacity elements per node, 1 makes a classic linked
+ * list with a node per element.
+ */
+ulist_t *ulist_create_ext(size_t node_capacity);
+size_t ulist_get_node_capacity(const ulist_t *l);
 void ulist_destroy(ulist_t *l);
 void ulist_append(ulist_t *l, ugeneric_t e);
 void ulist_prepend(ulist_t *l, ugeneric_t e);
@@ -15,13 +30,38 @@ ugeneric_t ulist_pop_front(ulist_t *l);
 void ulist_clear(ulist_t *l);
 bool ulist_is_empty(const ulist_t *l);
 size_t ulist_get_size(const ulist_t *l);
+umemusage_t ulist_get_memory_usage(const ulist_t *l);
+/* Positional access starts from the node of the previous one (or from the
+ * closest end), so index based loops take amortized O(1) per access. The
+ * cache makes even const access modify the list, concurrent readers must
+ * not use positional functions.
+ */
 ugeneric_t ulist_get_at(const ulist_t *l, size_t i);
 void ulist_set_at(ulist_t *l, size_t i, ugeneric_t e);
 void ulist_insert_at(ulist_t *l, size_t i, ugeneric_t e);
 void ulist_remove_at(ulist_t *l, size_t i);
 bool ulist_contains(const ulist_t *l, ugeneric_t e);
+/* Returned pointer is valid until the list is modified. */
 ugeneric_t *ulist_find(ulist_t *l, ugeneric_t e);
 void ulist_reverse(ulist_t *l);
+/* Moves elements [begin, end) of src before element i of dst (dst may be
+ * src if i is outside of the range). Nodes are relinked, not copied, the
+ * only allocations are the splits of the nodes the range boundaries and
+ * i fall into, so a list with one element per node never allocates. dst
+ * takes over the elements, both lists should own data the same way.
+ */
+void ulist_splice(ulist_t *dst, size_t i, ulist_t *src, size_t begin,
+                  size_t end);
+/* Moves all elements of src to the end of dst in O(1). */
+void ulist_concat(ulist_t *dst, ulist_t *src);
+/* Stable bottom-up merge sort with the list comparator. Elements are moved
+ * between existing nodes, which are refilled while merging. A merge may
+ * need a node before any input node is free, so with more than one element
+ * per node the sort allocates a few spare nodes (their number does not grow
+ * with the list) and frees them before returning. A list with one element
+ * per node is sorted by relinking only and never allocates.
+ */
+void ulist_sort(ulist_t *l);
 ulist_t *ulist_copy(const ulist_t *l);
 ulist_t *ulist_deep_copy(const ulist_t *l);
 int ulist_compare(const ulist_t *l1, const ulist_t *l2, void_cmp_t cmp);
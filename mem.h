@@ -8,6 +8,11 @@
 
 typedef bool (*oom_handler_t)(void *data);
 void libugeneric_set_oom_handler(oom_handler_t handler, void *ctx);
+/* Allocations are counted only in builds with UMEM_COUNT_ALLOCATIONS,
+ * the count stays 0 otherwise.
+ */
+size_t libugeneric_get_allocation_count(void);
+void libugeneric_reset_allocation_count(void);
 
 void *umalloc(size_t size);
 void *ucalloc(size_t nmemb, size_t size);
@@ -17,6 +22,32 @@ void ufree(void *ptr);
 
 static inline void *uzalloc(size_t size) {return ucalloc(size, 1);}
 
+/* Size of the memory block sharing state between cores, data written by
+ * different threads is kept this far apart to avoid false sharing.
+ */
+#ifndef UCACHE_LINE_SIZE
+#define UCACHE_LINE_SIZE 64
+#endif
+
+/* Memory aligned to the power of two alignment, freed with ufree(). */
+void *umalloc_aligned(size_t alignment, size_t size);
+
+/*
+ * Allocations of UMEM_LARGE_THRESHOLD bytes and above are served by
+ * anonymous mappings backed by transparent huge pages (where supported)
+ * and grow in place with mremap() instead of being copied. A small header
+ * in front of every block records its size and backing, the sizes passed
+ * to urealloc_large() and ufree_large() are checked against it.
+ */
+#ifndef UMEM_LARGE_THRESHOLD
+#define UMEM_LARGE_THRESHOLD (32 * 1024 * 1024)
+#endif
+#define UMEM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+void *umalloc_large(size_t size);
+void *urealloc_large(void *ptr, size_t old_size, size_t new_size);
+void ufree_large(void *ptr, size_t size);
+
 #define BUFFER_INITIAL_CAPACITY 16
 
 typedef struct {
@@ -30,6 +61,30 @@ typedef struct {
     size_t size;
 } umemchunk_t;
 
+/*
+ * Memory footprint of a container: bytes taken by the container itself
+ * (headers, nodes, cells holding elements), bytes referenced by elements
+ * (strings, memory chunks, nested containers) and bytes allocated
+ * but not used yet (spare capacity).
+ */
+typedef struct {
+    size_t structure;
+    size_t payload;
+    size_t slack;
+} umemusage_t;
+
+static inline void umemusage_add(umemusage_t *u, umemusage_t t)
+{
+    u->structure += t.structure;
+    u->payload += t.payload;
+    u->slack += t.slack;
+}
+
+static inline size_t umemusage_get_total(umemusage_t u)
+{
+    return u.structure + u.payload + u.slack;
+}
+
 void ubuffer_append_data(ubuffer_t *buf, const void *data, size_t size);
 void ubuffer_append_memchunk(ubuffer_t *buf, const umemchunk_t *data);
 void ubuffer_append_buffer(ubuffer_t *buf, const ubuffer_t *data);
@@ -0,0 +1,420 @@
+#include "mpmc.h"
+
+#include "asserts.h"
+#include "mem.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+/*
+ * Slot of position p (p & mask) is free for the enqueue of p when its
+ * sequence is p, holds the element of p when its sequence is p + 1 and
+ * becomes free for the enqueue of p + capacity after the dequeue.
+ */
+typedef struct {
+    atomic_size_t seq;
+    ugeneric_t e;
+} _slot_t;
+
+struct umpmc_queue_opaq {
+    uvoid_handlers_t void_handlers;
+    bool is_data_owner;
+    _slot_t *slots;
+    size_t mask;
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    atomic_size_t waiting_consumers;
+    atomic_size_t waiting_producers;
+
+    _Alignas(UCACHE_LINE_SIZE) atomic_size_t enq_pos;
+    _Alignas(UCACHE_LINE_SIZE) atomic_size_t deq_pos;
+};
+
+static inline size_t _load(const atomic_size_t *a, memory_order order)
+{
+    return atomic_load_explicit((atomic_size_t *)a, order);
+}
+
+umpmc_queue_t *umpmc_queue_create(size_t capacity)
+{
+    UASSERT_INPUT(capacity);
+    UASSERT_INPUT(capacity <= (SIZE_MAX / 2 + 1) / sizeof(_slot_t));
+
+    size_t c = 1;
+    while (c < capacity)
+    {
+        c <<= 1;
+    }
+
+    umpmc_queue_t *q = umalloc_aligned(UCACHE_LINE_SIZE, sizeof(*q));
+    memset(&q->void_handlers, 0, sizeof(q->void_handlers));
+    q->is_data_owner = true;
+    q->slots = umalloc_large(c * sizeof(q->slots[0]));
+    q->mask = c - 1;
+    for (size_t i = 0; i < c; i++)
+    {
+        atomic_init(&q->slots[i].seq, i);
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    atomic_init(&q->waiting_consumers, 0);
+    atomic_init(&q->waiting_producers, 0);
+    atomic_init(&q->enq_pos, 0);
+    atomic_init(&q->deq_pos, 0);
+
+    return q;
+}
+
+void umpmc_queue_destroy(umpmc_queue_t *q)
+{
+    if (q)
+    {
+        umpmc_queue_clear(q);
+        pthread_cond_destroy(&q->not_full);
+        pthread_cond_destroy(&q->not_empty);
+        pthread_mutex_destroy(&q->lock);
+        ufree_large(q->slots, (q->mask + 1) * sizeof(q->slots[0]));
+        ufree(q);
+    }
+}
+
+void umpmc_queue_clear(umpmc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    size_t enq_pos = _load(&q->enq_pos, memory_order_relaxed);
+    if (q->is_data_owner)
+    {
+        for (size_t p = _load(&q->deq_pos, memory_order_relaxed);
+             p != enq_pos; p++)
+        {
+            ugeneric_destroy_v(q->slots[p & q->mask].e, q->void_handlers.dtr);
+        }
+    }
+
+    for (size_t i = 0; i <= q->mask; i++)
+    {
+        atomic_store_explicit(&q->slots[i].seq, i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&q->enq_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->deq_pos, 0, memory_order_relaxed);
+}
+
+/*
+ * Claims up to n consecutive positions starting from the current value of
+ * counter whose slots have sequence position + offset (0 for enqueue, 1 for
+ * dequeue). Returns the number of claimed positions, the first one is
+ * stored to start.
+ */
+static size_t _claim(umpmc_queue_t *q, atomic_size_t *counter, size_t offset,
+                     size_t n, size_t *start)
+{
+    size_t pos = _load(counter, memory_order_relaxed);
+
+    for (;;)
+    {
+        size_t k = 0;
+        while ((k < n) &&
+               (_load(&q->slots[(pos + k) & q->mask].seq, memory_order_acquire)
+                == pos + k + offset))
+        {
+            k++;
+        }
+
+        if (k == 0)
+        {
+            size_t seq = _load(&q->slots[pos & q->mask].seq,
+                               memory_order_acquire);
+            if ((ptrdiff_t)(seq - (pos + offset)) < 0)
+            {
+                // Full (empty): the slot is still used by the previous lap.
+                return 0;
+            }
+            // Somebody else has claimed the position already.
+            pos = _load(counter, memory_order_relaxed);
+        }
+        else if (atomic_compare_exchange_weak_explicit(counter, &pos, pos + k,
+                                                       memory_order_relaxed,
+                                                       memory_order_relaxed))
+        {
+            *start = pos;
+            return k;
+        }
+    }
+}
+
+static size_t _enq(umpmc_queue_t *q, const ugeneric_t *elements, size_t n)
+{
+    size_t start;
+    size_t k = _claim(q, &q->enq_pos, 0, n, &start);
+    for (size_t i = 0; i < k; i++)
+    {
+        _slot_t *s = &q->slots[(start + i) & q->mask];
+        s->e = elements[i];
+        atomic_store_explicit(&s->seq, start + i + 1, memory_order_release);
+    }
+
+    return k;
+}
+
+static size_t _deq(umpmc_queue_t *q, ugeneric_t *elements, size_t n)
+{
+    size_t start;
+    size_t k = _claim(q, &q->deq_pos, 1, n, &start);
+    for (size_t i = 0; i < k; i++)
+    {
+        _slot_t *s = &q->slots[(start + i) & q->mask];
+        elements[i] = s->e;
+        atomic_store_explicit(&s->seq, start + i + q->mask + 1,
+                              memory_order_release);
+    }
+
+    return k;
+}
+
+/*
+ * Wakes sleepers of the other side after k elements (slots) were made
+ * available. Sleepers announce themselves before their last attempt, the
+ * fence orders that against the slot updates done above.
+ */
+static void _wake(umpmc_queue_t *q, atomic_size_t *waiting, pthread_cond_t *cv,
+                  size_t k)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (_load(waiting, memory_order_relaxed))
+    {
+        pthread_mutex_lock(&q->lock);
+        if (k > 1)
+        {
+            pthread_cond_broadcast(cv);
+        }
+        else
+        {
+            pthread_cond_signal(cv);
+        }
+        pthread_mutex_unlock(&q->lock);
+    }
+}
+
+static inline void _wake_consumers(umpmc_queue_t *q, size_t k)
+{
+    if (k)
+    {
+        _wake(q, &q->waiting_consumers, &q->not_empty, k);
+    }
+}
+
+static inline void _wake_producers(umpmc_queue_t *q, size_t k)
+{
+    if (k)
+    {
+        _wake(q, &q->waiting_producers, &q->not_full, k);
+    }
+}
+
+bool umpmc_queue_try_enq(umpmc_queue_t *q, ugeneric_t e)
+{
+    UASSERT_INPUT(q);
+
+    size_t k = _enq(q, &e, 1);
+    _wake_consumers(q, k);
+
+    return k;
+}
+
+bool umpmc_queue_try_deq(umpmc_queue_t *q, ugeneric_t *e)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(e);
+
+    size_t k = _deq(q, e, 1);
+    _wake_producers(q, k);
+
+    return k;
+}
+
+void umpmc_queue_enq(umpmc_queue_t *q, ugeneric_t e)
+{
+    UASSERT_INPUT(q);
+
+    for (size_t i = 0; i < UMPMC_SPIN_COUNT; i++)
+    {
+        if (umpmc_queue_try_enq(q, e))
+        {
+            return;
+        }
+        if (i >= UMPMC_SPIN_COUNT / 2)
+        {
+            sched_yield();
+        }
+    }
+
+    pthread_mutex_lock(&q->lock);
+    atomic_fetch_add(&q->waiting_producers, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (!_enq(q, &e, 1))
+    {
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+    atomic_fetch_sub(&q->waiting_producers, 1);
+    pthread_mutex_unlock(&q->lock);
+
+    _wake_consumers(q, 1);
+}
+
+ugeneric_t umpmc_queue_deq(umpmc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    ugeneric_t e;
+    for (size_t i = 0; i < UMPMC_SPIN_COUNT; i++)
+    {
+        if (umpmc_queue_try_deq(q, &e))
+        {
+            return e;
+        }
+        if (i >= UMPMC_SPIN_COUNT / 2)
+        {
+            sched_yield();
+        }
+    }
+
+    pthread_mutex_lock(&q->lock);
+    atomic_fetch_add(&q->waiting_consumers, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (!_deq(q, &e, 1))
+    {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+    atomic_fetch_sub(&q->waiting_consumers, 1);
+    pthread_mutex_unlock(&q->lock);
+
+    _wake_producers(q, 1);
+
+    return e;
+}
+
+size_t umpmc_queue_enq_batch(umpmc_queue_t *q, const ugeneric_t *elements,
+                             size_t n)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(elements || !n);
+
+    size_t k = n ? _enq(q, elements, n) : 0;
+    _wake_consumers(q, k);
+
+    return k;
+}
+
+size_t umpmc_queue_deq_batch(umpmc_queue_t *q, ugeneric_t *elements,
+                             size_t n)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(elements || !n);
+
+    size_t k = n ? _deq(q, elements, n) : 0;
+    _wake_producers(q, k);
+
+    return k;
+}
+
+size_t umpmc_queue_get_size(const umpmc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    // Dequeue position never passes the enqueue one, so load it first.
+    size_t deq_pos = _load(&q->deq_pos, memory_order_acquire);
+    size_t enq_pos = _load(&q->enq_pos, memory_order_acquire);
+
+    return MIN(enq_pos - deq_pos, q->mask + 1);
+}
+
+size_t umpmc_queue_get_capacity(const umpmc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+    return q->mask + 1;
+}
+
+bool umpmc_queue_is_empty(const umpmc_queue_t *q)
+{
+    return umpmc_queue_get_size(q) == 0;
+}
+
+bool umpmc_queue_is_full(const umpmc_queue_t *q)
+{
+    return umpmc_queue_get_size(q) == umpmc_queue_get_capacity(q);
+}
+
+umemusage_t umpmc_queue_get_memory_usage(const umpmc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    size_t deq_pos = _load(&q->deq_pos, memory_order_relaxed);
+    size_t size = umpmc_queue_get_size(q);
+    umemusage_t u = {0};
+    u.structure = sizeof(*q) + size * sizeof(q->slots[0]);
+    u.slack = (q->mask + 1 - size) * sizeof(q->slots[0]);
+    if (q->is_data_owner)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            ugeneric_t e = q->slots[(deq_pos + i) & q->mask].e;
+            umemusage_add(&u, ugeneric_get_memory_usage(e));
+        }
+    }
+
+    return u;
+}
+
+void umpmc_queue_serialize(const umpmc_queue_t *q, ubuffer_t *buf)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(buf);
+
+    size_t deq_pos = _load(&q->deq_pos, memory_order_relaxed);
+    size_t size = umpmc_queue_get_size(q);
+    ubuffer_append_byte(buf, '[');
+    for (size_t i = 0; i < size; i++)
+    {
+        ugeneric_serialize_v(q->slots[(deq_pos + i) & q->mask].e, buf,
+                             q->void_handlers.s8r);
+        if (i < size - 1)
+        {
+            ubuffer_append_data(buf, ", ", 2);
+        }
+    }
+    ubuffer_append_byte(buf, ']');
+}
+
+char *umpmc_queue_as_str(const umpmc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    ubuffer_t buf = {0};
+    umpmc_queue_serialize(q, &buf);
+    ubuffer_null_terminate(&buf);
+
+    return buf.data;
+}
+
+int umpmc_queue_fprint(const umpmc_queue_t *q, FILE *out)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(out);
+
+    char *str = umpmc_queue_as_str(q);
+    int ret = fprintf(out, "%s\n", str);
+    ufree(str);
+
+    return ret;
+}
+
+ugeneric_base_t *umpmc_queue_get_base(umpmc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+    return (ugeneric_base_t *)q;
+}
@@ -0,0 +1,66 @@
+#ifndef UMPMC_H__
+#define UMPMC_H__
+
+#include "generic.h"
+
+/*
+ * Bounded queue for any number of producer and consumer threads (Dmitry
+ * Vyukov's design). Every slot carries a sequence number telling which
+ * enqueue (or dequeue) position may use it next, so a thread claims a
+ * position with a single CAS and publishes the slot with a release store;
+ * there is no lock on the fast path. Capacity is rounded up to a power of
+ * two.
+ *
+ * Blocking operations spin for a while and then sleep on a condition
+ * variable, the other side takes the lock to wake them only if somebody
+ * sleeps. Size and emptiness checks are estimates while the queue is used
+ * concurrently. clear, serialization, memory usage and destroy must not
+ * run concurrently with other operations.
+ */
+
+#ifndef UMPMC_SPIN_COUNT
+#define UMPMC_SPIN_COUNT 64
+#endif
+
+typedef struct umpmc_queue_opaq umpmc_queue_t;
+
+umpmc_queue_t *umpmc_queue_create(size_t capacity);
+/* Destroys elements left in the queue if it owns data. */
+void umpmc_queue_destroy(umpmc_queue_t *q);
+void umpmc_queue_clear(umpmc_queue_t *q);
+
+/* Return false if the queue is full (empty). */
+bool umpmc_queue_try_enq(umpmc_queue_t *q, ugeneric_t e);
+bool umpmc_queue_try_deq(umpmc_queue_t *q, ugeneric_t *e);
+
+/* Wait until there is room (an element). */
+void umpmc_queue_enq(umpmc_queue_t *q, ugeneric_t e);
+ugeneric_t umpmc_queue_deq(umpmc_queue_t *q);
+
+/* Move up to n elements claiming consecutive positions with a single CAS,
+ * return the number of elements moved (0 if the queue is full or empty).
+ */
+size_t umpmc_queue_enq_batch(umpmc_queue_t *q, const ugeneric_t *elements,
+                             size_t n);
+size_t umpmc_queue_deq_batch(umpmc_queue_t *q, ugeneric_t *elements,
+                             size_t n);
+
+size_t umpmc_queue_get_size(const umpmc_queue_t *q);
+size_t umpmc_queue_get_capacity(const umpmc_queue_t *q);
+bool umpmc_queue_is_empty(const umpmc_queue_t *q);
+bool umpmc_queue_is_full(const umpmc_queue_t *q);
+umemusage_t umpmc_queue_get_memory_usage(const umpmc_queue_t *q);
+
+char *umpmc_queue_as_str(const umpmc_queue_t *q);
+void umpmc_queue_serialize(const umpmc_queue_t *q, ubuffer_t *buf);
+int umpmc_queue_fprint(const umpmc_queue_t *q, FILE *out);
+static inline int umpmc_queue_print(const umpmc_queue_t *q) {return umpmc_queue_fprint(q, stdout);}
+
+static void umpmc_queue_take_data_ownership(umpmc_queue_t *q);
+static void umpmc_queue_drop_data_ownership(umpmc_queue_t *q);
+static bool umpmc_queue_is_data_owner(umpmc_queue_t *q);
+
+ugeneric_base_t *umpmc_queue_get_base(umpmc_queue_t *q);
+DEFINE_BASE_FUNCS(umpmc_queue)
+
+#endif
@@ -0,0 +1,226 @@
+#include "pool.h"
+
+#include "asserts.h"
+#include "mem.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+typedef struct {
+    upool_task_t task;
+    void *ctx;
+    size_t n;
+    size_t chunk;
+    atomic_size_t next; // beginning of the next chunk to grab
+} _job_t;
+
+struct upool_opaq {
+    pthread_mutex_t submit_lock; // serializes jobs
+    pthread_mutex_t lock;        // protects fields below
+    pthread_cond_t work_cv;
+    pthread_cond_t done_cv;
+    _job_t *job;
+    size_t generation;           // bumped on every job submission
+    size_t active;               // workers running the current job
+    bool shutdown;
+    pthread_t *workers;
+    size_t nworkers;
+};
+
+// Set while a thread runs pool tasks, nested jobs are run inline.
+static _Thread_local bool _in_task;
+
+static size_t _pool_threads = 0;
+static upool_t *_shared_pool;
+static pthread_once_t _shared_pool_once = PTHREAD_ONCE_INIT;
+
+static void _run_chunks(_job_t *job)
+{
+    bool in_task = _in_task;
+    _in_task = true;
+
+    for (;;)
+    {
+        size_t begin = atomic_fetch_add(&job->next, job->chunk);
+        if (begin >= job->n)
+        {
+            break;
+        }
+        job->task(begin, MIN(begin + job->chunk, job->n), job->ctx);
+    }
+
+    _in_task = in_task;
+}
+
+static void *_worker(void *arg)
+{
+    upool_t *p = arg;
+    size_t seen = 0;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;)
+    {
+        while (!p->shutdown && (p->generation == seen))
+        {
+            pthread_cond_wait(&p->work_cv, &p->lock);
+        }
+        if (p->shutdown)
+        {
+            break;
+        }
+
+        /* The job may already be finished and withdrawn by the submitter
+         * if this worker woke up late.
+         */
+        seen = p->generation;
+        _job_t *job = p->job;
+        if (job)
+        {
+            p->active++;
+            pthread_mutex_unlock(&p->lock);
+            _run_chunks(job);
+            pthread_mutex_lock(&p->lock);
+            if (--p->active == 0)
+            {
+                pthread_cond_signal(&p->done_cv);
+            }
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    return NULL;
+}
+
+static size_t _get_online_cpus(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (size_t)n : 1;
+}
+
+upool_t *upool_create(size_t nthreads)
+{
+    if (nthreads == 0)
+    {
+        nthreads = _get_online_cpus();
+    }
+
+    upool_t *p = umalloc(sizeof(*p));
+    pthread_mutex_init(&p->submit_lock, NULL);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->work_cv, NULL);
+    pthread_cond_init(&p->done_cv, NULL);
+    p->job = NULL;
+    p->generation = 0;
+    p->active = 0;
+    p->shutdown = false;
+    p->workers = NULL;
+    p->nworkers = 0;
+
+    if (nthreads > 1)
+    {
+        p->workers = umalloc((nthreads - 1) * sizeof(p->workers[0]));
+        for (size_t i = 0; i < nthreads - 1; i++)
+        {
+            // Pool works with fewer threads if some of them fail to start.
+            if (pthread_create(&p->workers[p->nworkers], NULL, _worker, p) == 0)
+            {
+                p->nworkers++;
+            }
+        }
+    }
+
+    return p;
+}
+
+void upool_destroy(upool_t *p)
+{
+    if (p)
+    {
+        pthread_mutex_lock(&p->lock);
+        p->shutdown = true;
+        pthread_cond_broadcast(&p->work_cv);
+        pthread_mutex_unlock(&p->lock);
+
+        for (size_t i = 0; i < p->nworkers; i++)
+        {
+            pthread_join(p->workers[i], NULL);
+        }
+
+        pthread_cond_destroy(&p->done_cv);
+        pthread_cond_destroy(&p->work_cv);
+        pthread_mutex_destroy(&p->lock);
+        pthread_mutex_destroy(&p->submit_lock);
+        ufree(p->workers);
+        ufree(p);
+    }
+}
+
+size_t upool_get_threads(const upool_t *p)
+{
+    UASSERT_INPUT(p);
+    return p->nworkers + 1;
+}
+
+void upool_run(upool_t *p, size_t n, size_t chunk, upool_task_t task,
+               void *ctx)
+{
+    UASSERT_INPUT(p);
+    UASSERT_INPUT(chunk);
+    UASSERT_INPUT(task);
+
+    _job_t job = {
+        .task = task,
+        .ctx = ctx,
+        .n = n,
+        .chunk = chunk,
+    };
+    atomic_init(&job.next, 0);
+
+    if ((p->nworkers == 0) || (n <= chunk) || _in_task)
+    {
+        _run_chunks(&job);
+        return;
+    }
+
+    pthread_mutex_lock(&p->submit_lock);
+
+    pthread_mutex_lock(&p->lock);
+    p->job = &job;
+    p->generation++;
+    pthread_cond_broadcast(&p->work_cv);
+    pthread_mutex_unlock(&p->lock);
+
+    _run_chunks(&job);
+
+    pthread_mutex_lock(&p->lock);
+    while (p->active)
+    {
+        pthread_cond_wait(&p->done_cv, &p->lock);
+    }
+    p->job = NULL;
+    pthread_mutex_unlock(&p->lock);
+
+    pthread_mutex_unlock(&p->submit_lock);
+}
+
+static void _create_shared_pool(void)
+{
+    _shared_pool = upool_create(_pool_threads);
+}
+
+upool_t *upool_get_shared(void)
+{
+    pthread_once(&_shared_pool_once, _create_shared_pool);
+    return _shared_pool;
+}
+
+void libugeneric_set_pool_threads(size_t nthreads)
+{
+    _pool_threads = nthreads;
+}
+
+size_t libugeneric_get_pool_threads(void)
+{
+    return _pool_threads;
+}
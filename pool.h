@@ -0,0 +1,43 @@
+#ifndef UPOOL_H__
+#define UPOOL_H__
+
+#include "generic.h"
+
+/*
+ * Pool of worker threads running data parallel loops: range [0, n) is split
+ * into chunks which workers (and the submitting thread) grab one by one
+ * until none is left. Jobs submitted to the same pool run one at a time,
+ * a job submitted from inside a running task is executed inline.
+ */
+
+typedef struct upool_opaq upool_t;
+
+/* Processes elements [begin, end) of a job. */
+typedef void (*upool_task_t)(size_t begin, size_t end, void *ctx);
+
+/* nthreads counts the submitting thread, i.e. nthreads - 1 workers are
+ * spawned. 0 means the number of online CPUs.
+ */
+upool_t *upool_create(size_t nthreads);
+void upool_destroy(upool_t *p);
+size_t upool_get_threads(const upool_t *p);
+
+/* Calls task for every chunk of [0, n) of chunk size elements (the last one
+ * may be shorter) and returns once all of them are done. Chunk boundaries
+ * depend on n and chunk only, not on the number of threads.
+ */
+void upool_run(upool_t *p, size_t n, size_t chunk, upool_task_t task,
+               void *ctx);
+
+/* Pool shared by the library (e.g. by uvector_map()), created on the first
+ * use with libugeneric_get_pool_threads() threads and never destroyed.
+ */
+upool_t *upool_get_shared(void);
+
+/* Number of threads of the shared pool, 0 (default) means the number of
+ * online CPUs. Has effect only if set before the shared pool is created.
+ */
+void libugeneric_set_pool_threads(size_t nthreads);
+size_t libugeneric_get_pool_threads(void);
+
+#endif
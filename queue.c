@@ -3,64 +3,122 @@
 #include "asserts.h"
 #include "mem.h"
 
-/* out <-- [h][e][e][...][e][e][t] <-- in */
+/*
+ * out <-- [h][e][e][...][e][e][t] <-- in
+ *
+ * Elements occupy size cells from h on wrapping around the end of the
+ * storage, t = (h + size - 1) % capacity.
+ */
 
 struct uqueue_opaq {
     uvoid_handlers_t void_handlers;
     bool is_data_owner;
     ugeneric_t *data;
     size_t h; // head
-    size_t t; // tail
     size_t size;
     size_t capacity;
+    uqueue_mode_t mode;
 };
 
+struct uqueue_iterator_opaq {
+    const uqueue_t *queue;
+    size_t i;
+};
+
+// Index of the cell i positions after the head.
+static inline size_t _wrap(const uqueue_t *q, size_t i)
+{
+    i += q->h;
+    return (i >= q->capacity) ? i - q->capacity : i;
+}
+
 uqueue_t *uqueue_create(void)
 {
+    return uqueue_create_ext(0, UQUEUE_GROW);
+}
+
+uqueue_t *uqueue_create_ext(size_t capacity, uqueue_mode_t mode)
+{
+    UASSERT_INPUT(mode == UQUEUE_GROW || mode == UQUEUE_OVERWRITE);
+    UASSERT_INPUT(capacity || mode == UQUEUE_GROW);
+
     uqueue_t *q = umalloc(sizeof(*q));
     q->data = NULL;
     q->h = 0;
-    q->t = 0;
     q->size = 0;
     q->capacity = 0;
+    q->mode = mode;
+    q->is_data_owner = true;
     memset(&q->void_handlers, 0, sizeof(q->void_handlers));
+    uqueue_reserve_capacity(q, capacity);
 
     return q;
 }
 
+uqueue_mode_t uqueue_get_mode(const uqueue_t *q)
+{
+    UASSERT_INPUT(q);
+    return q->mode;
+}
+
 void uqueue_destroy(uqueue_t *q)
 {
     if (q)
     {
-        ufree(q->data);
+        uqueue_clear(q);
+        ufree_large(q->data, q->capacity * sizeof(q->data[0]));
         ufree(q);
     }
 }
 
+// Drops n oldest elements.
+static void _drop(uqueue_t *q, size_t n)
+{
+    if (q->is_data_owner)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            ugeneric_destroy_v(q->data[_wrap(q, i)], q->void_handlers.dtr);
+        }
+    }
+    q->h = _wrap(q, n);
+    q->size -= n;
+}
+
 void uqueue_clear(uqueue_t *q)
 {
     UASSERT_INPUT(q);
 
+    _drop(q, q->size);
     q->h = 0;
-    q->t = 0;
-    q->size = 0;
 }
 
-void uqueue_enq(uqueue_t *q, ugeneric_t element)
+// Makes room for n more elements, dropping old ones in overwrite mode.
+static void _make_room(uqueue_t *q, size_t n)
 {
-    UASSERT_INPUT(q);
+    if (q->capacity - q->size >= n)
+    {
+        return;
+    }
 
-    if (q->capacity == q->size)
+    if (q->mode == UQUEUE_OVERWRITE)
     {
-        size_t new_capacity = MAX(SCALE_FACTOR * q->size,
-                                  QUEUE_INITIAL_CAPACITY);
-        uqueue_reserve_capacity(q, new_capacity ? new_capacity : 1);
+        _drop(q, n - (q->capacity - q->size));
     }
-    if (q->size)
+    else
     {
-        q->t = (q->t + 1) % q->capacity;
+        size_t new_capacity = MAX(SCALE_FACTOR * q->capacity,
+                                  QUEUE_INITIAL_CAPACITY);
+        uqueue_reserve_capacity(q, MAX(new_capacity, q->size + n));
     }
-    q->data[q->t] = element;
+}
+
+void uqueue_enq(uqueue_t *q, ugeneric_t element)
+{
+    UASSERT_INPUT(q);
+
+    _make_room(q, 1);
+    q->data[_wrap(q, q->size)] = element;
     q->size++;
 }
 
@@ -70,15 +128,61 @@ ugeneric_t uqueue_deq(uqueue_t *q)
     UASSERT_MSG(q->size, "dequeuing from an empty queue");
 
     ugeneric_t e = q->data[q->h];
-    if (q->h != q->t)
-    {
-        q->h = (q->h + 1) % q->capacity;
-    }
+    q->h = _wrap(q, 1);
     q->size--;
 
     return e;
 }
 
+void uqueue_enq_batch(uqueue_t *q, const ugeneric_t *elements, size_t n)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(elements || !n);
+
+    if ((q->mode == UQUEUE_OVERWRITE) && (n > q->capacity))
+    {
+        // Elements which would be overwritten right away.
+        size_t skip = n - q->capacity;
+        if (q->is_data_owner)
+        {
+            for (size_t i = 0; i < skip; i++)
+            {
+                ugeneric_destroy_v(elements[i], q->void_handlers.dtr);
+            }
+        }
+        elements += skip;
+        n -= skip;
+    }
+
+    if (n)
+    {
+        _make_room(q, n);
+        size_t t = _wrap(q, q->size);
+        size_t first = MIN(n, q->capacity - t);
+        memcpy(&q->data[t], elements, first * sizeof(elements[0]));
+        memcpy(q->data, &elements[first], (n - first) * sizeof(elements[0]));
+        q->size += n;
+    }
+}
+
+size_t uqueue_deq_batch(uqueue_t *q, ugeneric_t *elements, size_t n)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(elements || !n);
+
+    n = MIN(n, q->size);
+    if (n)
+    {
+        size_t first = MIN(n, q->capacity - q->h);
+        memcpy(elements, &q->data[q->h], first * sizeof(elements[0]));
+        memcpy(&elements[first], q->data, (n - first) * sizeof(elements[0]));
+        q->h = _wrap(q, n);
+        q->size -= n;
+    }
+
+    return n;
+}
+
 ugeneric_t uqueue_peek(const uqueue_t *q)
 {
     UASSERT_INPUT(q);
@@ -98,40 +202,59 @@ size_t uqueue_get_capacity(const uqueue_t *q)
     return q->capacity;
 }
 
+umemusage_t uqueue_get_memory_usage(const uqueue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    umemusage_t u = {0};
+    u.structure = sizeof(*q) + q->size * sizeof(q->data[0]);
+    u.slack = (q->capacity - q->size) * sizeof(q->data[0]);
+    if (q->is_data_owner)
+    {
+        for (size_t i = 0; i < q->size; i++)
+        {
+            ugeneric_t e = q->data[_wrap(q, i)];
+            umemusage_add(&u, ugeneric_get_memory_usage(e));
+        }
+    }
+
+    return u;
+}
+
 bool uqueue_is_empty(const uqueue_t *q)
 {
     UASSERT_INPUT(q);
     return q->size == 0;
 }
 
+bool uqueue_is_full(const uqueue_t *q)
+{
+    UASSERT_INPUT(q);
+    return q->size == q->capacity;
+}
+
 void uqueue_reserve_capacity(uqueue_t *q, size_t new_capacity)
 {
     UASSERT_INPUT(q);
 
     if (q->capacity < new_capacity)
     {
-        /* If queue is not empty and we need more slots we allocate
-         * additional memory and move existing elements to bigger room.
-         * Old queue memory should be freed.
+        /* Grow the storage in place (mremap for large queues) and move
+         * the wrapped around head part [h, capacity) to the end of
+         * the new room so that elements stay in the ring order.
          */
-        if (q->size)
-        {
-            ugeneric_t *p = umalloc(new_capacity * sizeof(*p));
-            for (size_t i = 0; i < q->size; i++)
-            {
-                p[i] = q->data[(q->h + i) % q->capacity];
-            }
-            ufree(q->data);
-            q->data = p;
-            q->h = 0;
-            q->t = q->size - 1;
-            q->capacity = new_capacity;
-        }
-        else
+        ugeneric_t *p = urealloc_large(q->data,
+                                       q->capacity * sizeof(q->data[0]),
+                                       new_capacity * sizeof(q->data[0]));
+        if (q->h + q->size > q->capacity)
         {
-            q->data = umalloc(new_capacity * sizeof(q->data[0]));
-            q->capacity = new_capacity;
+            size_t head_part = q->capacity - q->h;
+            size_t new_h = new_capacity - head_part;
+            memmove(p + new_h, p + q->h, head_part * sizeof(p[0]));
+            q->h = new_h;
         }
+        q->data = p;
+        q->capacity = new_capacity;
     }
 }
 
@@ -143,7 +266,7 @@ void uqueue_serialize(const uqueue_t *q, ubuffer_t *buf)
     ubuffer_append_byte(buf, '[');
     for (size_t i = 0; i < q->size; i++)
     {
-        ugeneric_serialize_v(q->data[(q->h + i) % q->capacity], buf, q->void_handlers.s8r);
+        ugeneric_serialize_v(q->data[_wrap(q, i)], buf, q->void_handlers.s8r);
         if (i < q->size - 1)
         {
             ubuffer_append_data(buf, ", ", 2);
@@ -175,6 +298,45 @@ int uqueue_fprint(const uqueue_t *q, FILE *out)
     return ret;
 }
 
+uqueue_iterator_t *uqueue_iterator_create(const uqueue_t *q)
+{
+    UASSERT_INPUT(q);
+    uqueue_iterator_t *qi = umalloc(sizeof(*qi));
+
+    qi->queue = q;
+    qi->i = 0;
+
+    return qi;
+}
+
+ugeneric_t uqueue_iterator_get_next(uqueue_iterator_t *qi)
+{
+    UASSERT_INPUT(qi);
+    UASSERT_MSG(qi->i < qi->queue->size, "iteration is done");
+
+    return qi->queue->data[_wrap(qi->queue, qi->i++)];
+}
+
+bool uqueue_iterator_has_next(const uqueue_iterator_t *qi)
+{
+    UASSERT_INPUT(qi);
+    return qi->i < qi->queue->size;
+}
+
+void uqueue_iterator_reset(uqueue_iterator_t *qi)
+{
+    UASSERT_INPUT(qi);
+    qi->i = 0;
+}
+
+void uqueue_iterator_destroy(uqueue_iterator_t *qi)
+{
+    if (qi)
+    {
+        ufree(qi);
+    }
+}
+
 ugeneric_base_t *uqueue_get_base(uqueue_t *q)
 {
     UASSERT_INPUT(q);
@@ -6,17 +6,38 @@
 #define QUEUE_INITIAL_CAPACITY 16
 
 typedef struct uqueue_opaq uqueue_t;
+typedef struct uqueue_iterator_opaq uqueue_iterator_t;
+
+typedef enum {
+    UQUEUE_GROW,      // storage grows when the queue is full
+    UQUEUE_OVERWRITE, // fixed capacity ring, the oldest element is dropped
+} uqueue_mode_t;
 
 uqueue_t *uqueue_create(void);
+/* Queue with room for capacity elements allocated upfront. In
+ * UQUEUE_OVERWRITE mode enqueueing to a full queue drops (and destroys if
+ * the queue owns data) the oldest element, capacity changes only through
+ * uqueue_reserve_capacity().
+ */
+uqueue_t *uqueue_create_ext(size_t capacity, uqueue_mode_t mode);
+uqueue_mode_t uqueue_get_mode(const uqueue_t *q);
 void uqueue_destroy(uqueue_t *q);
 void uqueue_reserve_capacity(uqueue_t *q, size_t new_capacity);
 void uqueue_clear(uqueue_t *q);
 void uqueue_enq(uqueue_t *q, ugeneric_t element);
 ugeneric_t uqueue_peek(const uqueue_t *q);
 ugeneric_t uqueue_deq(uqueue_t *q);
+/* Copy runs of elements in and out with at most two memcpy() calls.
+ * Enqueueing follows the queue mode, dequeueing takes up to n elements and
+ * returns the number taken.
+ */
+void uqueue_enq_batch(uqueue_t *q, const ugeneric_t *elements, size_t n);
+size_t uqueue_deq_batch(uqueue_t *q, ugeneric_t *elements, size_t n);
 size_t uqueue_get_size(const uqueue_t *q);
 size_t uqueue_get_capacity(const uqueue_t *q);
+umemusage_t uqueue_get_memory_usage(const uqueue_t *q);
 bool uqueue_is_empty(const uqueue_t *q);
+bool uqueue_is_full(const uqueue_t *q);
 
 char *uqueue_as_str(const uqueue_t *q);
 void uqueue_serialize(const uqueue_t *q, ubuffer_t *buf);
@@ -27,6 +48,15 @@ static void uqueue_take_data_ownership(uqueue_t *q);
 static void uqueue_drop_data_ownership(uqueue_t *q);
 static bool uqueue_is_data_owner(uqueue_t *q);
 
+/* Walks elements from the oldest one without dequeueing them, the iterator
+ * is invalidated by any modification of the queue.
+ */
+uqueue_iterator_t *uqueue_iterator_create(const uqueue_t *q);
+ugeneric_t uqueue_iterator_get_next(uqueue_iterator_t *qi);
+bool uqueue_iterator_has_next(const uqueue_iterator_t *qi);
+void uqueue_iterator_reset(uqueue_iterator_t *qi);
+void uqueue_iterator_destroy(uqueue_iterator_t *qi);
+
 ugeneric_base_t *uqueue_get_base(uqueue_t *q);
 DEFINE_BASE_FUNCS(uqueue)
 
@@ -1,13 +1,178 @@
 #include "sort.h"
 
 #include "asserts.h"
+#include "dict.h"
 #include "mem.h"
 
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+
 static size_t _insertion_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
 static size_t _merge(ugeneric_t *lbase, size_t lsize, ugeneric_t *rbase,
                      size_t rsize, ugeneric_t *aux, void_cmp_t cmp);
 static size_t _merge_sort(ugeneric_t *base, ugeneric_t *aux, size_t nmemb,
-                          void_cmp_t cmp);
+                          void_cmp_t cmp, ugeneric_type_e ntype);
+static ugeneric_type_e _get_numeric_type(const ugeneric_t *base, size_t nmemb);
+
+/* Sorting networks for 2..USORT_NETWORK_MAX elements as pairs of indexes to
+ * compare-exchange. Networks for up to 8 elements are optimal, larger ones
+ * are Green's 60-comparator network for 16 elements with the extreme inputs
+ * pruned, at most two comparators off the best known. All of them are
+ * verified with the 0-1 principle by the unit test.
+ */
+static const unsigned char _net2[] = {
+    0,1
+};
+static const unsigned char _net3[] = {
+    0,1, 0,2, 1,2
+};
+static const unsigned char _net4[] = {
+    0,1, 2,3, 0,2, 1,3, 1,2
+};
+static const unsigned char _net5[] = {
+    0,1, 2,3, 0,2, 1,3, 1,2, 0,4, 2,4, 1,2, 3,4
+};
+static const unsigned char _net6[] = {
+    0,1, 2,3, 0,2, 1,3, 1,2, 4,5, 0,4, 2,4, 1,5, 3,5, 1,2, 3,4
+};
+static const unsigned char _net7[] = {
+    0,1, 2,3, 0,2, 1,3, 1,2, 4,5, 4,6, 5,6, 0,4, 2,6, 2,4, 1,5, 3,5, 1,2,
+    3,4, 5,6
+};
+static const unsigned char _net8[] = {
+    0,1, 2,3, 0,2, 1,3, 1,2, 4,5, 6,7, 4,6, 5,7, 5,6, 0,4, 2,6, 2,4, 1,5,
+    3,7, 3,5, 1,2, 3,4, 5,6
+};
+static const unsigned char _net9[] = {
+    4,8, 5,6, 0,5, 1,7, 3,4, 0,1, 2,3, 4,5, 6,8, 0,2, 1,3, 6,7, 1,2, 4,6,
+    5,7, 1,4, 2,6, 5,8, 2,4, 3,6, 3,5, 6,8, 3,4, 5,6, 7,8, 6,7
+};
+static const unsigned char _net10[] = {
+    4,8, 5,6, 0,5, 1,7, 2,9, 3,4, 0,1, 2,3, 4,5, 6,8, 7,9, 0,2, 1,3, 6,7,
+    8,9, 1,2, 4,6, 5,7, 1,4, 2,6, 5,8, 2,4, 3,6, 3,5, 6,8, 7,9, 3,4, 5,6,
+    7,8, 6,7, 8,9
+};
+static const unsigned char _net11[] = {
+    4,8, 5,6, 9,10, 0,5, 1,7, 2,9, 3,4, 0,1, 2,3, 4,5, 6,8, 7,9, 0,2, 1,3,
+    4,10, 6,7, 8,9, 1,2, 4,6, 5,7, 8,10, 1,4, 2,6, 5,8, 7,10, 2,4, 3,6,
+    3,5, 6,8, 7,9, 3,4, 5,6, 7,8, 9,10, 6,7, 8,9
+};
+static const unsigned char _net12[] = {
+    4,8, 5,6, 7,11, 9,10, 0,5, 1,7, 2,9, 3,4, 0,1, 2,3, 4,5, 6,8, 7,9,
+    10,11, 0,2, 1,3, 4,10, 5,11, 6,7, 8,9, 1,2, 4,6, 5,7, 8,10, 9,11, 1,4,
+    2,6, 5,8, 7,10, 2,4, 3,6, 3,5, 6,8, 7,9, 3,4, 5,6, 7,8, 9,10, 6,7, 8,9
+};
+static const unsigned char _net13[] = {
+    1,12, 4,8, 5,6, 7,11, 9,10, 0,5, 1,7, 2,9, 3,4, 11,12, 0,1, 2,3, 4,5,
+    6,8, 7,9, 10,11, 0,2, 1,3, 4,10, 5,11, 6,7, 8,9, 1,2, 3,12, 4,6, 5,7,
+    8,10, 9,11, 1,4, 2,6, 5,8, 7,10, 2,4, 3,6, 9,12, 3,5, 6,8, 7,9, 10,12,
+    3,4, 5,6, 7,8, 9,10, 11,12, 6,7, 8,9
+};
+static const unsigned char _net14[] = {
+    0,13, 1,12, 4,8, 5,6, 7,11, 9,10, 0,5, 1,7, 2,9, 3,4, 6,13, 11,12, 0,1,
+    2,3, 4,5, 6,8, 7,9, 10,11, 12,13, 0,2, 1,3, 4,10, 5,11, 6,7, 8,9, 1,2,
+    3,12, 4,6, 5,7, 8,10, 9,11, 1,4, 2,6, 5,8, 7,10, 9,13, 2,4, 3,6, 9,12,
+    11,13, 3,5, 6,8, 7,9, 10,12, 3,4, 5,6, 7,8, 9,10, 11,12, 6,7, 8,9
+};
+static const unsigned char _net15[] = {
+    0,13, 1,12, 3,14, 4,8, 5,6, 7,11, 9,10, 0,5, 1,7, 2,9, 3,4, 6,13, 8,14,
+    11,12, 0,1, 2,3, 4,5, 6,8, 7,9, 10,11, 12,13, 0,2, 1,3, 4,10, 5,11,
+    6,7, 8,9, 12,14, 1,2, 3,12, 4,6, 5,7, 8,10, 9,11, 13,14, 1,4, 2,6, 5,8,
+    7,10, 9,13, 11,14, 2,4, 3,6, 9,12, 11,13, 3,5, 6,8, 7,9, 10,12, 3,4,
+    5,6, 7,8, 9,10, 11,12, 6,7, 8,9
+};
+static const unsigned char _net16[] = {
+    0,13, 1,12, 2,15, 3,14, 4,8, 5,6, 7,11, 9,10, 0,5, 1,7, 2,9, 3,4, 6,13,
+    8,14, 10,15, 11,12, 0,1, 2,3, 4,5, 6,8, 7,9, 10,11, 12,13, 14,15, 0,2,
+    1,3, 4,10, 5,11, 6,7, 8,9, 12,14, 13,15, 1,2, 3,12, 4,6, 5,7, 8,10,
+    9,11, 13,14, 1,4, 2,6, 5,8, 7,10, 9,13, 11,14, 2,4, 3,6, 9,12, 11,13,
+    3,5, 6,8, 7,9, 10,12, 3,4, 5,6, 7,8, 9,10, 11,12, 6,7, 8,9
+};
+
+static const unsigned char *const _networks[] = {
+    NULL, NULL, _net2, _net3, _net4, _net5, _net6, _net7, _net8, _net9,
+    _net10, _net11, _net12, _net13, _net14, _net15, _net16,
+};
+
+static const unsigned char _network_sizes[] = {
+    0, 0, ARR_LEN(_net2) / 2, ARR_LEN(_net3) / 2, ARR_LEN(_net4) / 2,
+    ARR_LEN(_net5) / 2, ARR_LEN(_net6) / 2, ARR_LEN(_net7) / 2,
+    ARR_LEN(_net8) / 2, ARR_LEN(_net9) / 2, ARR_LEN(_net10) / 2,
+    ARR_LEN(_net11) / 2, ARR_LEN(_net12) / 2, ARR_LEN(_net13) / 2,
+    ARR_LEN(_net14) / 2, ARR_LEN(_net15) / 2, ARR_LEN(_net16) / 2,
+};
+
+/* Values are loaded to a local array of the native type and compare-exchanged
+ * with conditional moves, no data dependent branches are left. All elements
+ * have the same type, so only values are written back.
+ */
+#define _NETWORK_SORT(_type_, _as_)                                             \
+    do {                                                                        \
+        _type_ x[USORT_NETWORK_MAX];                                            \
+        for (size_t k = 0; k < nmemb; k++)                                      \
+        {                                                                       \
+            x[k] = _as_(base[k]);                                               \
+        }                                                                       \
+        for (size_t k = 0; k < npairs; k++)                                     \
+        {                                                                       \
+            _type_ a = x[net[2 * k]];                                           \
+            _type_ b = x[net[2 * k + 1]];                                       \
+            bool swap = b < a;                                                  \
+            x[net[2 * k]] = swap ? b : a;                                       \
+            x[net[2 * k + 1]] = swap ? a : b;                                   \
+        }                                                                       \
+        for (size_t k = 0; k < nmemb; k++)                                      \
+        {                                                                       \
+            _as_(base[k]) = x[k];                                               \
+        }                                                                       \
+    } while (0)
+
+/* ntype is the type of all elements as returned by _get_numeric_type(),
+ * G_NULL_T means elements are compared with ugeneric_compare_v().
+ */
+static void _network_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp,
+                          ugeneric_type_e ntype)
+{
+    const unsigned char *net = _networks[nmemb];
+    size_t npairs = _network_sizes[nmemb];
+
+    switch (ntype)
+    {
+        case G_INT_T:
+            _NETWORK_SORT(long, G_AS_INT);
+            break;
+
+        case G_SIZE_T:
+            _NETWORK_SORT(size_t, G_AS_SIZE);
+            break;
+
+        case G_REAL_T:
+            for (size_t k = 0; k < nmemb; k++)
+            {
+                if (G_AS_REAL(base[k]) != G_AS_REAL(base[k]))
+                {
+                    UABORT("NAN in comparison");
+                }
+            }
+            _NETWORK_SORT(double, G_AS_REAL);
+            break;
+
+        default:
+            for (size_t k = 0; k < npairs; k++)
+            {
+                ugeneric_t *a = base + net[2 * k];
+                ugeneric_t *b = base + net[2 * k + 1];
+                if (ugeneric_compare_v(*b, *a, cmp) < 0)
+                {
+                    ugeneric_swap(a, b);
+                }
+            }
+            break;
+    }
+}
+
+#undef _NETWORK_SORT
 
 /* [l:r) */
 /* Hoar partitioning separates array into [smaller|larger or equal]
@@ -58,14 +223,22 @@ static size_t _hoar_partition(ugeneric_t *base, size_t l, size_t r, void_cmp_t c
 }
 
 /* [l:r) */
-static void _quick_sort(ugeneric_t *base, size_t l, size_t r, void_cmp_t cmp)
+static void _quick_sort(ugeneric_t *base, size_t l, size_t r, void_cmp_t cmp,
+                        ugeneric_type_e ntype)
 {
-    if (r - l > 1) // terminate if [l, r) defines a single element
+    if ((ntype != G_NULL_T) && (r - l <= USORT_NETWORK_MAX))
+    {
+        if (r - l > 1)
+        {
+            _network_sort(base + l, r - l, cmp, ntype);
+        }
+    }
+    else if (r - l > 1) // terminate if [l, r) defines a single element
     {
         size_t pi = _hoar_partition(base, l, r, cmp);
 
-        _quick_sort(base, l, pi + 1, cmp);
-        _quick_sort(base, pi + 1, r, cmp);
+        _quick_sort(base, l, pi + 1, cmp, ntype);
+        _quick_sort(base, pi + 1, r, cmp, ntype);
     }
 }
 
@@ -114,17 +287,27 @@ static size_t _merge(ugeneric_t *lbase, size_t lsize, ugeneric_t *rbase,
     return inv;
 }
 
+/* Small ranges of numeric elements are sorted with networks if ntype is not
+ * G_NULL_T, inversions are not counted then.
+ */
 static size_t _merge_sort(ugeneric_t *base, ugeneric_t *aux, size_t nmemb,
-                          void_cmp_t cmp)
+                          void_cmp_t cmp, ugeneric_type_e ntype)
 {
     size_t inv = 0;
     size_t j;
 
-    if (nmemb > 1)
+    if ((ntype != G_NULL_T) && (nmemb <= USORT_NETWORK_MAX))
+    {
+        if (nmemb > 1)
+        {
+            _network_sort(base, nmemb, cmp, ntype);
+        }
+    }
+    else if (nmemb > 1)
     {
         j = nmemb / 2;
-        inv += _merge_sort(base, aux, j, cmp);
-        inv += _merge_sort(base + j, aux, nmemb - j, cmp);
+        inv += _merge_sort(base, aux, j, cmp, ntype);
+        inv += _merge_sort(base + j, aux, nmemb - j, cmp, ntype);
         inv += _merge(base, j, base + j, nmemb - j, aux, cmp);
         memcpy(base, aux, sizeof(*base) * nmemb);
     }
@@ -132,96 +315,1731 @@ static size_t _merge_sort(ugeneric_t *base, ugeneric_t *aux, size_t nmemb,
     return inv;
 }
 
-static void _hsort(ugeneric_t *base, size_t l, size_t r, void_cmp_t cmp)
+/* Pattern-defeating quicksort (Orson Peters) replaces the plain Hoare
+ * partitioning quick sort in hybrid_sort(). It is an introsort: pivots are
+ * the median of three (ninther on large ranges), partitioning is done by
+ * blocks of comparison results, ranges found already partitioned are
+ * finished with a bounded insertion sort, ranges with many elements equal
+ * to the pivot are split off with partition-left, and after log(n) badly
+ * unbalanced partitions the range is heap sorted, so that the worst case is
+ * O(n log n).
+ */
+
+#define _PDQ_LESS(a, b)             (ugeneric_compare_v((a), (b), cmp) < 0)
+#define _PDQ_NINTHER_THRESHOLD      128
+#define _PDQ_PARTIAL_INSERTION_LIMIT 8
+#define _PDQ_BLOCK_SIZE             64
+
+/* Requires an element before begin which is not greater than any element in
+ * [begin, end) to be used as a sentinel.
+ */
+static void _pdq_unguarded_insertion_sort(ugeneric_t *begin, ugeneric_t *end,
+                                          void_cmp_t cmp)
+{
+    for (ugeneric_t *cur = begin + 1; cur < end; cur++)
+    {
+        ugeneric_t *sift = cur;
+        ugeneric_t *sift_1 = cur - 1;
+        if (_PDQ_LESS(*sift, *sift_1))
+        {
+            ugeneric_t t = *sift;
+            do { *sift-- = *sift_1; } while (_PDQ_LESS(t, *--sift_1));
+            *sift = t;
+        }
+    }
+}
+
+/* Gives up after a few element moves, returns true if the range got sorted. */
+static bool _pdq_partial_insertion_sort(ugeneric_t *begin, ugeneric_t *end,
+                                        void_cmp_t cmp)
+{
+    size_t limit = 0;
+
+    for (ugeneric_t *cur = begin + 1; cur < end; cur++)
+    {
+        ugeneric_t *sift = cur;
+        ugeneric_t *sift_1 = cur - 1;
+        if (_PDQ_LESS(*sift, *sift_1))
+        {
+            ugeneric_t t = *sift;
+            do { *sift-- = *sift_1; } while ((sift != begin) && _PDQ_LESS(t, *--sift_1));
+            *sift = t;
+            limit += cur - sift;
+        }
+        if (limit > _PDQ_PARTIAL_INSERTION_LIMIT)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void _pdq_sift_down(ugeneric_t *base, size_t i, size_t nmemb,
+                           void_cmp_t cmp)
+{
+    for (;;)
+    {
+        size_t max = i;
+        size_t l = 2 * i + 1;
+        size_t r = l + 1;
+        if ((l < nmemb) && _PDQ_LESS(base[max], base[l]))
+        {
+            max = l;
+        }
+        if ((r < nmemb) && _PDQ_LESS(base[max], base[r]))
+        {
+            max = r;
+        }
+        if (max == i)
+        {
+            return;
+        }
+        ugeneric_swap(base + i, base + max);
+        i = max;
+    }
+}
+
+static void _pdq_heap_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    for (size_t i = nmemb / 2; i > 0; i--)
+    {
+        _pdq_sift_down(base, i - 1, nmemb, cmp);
+    }
+    for (size_t i = nmemb - 1; i > 0; i--)
+    {
+        ugeneric_swap(base, base + i);
+        _pdq_sift_down(base, 0, i, cmp);
+    }
+}
+
+static inline void _pdq_sort2(ugeneric_t *a, ugeneric_t *b, void_cmp_t cmp)
+{
+    if (_PDQ_LESS(*b, *a))
+    {
+        ugeneric_swap(a, b);
+    }
+}
+
+static inline void _pdq_sort3(ugeneric_t *a, ugeneric_t *b, ugeneric_t *c,
+                              void_cmp_t cmp)
+{
+    _pdq_sort2(a, b, cmp);
+    _pdq_sort2(b, c, cmp);
+    _pdq_sort2(a, b, cmp);
+}
+
+static void _pdq_swap_offsets(ugeneric_t *first, ugeneric_t *last,
+                              const unsigned char *offsets_l,
+                              const unsigned char *offsets_r,
+                              size_t num, bool use_swaps)
+{
+    if (use_swaps)
+    {
+        /* Misplaced elements form pairs, a cyclic permutation would move
+         * them twice.
+         */
+        for (size_t i = 0; i < num; i++)
+        {
+            ugeneric_swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+    }
+    else if (num > 0)
+    {
+        ugeneric_t *l = first + offsets_l[0];
+        ugeneric_t *r = last - offsets_r[0];
+        ugeneric_t t = *l;
+        *l = *r;
+        for (size_t i = 1; i < num; i++)
+        {
+            l = first + offsets_l[i];
+            *r = *l;
+            r = last - offsets_r[i];
+            *l = *r;
+        }
+        *r = t;
+    }
+}
+
+/* Partitions [begin, end) around *begin into [< pivot][pivot][>= pivot],
+ * returns position of the pivot. Comparison results are first collected for
+ * a block of elements from each side and only then misplaced elements are
+ * swapped, which keeps the comparison loop free of data dependent branches.
+ */
+static ugeneric_t *_pdq_partition_right(ugeneric_t *begin, ugeneric_t *end,
+                                        bool *already_partitioned,
+                                        void_cmp_t cmp)
 {
-    /* Uses quick sort as base algorithm, switches to insertion
-     * sort on small arrays which is expected to be faster.
+    ugeneric_t pivot = *begin;
+    ugeneric_t *first = begin;
+    ugeneric_t *last = end;
+
+    /* Median of three guarantees there is an element >= pivot, so the first
+     * loop needs no bound check. The second one needs it only if no element
+     * was skipped by the first.
      */
-    if (r - l > 1) // terminate if [l, r) defines a single element
+    while (_PDQ_LESS(*++first, pivot));
+    if (first - 1 == begin)
+    {
+        while ((first < last) && !_PDQ_LESS(*--last, pivot));
+    }
+    else
     {
-        if ((r - l) > USORT_HYBRID_THRESHOLD)
+        while (!_PDQ_LESS(*--last, pivot));
+    }
+
+    *already_partitioned = (first >= last);
+    if (!*already_partitioned)
+    {
+        ugeneric_swap(first, last);
+        first++;
+
+        unsigned char offsets_l_buf[_PDQ_BLOCK_SIZE];
+        unsigned char offsets_r_buf[_PDQ_BLOCK_SIZE];
+        unsigned char *offsets_l = offsets_l_buf;
+        unsigned char *offsets_r = offsets_r_buf;
+        ugeneric_t *offsets_l_base = first;
+        ugeneric_t *offsets_r_base = last;
+        size_t num_l = 0;
+        size_t num_r = 0;
+        size_t start_l = 0;
+        size_t start_r = 0;
+
+        while (first < last)
+        {
+            /* Fill up offset blocks with elements on the wrong side. Near the
+             * end the remaining elements are split between the sides.
+             */
+            size_t num_unknown = last - first;
+            size_t left_split = (num_l == 0) ? ((num_r == 0) ? num_unknown / 2 : num_unknown) : 0;
+            size_t right_split = (num_r == 0) ? (num_unknown - left_split) : 0;
+
+            left_split = MIN(left_split, (size_t)_PDQ_BLOCK_SIZE);
+            for (size_t i = 0; i < left_split; i++)
+            {
+                offsets_l[num_l] = i;
+                num_l += !_PDQ_LESS(*first, pivot);
+                first++;
+            }
+
+            right_split = MIN(right_split, (size_t)_PDQ_BLOCK_SIZE);
+            for (size_t i = 0; i < right_split;)
+            {
+                offsets_r[num_r] = ++i;
+                num_r += _PDQ_LESS(*--last, pivot);
+            }
+
+            size_t num = MIN(num_l, num_r);
+            _pdq_swap_offsets(offsets_l_base, offsets_r_base,
+                              offsets_l + start_l, offsets_r + start_r,
+                              num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+
+            if (num_l == 0)
+            {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0)
+            {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        /* At most one of the blocks has elements left, move them to the
+         * boundary.
+         */
+        if (num_l)
         {
-            size_t pi = _hoar_partition(base, l, r, cmp);
-            _hsort(base, l, pi + 1, cmp);
-            _hsort(base, pi + 1, r, cmp);
+            offsets_l += start_l;
+            while (num_l--)
+            {
+                ugeneric_swap(offsets_l_base + offsets_l[num_l], --last);
+            }
+            first = last;
         }
-        else
+        if (num_r)
         {
-            _insertion_sort(base + l, r - l, cmp);
+            offsets_r += start_r;
+            while (num_r--)
+            {
+                ugeneric_swap(offsets_r_base - offsets_r[num_r], first);
+                first++;
+            }
+            last = first;
         }
     }
+
+    ugeneric_t *pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+
+    return pivot_pos;
 }
 
-size_t count_inversions(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+/* Partitions [begin, end) around *begin into [<= pivot][pivot][> pivot].
+ * Used when the element before the range equals the pivot, elements equal
+ * to it then go left and are never touched again.
+ */
+static ugeneric_t *_pdq_partition_left(ugeneric_t *begin, ugeneric_t *end,
+                                       void_cmp_t cmp)
 {
+    ugeneric_t pivot = *begin;
+    ugeneric_t *first = begin;
+    ugeneric_t *last = end;
 
-    size_t inv = 0;
-    if (nmemb > 1)
+    while (_PDQ_LESS(pivot, *--last));
+    if (last + 1 == end)
     {
-        UASSERT_INPUT(base);
-        ugeneric_t *aux = umalloc(nmemb * sizeof(*aux));
-        inv = _merge_sort(base, aux, nmemb, cmp);
-        ufree(aux);
+        while ((first < last) && !_PDQ_LESS(pivot, *++first));
+    }
+    else
+    {
+        while (!_PDQ_LESS(pivot, *++first));
     }
 
-    return inv;
+    while (first < last)
+    {
+        ugeneric_swap(first, last);
+        while (_PDQ_LESS(pivot, *--last));
+        while (!_PDQ_LESS(pivot, *++first));
+    }
+
+    ugeneric_t *pivot_pos = last;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+
+    return pivot_pos;
 }
 
-void quick_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+/* Breaks patterns which make partitions unbalanced by swapping elements
+ * from the quarters of the range into pivot candidate positions.
+ */
+static void _pdq_shuffle(ugeneric_t *begin, ugeneric_t *end)
 {
-    if (nmemb > 1)
+    size_t size = end - begin;
+    size_t q = size / 4;
+
+    ugeneric_swap(begin, begin + q);
+    ugeneric_swap(end - 1, end - q);
+    if (size > _PDQ_NINTHER_THRESHOLD)
     {
-        UASSERT_INPUT(base);
-        _quick_sort(base, 0, nmemb, cmp);
+        ugeneric_swap(begin + 1, begin + (q + 1));
+        ugeneric_swap(begin + 2, begin + (q + 2));
+        ugeneric_swap(end - 2, end - (q + 1));
+        ugeneric_swap(end - 3, end - (q + 2));
     }
 }
 
-void selection_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+/* [begin, end), leftmost is true if there is no element before begin which
+ * is known to be not greater than the elements of the range.
+ */
+static void _pdq_sort(ugeneric_t *begin, ugeneric_t *end, size_t bad_allowed,
+                      bool leftmost, void_cmp_t cmp, ugeneric_type_e ntype)
 {
-    if (nmemb > 1)
+    for (;;)
     {
-        UASSERT_INPUT(base);
-        // the very last element is intentionally omitted
-        for (size_t i = 0; i < nmemb - 1; i++)
+        size_t size = end - begin;
+
+        if ((ntype != G_NULL_T) && (size <= USORT_NETWORK_MAX))
         {
-            size_t min = i;
-            for (size_t j = i + 1; j < nmemb; j++)
+            if (size > 1)
             {
-                if (ugeneric_compare_v(base[min], base[j], cmp) > 0)
-                {
-                    min = j;
-                }
+                _network_sort(begin, size, cmp, ntype);
             }
-            ugeneric_swap(base + min, base + i);
+            return;
+        }
+
+        if (size < USORT_HYBRID_THRESHOLD)
+        {
+            if (leftmost)
+            {
+                _insertion_sort(begin, size, cmp);
+            }
+            else
+            {
+                _pdq_unguarded_insertion_sort(begin, end, cmp);
+            }
+            return;
+        }
+
+        /* Pivot goes to *begin. */
+        size_t s2 = size / 2;
+        if (size > _PDQ_NINTHER_THRESHOLD)
+        {
+            _pdq_sort3(begin, begin + s2, end - 1, cmp);
+            _pdq_sort3(begin + 1, begin + (s2 - 1), end - 2, cmp);
+            _pdq_sort3(begin + 2, begin + (s2 + 1), end - 3, cmp);
+            _pdq_sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), cmp);
+            ugeneric_swap(begin, begin + s2);
+        }
+        else
+        {
+            _pdq_sort3(begin + s2, begin, end - 1, cmp);
+        }
+
+        /* Pivot equal to the predecessor of the range means the range has
+         * many equal elements, they all are put in place at once.
+         */
+        if (!leftmost && !_PDQ_LESS(*(begin - 1), *begin))
+        {
+            begin = _pdq_partition_left(begin, end, cmp) + 1;
+            continue;
+        }
+
+        bool already_partitioned;
+        ugeneric_t *pivot_pos = _pdq_partition_right(begin, end,
+                                                     &already_partitioned, cmp);
+        size_t l_size = pivot_pos - begin;
+        size_t r_size = end - (pivot_pos + 1);
+
+        if ((l_size < size / 8) || (r_size < size / 8))
+        {
+            if (--bad_allowed == 0)
+            {
+                _pdq_heap_sort(begin, size, cmp);
+                return;
+            }
+            if (l_size >= USORT_HYBRID_THRESHOLD)
+            {
+                _pdq_shuffle(begin, pivot_pos);
+            }
+            if (r_size >= USORT_HYBRID_THRESHOLD)
+            {
+                _pdq_shuffle(pivot_pos + 1, end);
+            }
+        }
+        else if (already_partitioned &&
+                 _pdq_partial_insertion_sort(begin, pivot_pos, cmp) &&
+                 _pdq_partial_insertion_sort(pivot_pos + 1, end, cmp))
+        {
+            return;
+        }
+
+        /* Recurse into the smaller part to keep stack depth logarithmic. */
+        if (l_size < r_size)
+        {
+            _pdq_sort(begin, pivot_pos, bad_allowed, leftmost, cmp, ntype);
+            begin = pivot_pos + 1;
+            leftmost = false;
+        }
+        else
+        {
+            _pdq_sort(pivot_pos + 1, end, bad_allowed, false, cmp, ntype);
+            end = pivot_pos;
         }
     }
 }
 
-void merge_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+#undef _PDQ_LESS
+
+/* Introselect: quickselect with median-of-3 (ninther on large ranges)
+ * pivots and three-way partitioning, so that runs of equal elements are
+ * dropped at once. If the range does not shrink fast enough it is heap
+ * sorted, which bounds the worst case by O(n log n).
+ */
+static void _nth_element(ugeneric_t *base, size_t nmemb, size_t nth,
+                         void_cmp_t cmp)
 {
-    if (nmemb > 1)
+    size_t l = 0;
+    size_t r = nmemb;
+    size_t budget = 0;
+
+    while (nmemb >> budget)
     {
-        UASSERT_INPUT(base);
-        ugeneric_t *aux = umalloc(nmemb * sizeof(*aux));
-         _merge_sort(base, aux, nmemb, cmp);
-        ufree(aux);
+        budget++;
+    }
+    budget *= 2;
+
+    while (r - l > USORT_HYBRID_THRESHOLD)
+    {
+        size_t size = r - l;
+        if (budget-- == 0)
+        {
+            _pdq_heap_sort(base + l, size, cmp);
+            return;
+        }
+
+        ugeneric_t *b = base + l;
+        ugeneric_t *e = base + r;
+        size_t s2 = size / 2;
+        if (size > _PDQ_NINTHER_THRESHOLD)
+        {
+            _pdq_sort3(b, b + s2, e - 1, cmp);
+            _pdq_sort3(b + 1, b + (s2 - 1), e - 2, cmp);
+            _pdq_sort3(b + 2, b + (s2 + 1), e - 3, cmp);
+            _pdq_sort3(b + (s2 - 1), b + s2, b + (s2 + 1), cmp);
+        }
+        else
+        {
+            _pdq_sort3(b, b + s2, e - 1, cmp);
+        }
+        ugeneric_swap(b, b + s2);
+
+        // [l, lt) < pivot, [lt, gt) == pivot, [gt, r) > pivot
+        ugeneric_t pivot = base[l];
+        size_t lt = l;
+        size_t gt = r;
+        size_t i = l + 1;
+        while (i < gt)
+        {
+            int c = ugeneric_compare_v(base[i], pivot, cmp);
+            if (c < 0)
+            {
+                ugeneric_swap(base + lt++, base + i++);
+            }
+            else if (c > 0)
+            {
+                ugeneric_swap(base + i, base + --gt);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        if (nth < lt)
+        {
+            r = lt;
+        }
+        else if (nth >= gt)
+        {
+            l = gt;
+        }
+        else
+        {
+            return;
+        }
     }
+
+    _insertion_sort(base + l, r - l, cmp);
 }
 
-void insertion_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+void ugeneric_array_nth_element(ugeneric_t *base, size_t nmemb, size_t nth,
+                                void_cmp_t cmp)
 {
-    if (nmemb > 1)
+    UASSERT_INPUT(nth < nmemb);
+    UASSERT_INPUT(base);
+
+    _nth_element(base, nmemb, nth, cmp);
+}
+
+void ugeneric_array_partial_sort(ugeneric_t *base, size_t nmemb, size_t k,
+                                 void_cmp_t cmp)
+{
+    UASSERT_INPUT(k <= nmemb);
+
+    if (k == 0)
     {
-        UASSERT_INPUT(base);
-        _insertion_sort(base, nmemb, cmp);
+        return;
+    }
+
+    UASSERT_INPUT(base);
+
+    if (k < nmemb)
+    {
+        _nth_element(base, nmemb, k - 1, cmp);
     }
+    hybrid_sort(base, k, cmp);
 }
 
-void hybrid_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+/* TimSort (Tim Peters, as in CPython listsort.txt). Natural runs are found
+ * and extended to minrun with binary insertion sort, then merged keeping
+ * the run length invariants on a stack. Merges switch to galloping when one
+ * run keeps winning, temporary buffer is the size of the smaller run.
+ */
+
+#define _TS_LESS(a, b)      (ugeneric_compare_v((a), (b), cmp) < 0)
+#define _TS_MIN_GALLOP      7
+#define _TS_MAX_RUNS        85   // enough for 2^64 elements
+
+typedef struct {
+    ugeneric_t *base;
+    size_t len;
+} _ts_run_t;
+
+typedef struct {
+    void_cmp_t cmp;
+    size_t min_gallop;
+    ugeneric_t *tmp;
+    size_t tmp_size;
+    _ts_run_t runs[_TS_MAX_RUNS];
+    size_t nruns;
+} _ts_state_t;
+
+static size_t _ts_minrun(size_t n)
 {
-    if (nmemb > 1)
+    size_t r = 0;
+
+    while (n >= 64)
     {
-        UASSERT_INPUT(base);
-        _hsort(base, 0, nmemb, cmp);
+        r |= n & 1;
+        n >>= 1;
+    }
+
+    return n + r;
+}
+
+/* Returns length of the run starting at lo, strictly descending runs are
+ * reversed in place.
+ */
+static size_t _ts_count_run(ugeneric_t *lo, ugeneric_t *hi, void_cmp_t cmp)
+{
+    size_t n = 2;
+
+    if (lo + 1 == hi)
+    {
+        return 1;
+    }
+
+    if (_TS_LESS(lo[1], lo[0]))
+    {
+        while ((lo + n < hi) && _TS_LESS(lo[n], lo[n - 1]))
+        {
+            n++;
+        }
+        for (size_t i = 0, j = n - 1; i < j; i++, j--)
+        {
+            ugeneric_swap(lo + i, lo + j);
+        }
+    }
+    else
+    {
+        while ((lo + n < hi) && !_TS_LESS(lo[n], lo[n - 1]))
+        {
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/* [lo, start) is sorted, inserts [start, hi) into it. */
+static void _ts_binary_insertion_sort(ugeneric_t *lo, ugeneric_t *hi,
+                                      ugeneric_t *start, void_cmp_t cmp)
+{
+    for (; start < hi; start++)
+    {
+        ugeneric_t pivot = *start;
+        ugeneric_t *l = lo;
+        ugeneric_t *r = start;
+        while (l < r)
+        {
+            ugeneric_t *p = l + (r - l) / 2;
+            if (_TS_LESS(pivot, *p))
+            {
+                r = p;
+            }
+            else
+            {
+                l = p + 1;
+            }
+        }
+        memmove(l + 1, l, (start - l) * sizeof(*l));
+        *l = pivot;
+    }
+}
+
+/* Returns k such that a[k - 1] < key <= a[k], search starts at a[hint]. */
+static size_t _ts_gallop_left(ugeneric_t key, const ugeneric_t *a, size_t n,
+                              size_t hint, void_cmp_t cmp)
+{
+    ptrdiff_t lastofs = 0;
+    ptrdiff_t ofs = 1;
+    ptrdiff_t maxofs;
+
+    if (_TS_LESS(a[hint], key))
+    {
+        // a[hint] < key, gallop right until a[hint + lastofs] < key <= a[hint + ofs]
+        maxofs = n - hint;
+        while ((ofs < maxofs) && _TS_LESS(a[hint + ofs], key))
+        {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        ofs = MIN(ofs, maxofs);
+        lastofs += hint;
+        ofs += hint;
+    }
+    else
+    {
+        // key <= a[hint], gallop left until a[hint - ofs] < key <= a[hint - lastofs]
+        maxofs = hint + 1;
+        while ((ofs < maxofs) && !_TS_LESS(a[hint - ofs], key))
+        {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        ofs = MIN(ofs, maxofs);
+        ptrdiff_t k = lastofs;
+        lastofs = hint - ofs;
+        ofs = hint - k;
+    }
+
+    lastofs++;
+    while (lastofs < ofs)
+    {
+        ptrdiff_t m = lastofs + ((ofs - lastofs) >> 1);
+        if (_TS_LESS(a[m], key))
+        {
+            lastofs = m + 1;
+        }
+        else
+        {
+            ofs = m;
+        }
+    }
+
+    return ofs;
+}
+
+/* Returns k such that a[k - 1] <= key < a[k], search starts at a[hint]. */
+static size_t _ts_gallop_right(ugeneric_t key, const ugeneric_t *a, size_t n,
+                               size_t hint, void_cmp_t cmp)
+{
+    ptrdiff_t lastofs = 0;
+    ptrdiff_t ofs = 1;
+    ptrdiff_t maxofs;
+
+    if (_TS_LESS(key, a[hint]))
+    {
+        // key < a[hint], gallop left until a[hint - ofs] <= key < a[hint - lastofs]
+        maxofs = hint + 1;
+        while ((ofs < maxofs) && _TS_LESS(key, a[hint - ofs]))
+        {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        ofs = MIN(ofs, maxofs);
+        ptrdiff_t k = lastofs;
+        lastofs = hint - ofs;
+        ofs = hint - k;
+    }
+    else
+    {
+        // a[hint] <= key, gallop right until a[hint + lastofs] <= key < a[hint + ofs]
+        maxofs = n - hint;
+        while ((ofs < maxofs) && !_TS_LESS(key, a[hint + ofs]))
+        {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        ofs = MIN(ofs, maxofs);
+        lastofs += hint;
+        ofs += hint;
+    }
+
+    lastofs++;
+    while (lastofs < ofs)
+    {
+        ptrdiff_t m = lastofs + ((ofs - lastofs) >> 1);
+        if (_TS_LESS(key, a[m]))
+        {
+            ofs = m;
+        }
+        else
+        {
+            lastofs = m + 1;
+        }
+    }
+
+    return ofs;
+}
+
+static ugeneric_t *_ts_get_tmp(_ts_state_t *ts, size_t size)
+{
+    if (ts->tmp_size < size)
+    {
+        ufree(ts->tmp);
+        ts->tmp = umalloc(size * sizeof(*ts->tmp));
+        ts->tmp_size = size;
+    }
+
+    return ts->tmp;
+}
+
+/* Merges adjacent runs a and b in place, na <= nb, a[0] > b[0] and
+ * a[na - 1] > b[nb - 1]. Run a is moved to the temporary buffer and merged
+ * from the left.
+ */
+static void _ts_merge_lo(_ts_state_t *ts, ugeneric_t *a, size_t na,
+                         ugeneric_t *b, size_t nb)
+{
+    void_cmp_t cmp = ts->cmp;
+    size_t min_gallop = ts->min_gallop;
+    ugeneric_t *dst = a;
+
+    a = memcpy(_ts_get_tmp(ts, na), a, na * sizeof(*a));
+
+    *dst++ = *b++;
+    if (--nb == 0)
+    {
+        goto done;
+    }
+    if (na == 1)
+    {
+        goto copy_b;
+    }
+
+    for (;;)
+    {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        // One pair at a time until one run wins consistently.
+        do
+        {
+            if (_TS_LESS(*b, *a))
+            {
+                *dst++ = *b++;
+                bcount++;
+                acount = 0;
+                if (--nb == 0)
+                {
+                    goto done;
+                }
+            }
+            else
+            {
+                *dst++ = *a++;
+                acount++;
+                bcount = 0;
+                if (--na == 1)
+                {
+                    goto copy_b;
+                }
+            }
+        } while ((acount < min_gallop) && (bcount < min_gallop));
+
+        // Galloping, until neither run wins a long enough streak.
+        min_gallop++;
+        do
+        {
+            min_gallop -= (min_gallop > 1);
+            ts->min_gallop = min_gallop;
+
+            acount = _ts_gallop_right(*b, a, na, 0, cmp);
+            if (acount)
+            {
+                memcpy(dst, a, acount * sizeof(*a));
+                dst += acount;
+                a += acount;
+                na -= acount;
+                if (na == 1)
+                {
+                    goto copy_b;
+                }
+                if (na == 0)
+                {
+                    goto done; // inconsistent comparator
+                }
+            }
+            *dst++ = *b++;
+            if (--nb == 0)
+            {
+                goto done;
+            }
+
+            bcount = _ts_gallop_left(*a, b, nb, 0, cmp);
+            if (bcount)
+            {
+                memmove(dst, b, bcount * sizeof(*b));
+                dst += bcount;
+                b += bcount;
+                nb -= bcount;
+                if (nb == 0)
+                {
+                    goto done;
+                }
+            }
+            *dst++ = *a++;
+            if (--na == 1)
+            {
+                goto copy_b;
+            }
+        } while ((acount >= _TS_MIN_GALLOP) || (bcount >= _TS_MIN_GALLOP));
+        min_gallop++;
+        ts->min_gallop = min_gallop;
+    }
+
+done:
+    if (na)
+    {
+        memcpy(dst, a, na * sizeof(*a));
+    }
+    return;
+
+copy_b:
+    // The last element of a belongs at the end of the merge.
+    memmove(dst, b, nb * sizeof(*b));
+    dst[nb] = *a;
+}
+
+/* Same as _ts_merge_lo() for na > nb, run b is moved to the temporary
+ * buffer and merged from the right.
+ */
+static void _ts_merge_hi(_ts_state_t *ts, ugeneric_t *a, size_t na,
+                         ugeneric_t *b, size_t nb)
+{
+    void_cmp_t cmp = ts->cmp;
+    size_t min_gallop = ts->min_gallop;
+    ugeneric_t *dst = b + nb - 1;
+    ugeneric_t *base_a = a;
+    ugeneric_t *base_b = memcpy(_ts_get_tmp(ts, nb), b, nb * sizeof(*b));
+
+    a += na - 1;
+    b = base_b + nb - 1;
+
+    *dst-- = *a--;
+    if (--na == 0)
+    {
+        goto done;
+    }
+    if (nb == 1)
+    {
+        goto copy_a;
+    }
+
+    for (;;)
+    {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        do
+        {
+            if (_TS_LESS(*b, *a))
+            {
+                *dst-- = *a--;
+                acount++;
+                bcount = 0;
+                if (--na == 0)
+                {
+                    goto done;
+                }
+            }
+            else
+            {
+                *dst-- = *b--;
+                bcount++;
+                acount = 0;
+                if (--nb == 1)
+                {
+                    goto copy_a;
+                }
+            }
+        } while ((acount < min_gallop) && (bcount < min_gallop));
+
+        min_gallop++;
+        do
+        {
+            min_gallop -= (min_gallop > 1);
+            ts->min_gallop = min_gallop;
+
+            acount = na - _ts_gallop_right(*b, base_a, na, na - 1, cmp);
+            if (acount)
+            {
+                dst -= acount;
+                a -= acount;
+                memmove(dst + 1, a + 1, acount * sizeof(*a));
+                na -= acount;
+                if (na == 0)
+                {
+                    goto done;
+                }
+            }
+            *dst-- = *b--;
+            if (--nb == 1)
+            {
+                goto copy_a;
+            }
+
+            bcount = nb - _ts_gallop_left(*a, base_b, nb, nb - 1, cmp);
+            if (bcount)
+            {
+                dst -= bcount;
+                b -= bcount;
+                memcpy(dst + 1, b + 1, bcount * sizeof(*b));
+                nb -= bcount;
+                if (nb == 1)
+                {
+                    goto copy_a;
+                }
+                if (nb == 0)
+                {
+                    goto done; // inconsistent comparator
+                }
+            }
+            *dst-- = *a--;
+            if (--na == 0)
+            {
+                goto done;
+            }
+        } while ((acount >= _TS_MIN_GALLOP) || (bcount >= _TS_MIN_GALLOP));
+        min_gallop++;
+        ts->min_gallop = min_gallop;
+    }
+
+done:
+    if (nb)
+    {
+        memcpy(dst - (nb - 1), base_b, nb * sizeof(*b));
+    }
+    return;
+
+copy_a:
+    // The first element of b belongs at the front of the merge.
+    dst -= na;
+    a -= na;
+    memmove(dst + 1, a + 1, na * sizeof(*a));
+    *dst = *b;
+}
+
+static void _ts_merge_at(_ts_state_t *ts, size_t i)
+{
+    void_cmp_t cmp = ts->cmp;
+    ugeneric_t *a = ts->runs[i].base;
+    size_t na = ts->runs[i].len;
+    ugeneric_t *b = ts->runs[i + 1].base;
+    size_t nb = ts->runs[i + 1].len;
+
+    ts->runs[i].len = na + nb;
+    if (i == ts->nruns - 3)
+    {
+        ts->runs[i + 1] = ts->runs[i + 2];
+    }
+    ts->nruns--;
+
+    // Elements of a which are not greater than b[0] are already in place.
+    size_t k = _ts_gallop_right(b[0], a, na, 0, cmp);
+    a += k;
+    na -= k;
+    if (na == 0)
+    {
+        return;
+    }
+
+    // Elements of b which are not less than a[na - 1] are already in place.
+    nb = _ts_gallop_left(a[na - 1], b, nb, nb - 1, cmp);
+    if (nb == 0)
+    {
+        return;
+    }
+
+    if (na <= nb)
+    {
+        _ts_merge_lo(ts, a, na, b, nb);
+    }
+    else
+    {
+        _ts_merge_hi(ts, a, na, b, nb);
+    }
+}
+
+/* Keeps run lengths on the stack such that each is greater than the sum of
+ * the next two, checking one level deeper than the original TimSort does so
+ * that the invariant really holds for the whole stack.
+ */
+static void _ts_merge_collapse(_ts_state_t *ts)
+{
+    _ts_run_t *r = ts->runs;
+
+    while (ts->nruns > 1)
+    {
+        size_t i = ts->nruns - 2;
+        if (((i > 0) && (r[i - 1].len <= r[i].len + r[i + 1].len)) ||
+            ((i > 1) && (r[i - 2].len <= r[i - 1].len + r[i].len)))
+        {
+            if (r[i - 1].len < r[i + 1].len)
+            {
+                i--;
+            }
+        }
+        else if (r[i].len > r[i + 1].len)
+        {
+            break;
+        }
+        _ts_merge_at(ts, i);
+    }
+}
+
+static void _ts_merge_force_collapse(_ts_state_t *ts)
+{
+    _ts_run_t *r = ts->runs;
+
+    while (ts->nruns > 1)
+    {
+        size_t i = ts->nruns - 2;
+        if ((i > 0) && (r[i - 1].len < r[i + 1].len))
+        {
+            i--;
+        }
+        _ts_merge_at(ts, i);
+    }
+}
+
+#undef _TS_LESS
+
+size_t count_inversions(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+
+    size_t inv = 0;
+    if (nmemb > 1)
+    {
+        UASSERT_INPUT(base);
+        ugeneric_t *aux = umalloc(nmemb * sizeof(*aux));
+        inv = _merge_sort(base, aux, nmemb, cmp, G_NULL_T);
+        ufree(aux);
+    }
+
+    return inv;
+}
+
+void quick_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    if (nmemb > 1)
+    {
+        UASSERT_INPUT(base);
+        _quick_sort(base, 0, nmemb, cmp, _get_numeric_type(base, nmemb));
+    }
+}
+
+void selection_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    if (nmemb > 1)
+    {
+        UASSERT_INPUT(base);
+        // the very last element is intentionally omitted
+        for (size_t i = 0; i < nmemb - 1; i++)
+        {
+            size_t min = i;
+            for (size_t j = i + 1; j < nmemb; j++)
+            {
+                if (ugeneric_compare_v(base[min], base[j], cmp) > 0)
+                {
+                    min = j;
+                }
+            }
+            ugeneric_swap(base + min, base + i);
+        }
+    }
+}
+
+void merge_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    if (nmemb > 1)
+    {
+        UASSERT_INPUT(base);
+        ugeneric_t *aux = umalloc(nmemb * sizeof(*aux));
+        /* Sorting networks are not stable, but equal integers are
+         * indistinguishable, unlike -0.0 and 0.0.
+         */
+        ugeneric_type_e ntype = _get_numeric_type(base, nmemb);
+        if (ntype == G_REAL_T)
+        {
+            ntype = G_NULL_T;
+        }
+        _merge_sort(base, aux, nmemb, cmp, ntype);
+        ufree(aux);
+    }
+}
+
+void network_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    UASSERT_INPUT(nmemb <= USORT_NETWORK_MAX);
+
+    if (nmemb > 1)
+    {
+        UASSERT_INPUT(base);
+        _network_sort(base, nmemb, cmp, _get_numeric_type(base, nmemb));
+    }
+}
+
+void insertion_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    if (nmemb > 1)
+    {
+        UASSERT_INPUT(base);
+        _insertion_sort(base, nmemb, cmp);
+    }
+}
+
+void hybrid_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    if (nmemb > 1)
+    {
+        UASSERT_INPUT(base);
+        size_t bad_allowed = 1;
+        while (nmemb >> bad_allowed)
+        {
+            bad_allowed++;
+        }
+        _pdq_sort(base, base + nmemb, bad_allowed, true, cmp,
+                  _get_numeric_type(base, nmemb));
+    }
+}
+
+void timsort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    if (nmemb < 2)
+    {
+        return;
+    }
+
+    UASSERT_INPUT(base);
+
+    _ts_state_t ts = {0};
+    ts.cmp = cmp;
+    ts.min_gallop = _TS_MIN_GALLOP;
+
+    ugeneric_t *lo = base;
+    ugeneric_t *hi = base + nmemb;
+    size_t minrun = _ts_minrun(nmemb);
+
+    while (lo < hi)
+    {
+        size_t n = _ts_count_run(lo, hi, cmp);
+        if (n < minrun)
+        {
+            size_t force = MIN((size_t)(hi - lo), minrun);
+            _ts_binary_insertion_sort(lo, lo + force, lo + n, cmp);
+            n = force;
+        }
+
+        ts.runs[ts.nruns].base = lo;
+        ts.runs[ts.nruns].len = n;
+        ts.nruns++;
+        _ts_merge_collapse(&ts);
+        lo += n;
+    }
+    _ts_merge_force_collapse(&ts);
+
+    ufree(ts.tmp);
+}
+
+static ugeneric_type_e _get_numeric_type(const ugeneric_t *base, size_t nmemb)
+{
+    ugeneric_type_e type = ugeneric_get_type(base[0]);
+
+    if ((type != G_INT_T) && (type != G_SIZE_T) && (type != G_REAL_T))
+    {
+        return G_NULL_T;
+    }
+
+    for (size_t i = 1; i < nmemb; i++)
+    {
+        if (ugeneric_get_type(base[i]) != type)
+        {
+            return G_NULL_T;
+        }
+    }
+
+    return type;
+}
+
+/* Maps element to an unsigned key which orders the same way as the element.
+ * Integers get the sign bit flipped. Non-negative doubles get the sign bit
+ * set, negative ones are inverted entirely so that larger magnitude goes
+ * first.
+ */
+static inline uint64_t _radix_key(ugeneric_t g, ugeneric_type_e type)
+{
+    uint64_t key;
+
+    switch (type)
+    {
+        case G_INT_T:
+            return (uint64_t)(int64_t)G_AS_INT(g) ^ (UINT64_C(1) << 63);
+
+        case G_SIZE_T:
+            return (uint64_t)G_AS_SIZE(g);
+
+        default:
+            if (G_AS_REAL(g) != G_AS_REAL(g))
+            {
+                UABORT("NAN in comparison");
+            }
+            memcpy(&key, &G_AS_REAL(g), sizeof(key));
+            return (key >> 63) ? ~key : (key | (UINT64_C(1) << 63));
+    }
+}
+
+static void _radix_sort(ugeneric_t *base, size_t nmemb, ugeneric_type_e type)
+{
+    enum {RADIX = 256, DIGITS = sizeof(uint64_t)};
+    size_t (*counts)[RADIX] = ucalloc(DIGITS, sizeof(*counts));
+
+    /* All histograms are built in a single pass, passes over bytes which are
+     * the same in all keys are skipped afterwards.
+     */
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        uint64_t key = _radix_key(base[i], type);
+        for (size_t d = 0; d < DIGITS; d++)
+        {
+            counts[d][(key >> (d * 8)) & 0xff]++;
+        }
+    }
+
+    ugeneric_t *aux = umalloc_large(nmemb * sizeof(*aux));
+    ugeneric_t *src = base;
+    ugeneric_t *dst = aux;
+
+    for (size_t d = 0; d < DIGITS; d++)
+    {
+        size_t *count = counts[d];
+        uint64_t digit = (_radix_key(base[0], type) >> (d * 8)) & 0xff;
+        if (count[digit] == nmemb)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t i = 0; i < RADIX; i++)
+        {
+            size_t c = count[i];
+            count[i] = offset;
+            offset += c;
+        }
+
+        for (size_t i = 0; i < nmemb; i++)
+        {
+            digit = (_radix_key(src[i], type) >> (d * 8)) & 0xff;
+            dst[count[digit]++] = src[i];
+        }
+
+        ugeneric_t *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != base)
+    {
+        memcpy(base, src, nmemb * sizeof(*base));
+    }
+
+    ufree_large(aux, nmemb * sizeof(*aux));
+    ufree(counts);
+}
+
+bool radix_sort_supports(const ugeneric_t *base, size_t nmemb)
+{
+    if (nmemb < USORT_RADIX_THRESHOLD)
+    {
+        return false;
+    }
+
+    UASSERT_INPUT(base);
+
+    return _get_numeric_type(base, nmemb) != G_NULL_T;
+}
+
+void radix_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp)
+{
+    ugeneric_type_e type = G_NULL_T;
+
+    if (nmemb >= USORT_RADIX_THRESHOLD)
+    {
+        UASSERT_INPUT(base);
+        type = _get_numeric_type(base, nmemb);
+    }
+
+    if (type != G_NULL_T)
+    {
+        _radix_sort(base, nmemb, type);
+    }
+    else
+    {
+        hybrid_sort(base, nmemb, cmp);
+    }
+}
+
+/* Key sort extracts keys once and sorts (prefix, key, index) records. The
+ * prefix is a 64-bit unsigned number which orders the same way as the key
+ * for numeric keys and as the first 8 bytes of a string for string keys.
+ * Records with numeric keys of a single type are radix sorted by the prefix
+ * alone, otherwise records are merge sorted comparing key types, then
+ * prefixes, and only then full keys with ugeneric_compare_v().
+ */
+
+typedef struct {
+    uint64_t prefix;
+    ugeneric_t key;
+    size_t idx;
+} _key_rec_t;
+
+static inline ugeneric_type_e _key_rank(ugeneric_t g)
+{
+    ugeneric_type_e type = ugeneric_get_type(g);
+    return (type == G_CSTR_T) ? G_STR_T : type;
+}
+
+static uint64_t _key_prefix(ugeneric_t g)
+{
+    uint64_t prefix = 0;
+
+    switch (ugeneric_get_type(g))
+    {
+        case G_INT_T:
+        case G_SIZE_T:
+        case G_REAL_T:
+            return _radix_key(g, ugeneric_get_type(g));
+
+        case G_STR_T:
+        case G_CSTR_T:
+            for (size_t i = 0; (i < sizeof(prefix)) && G_AS_STR(g)[i]; i++)
+            {
+                prefix |= (uint64_t)(unsigned char)G_AS_STR(g)[i] << (56 - i * 8);
+            }
+            return prefix;
+
+        case G_ERROR_T:
+            UABORT("attempt to compare G_ERROR object");
+
+        default:
+            return 0;
+    }
+}
+
+static inline int _key_rec_cmp(const _key_rec_t *r1, const _key_rec_t *r2,
+                               void_cmp_t cmp)
+{
+    ugeneric_type_e t1 = _key_rank(r1->key);
+    ugeneric_type_e t2 = _key_rank(r2->key);
+
+    if (t1 != t2)
+    {
+        return (t1 < t2) ? -1 : 1;
+    }
+    if (r1->prefix != r2->prefix)
+    {
+        return (r1->prefix < r2->prefix) ? -1 : 1;
+    }
+    if ((t1 == G_INT_T) || (t1 == G_REAL_T) || (t1 == G_SIZE_T))
+    {
+        return 0;
+    }
+
+    return ugeneric_compare_v(r1->key, r2->key, cmp);
+}
+
+/* Stable, result is left in recs. */
+static void _key_rec_merge_sort(_key_rec_t *recs, _key_rec_t *aux, size_t n,
+                                void_cmp_t cmp)
+{
+    if (n < USORT_HYBRID_THRESHOLD)
+    {
+        for (size_t i = 1; i < n; i++)
+        {
+            _key_rec_t t = recs[i];
+            size_t j = i;
+            while ((j > 0) && (_key_rec_cmp(&recs[j - 1], &t, cmp) > 0))
+            {
+                recs[j] = recs[j - 1];
+                j--;
+            }
+            recs[j] = t;
+        }
+        return;
+    }
+
+    size_t m = n / 2;
+    _key_rec_merge_sort(recs, aux, m, cmp);
+    _key_rec_merge_sort(recs + m, aux, n - m, cmp);
+    if (_key_rec_cmp(&recs[m - 1], &recs[m], cmp) <= 0)
+    {
+        return;
+    }
+
+    size_t i = 0;
+    size_t j = m;
+    size_t k = 0;
+    while ((i < m) && (j < n))
+    {
+        aux[k++] = (_key_rec_cmp(&recs[j], &recs[i], cmp) < 0) ? recs[j++] : recs[i++];
+    }
+    while (i < m) { aux[k++] = recs[i++]; }
+    memcpy(recs, aux, k * sizeof(*recs));
+}
+
+/* Stable LSD radix sort by prefix, result is left in recs. */
+static void _key_rec_radix_sort(_key_rec_t *recs, _key_rec_t *aux, size_t n)
+{
+    enum {RADIX = 256, DIGITS = sizeof(uint64_t)};
+    size_t (*counts)[RADIX] = ucalloc(DIGITS, sizeof(*counts));
+
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t d = 0; d < DIGITS; d++)
+        {
+            counts[d][(recs[i].prefix >> (d * 8)) & 0xff]++;
+        }
+    }
+
+    _key_rec_t *src = recs;
+    _key_rec_t *dst = aux;
+    for (size_t d = 0; d < DIGITS; d++)
+    {
+        size_t *count = counts[d];
+        if (count[(recs[0].prefix >> (d * 8)) & 0xff] == n)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t i = 0; i < RADIX; i++)
+        {
+            size_t c = count[i];
+            count[i] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            dst[count[(src[i].prefix >> (d * 8)) & 0xff]++] = src[i];
+        }
+
+        _key_rec_t *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != recs)
+    {
+        memcpy(recs, src, n * sizeof(*recs));
+    }
+
+    ufree(counts);
+}
+
+void key_sort(ugeneric_t *base, size_t nmemb, ugeneric_key_extractor_t key,
+              void *ctx, void_cmp_t cmp)
+{
+    UASSERT_INPUT(key);
+
+    if (nmemb < 2)
+    {
+        return;
+    }
+
+    UASSERT_INPUT(base);
+
+    _key_rec_t *recs = umalloc_large(nmemb * sizeof(*recs));
+    _key_rec_t *aux = umalloc_large(nmemb * sizeof(*aux));
+    bool is_numeric = true;
+
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        recs[i].key = key(base[i], ctx);
+        recs[i].prefix = _key_prefix(recs[i].key);
+        recs[i].idx = i;
+        ugeneric_type_e type = ugeneric_get_type(recs[i].key);
+        is_numeric = is_numeric &&
+                     ((type == G_INT_T) || (type == G_REAL_T) || (type == G_SIZE_T)) &&
+                     (type == ugeneric_get_type(recs[0].key));
+    }
+
+    if (is_numeric)
+    {
+        _key_rec_radix_sort(recs, aux, nmemb);
+    }
+    else
+    {
+        _key_rec_merge_sort(recs, aux, nmemb, cmp);
+    }
+
+    /* Records are no longer needed at this point, aux buffer is reused for
+     * the permuted elements.
+     */
+    ugeneric_t *sorted = (ugeneric_t *)aux;
+    for (size_t i = 0; i < nmemb; i++)
+    {
+        sorted[i] = base[recs[i].idx];
+    }
+    memcpy(base, sorted, nmemb * sizeof(*base));
+
+    ufree_large(aux, nmemb * sizeof(*aux));
+    ufree_large(recs, nmemb * sizeof(*recs));
+}
+
+static ugeneric_t _field_key(ugeneric_t g, void *field)
+{
+    UASSERT_INPUT(G_IS_DICT(g));
+    return udict_get(G_AS_PTR(g), G_CSTR(field), G_NULL());
+}
+
+void field_sort(ugeneric_t *base, size_t nmemb, const char *field)
+{
+    UASSERT_INPUT(field);
+    key_sort(base, nmemb, _field_key, (void *)field, NULL);
+}
+
+static size_t _sort_threads = 1;
+
+void libugeneric_set_sort_threads(size_t nthreads)
+{
+    _sort_threads = nthreads;
+}
+
+size_t libugeneric_get_sort_threads(void)
+{
+    return _sort_threads;
+}
+
+static size_t _get_online_cpus(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (size_t)n : 1;
+}
+
+typedef struct {
+    ugeneric_t *base;   // chunk to sort or left run to merge
+    size_t lsize;
+    size_t rsize;       // right run follows the left one, 0 for sort tasks
+    ugeneric_t *dst;    // destination of merge
+    void_cmp_t cmp;
+    pthread_t tid;
+    bool is_spawned;
+} _psort_task_t;
+
+static void *_psort_worker(void *arg)
+{
+    _psort_task_t *task = arg;
+
+    if (task->dst)
+    {
+        _merge(task->base, task->lsize, task->base + task->lsize, task->rsize,
+               task->dst, task->cmp);
+    }
+    else
+    {
+        hybrid_sort(task->base, task->lsize, task->cmp);
+    }
+
+    return NULL;
+}
+
+static void _psort_run(_psort_task_t *tasks, size_t ntasks)
+{
+    /* The last task is executed by the calling thread, as well as any task
+     * the thread could not be spawned for.
+     */
+    for (size_t i = 0; i < ntasks; i++)
+    {
+        tasks[i].is_spawned = (i < ntasks - 1) &&
+            (pthread_create(&tasks[i].tid, NULL, _psort_worker, &tasks[i]) == 0);
+        if (!tasks[i].is_spawned)
+        {
+            _psort_worker(&tasks[i]);
+        }
+    }
+
+    for (size_t i = 0; i < ntasks; i++)
+    {
+        if (tasks[i].is_spawned)
+        {
+            pthread_join(tasks[i].tid, NULL);
+        }
+    }
+}
+
+void parallel_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp,
+                   size_t nthreads)
+{
+    parallel_sort_ext(base, nmemb, cmp, nthreads, NULL);
+}
+
+void parallel_sort_ext(ugeneric_t *base, size_t nmemb, void_cmp_t cmp,
+                       size_t nthreads, ugeneric_t *aux)
+{
+    if (nthreads == 0)
+    {
+        nthreads = _get_online_cpus();
+    }
+
+    if ((nmemb < USORT_PARALLEL_THRESHOLD) || (nthreads < 2))
+    {
+        hybrid_sort(base, nmemb, cmp);
+        return;
+    }
+
+    UASSERT_INPUT(base);
+
+    size_t nruns = MIN(nthreads, nmemb / (USORT_PARALLEL_THRESHOLD / 2));
+    size_t *bounds = umalloc((nruns + 1) * sizeof(*bounds));
+    _psort_task_t *tasks = umalloc(nruns * sizeof(*tasks));
+    bool is_aux_owned = !aux;
+    if (is_aux_owned)
+    {
+        aux = umalloc_large(nmemb * sizeof(*aux));
+    }
+
+    for (size_t i = 0; i <= nruns; i++)
+    {
+        bounds[i] = nmemb / nruns * i + MIN(i, nmemb % nruns);
+    }
+
+    for (size_t i = 0; i < nruns; i++)
+    {
+        tasks[i].base = base + bounds[i];
+        tasks[i].lsize = bounds[i + 1] - bounds[i];
+        tasks[i].rsize = 0;
+        tasks[i].dst = NULL;
+        tasks[i].cmp = cmp;
+    }
+    _psort_run(tasks, nruns);
+
+    /* Merge adjacent runs pairwise until a single one is left, ping-ponging
+     * between the input array and the auxiliary buffer. Run bounds are the
+     * same in both of them.
+     */
+    ugeneric_t *src = base;
+    ugeneric_t *dst = aux;
+    while (nruns > 1)
+    {
+        size_t ntasks = 0;
+        size_t i;
+        for (i = 0; i + 1 < nruns; i += 2)
+        {
+            tasks[ntasks].base = src + bounds[i];
+            tasks[ntasks].lsize = bounds[i + 1] - bounds[i];
+            tasks[ntasks].rsize = bounds[i + 2] - bounds[i + 1];
+            tasks[ntasks].dst = dst + bounds[i];
+            tasks[ntasks].cmp = cmp;
+            bounds[ntasks++] = bounds[i];
+        }
+        if (i < nruns)
+        {
+            // Odd run out is carried over as is.
+            memcpy(dst + bounds[i], src + bounds[i],
+                   (bounds[i + 1] - bounds[i]) * sizeof(*dst));
+            bounds[ntasks] = bounds[i];
+            bounds[ntasks + 1] = bounds[i + 1];
+            nruns = ntasks + 1;
+        }
+        else
+        {
+            bounds[ntasks] = bounds[i];
+            nruns = ntasks;
+        }
+        _psort_run(tasks, ntasks);
+
+        ugeneric_t *t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != base)
+    {
+        memcpy(base, src, nmemb * sizeof(*base));
+    }
+
+    if (is_aux_owned)
+    {
+        ufree_large(aux, nmemb * sizeof(*aux));
     }
+    ufree(tasks);
+    ufree(bounds);
 }
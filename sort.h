@@ -3,13 +3,104 @@
 
 #include "generic.h"
 
-#define USORT_HYBRID_THRESHOLD 4
+/* Ranges shorter than this are finished with insertion sort by
+ * hybrid_sort().
+ */
+#ifndef USORT_HYBRID_THRESHOLD
+#define USORT_HYBRID_THRESHOLD 24
+#endif
+
+/* Largest array size sorting networks are available for. */
+#define USORT_NETWORK_MAX 16
+
+/* Radix sort does not pay off on shorter arrays, they are sorted with
+ * hybrid_sort().
+ */
+#ifndef USORT_RADIX_THRESHOLD
+#define USORT_RADIX_THRESHOLD 64
+#endif
+
+/* Arrays shorter than this are sorted by parallel_sort() on the calling
+ * thread, spawning threads does not pay off for them.
+ */
+#ifndef USORT_PARALLEL_THRESHOLD
+#define USORT_PARALLEL_THRESHOLD (1 << 16)
+#endif
 
 void quick_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
 void merge_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
 void insertion_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
+/* Sorting network for at most USORT_NETWORK_MAX elements, branchless if all
+ * elements are G_INT_T, G_SIZE_T or G_REAL_T. Not stable.
+ */
+void network_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
 void selection_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
 size_t count_inversions(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
+/* Pattern-defeating quicksort: O(n log n) worst case, close to O(n) on
+ * sorted and all-equal input, not stable.
+ */
 void hybrid_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
 
+/* Rearranges elements so that base[nth] is the element which would be there
+ * if the array was sorted, elements before it are not greater and elements
+ * after it are not less. O(n) on average, O(n log n) in the worst case.
+ */
+void ugeneric_array_nth_element(ugeneric_t *base, size_t nmemb, size_t nth,
+                                void_cmp_t cmp);
+
+/* Puts k smallest elements sorted to the beginning of the array, order of
+ * the rest is unspecified. O(n + k log k).
+ */
+void ugeneric_array_partial_sort(ugeneric_t *base, size_t nmemb, size_t k,
+                                 void_cmp_t cmp);
+
+/* TimSort: stable, O(n) on sorted and reverse sorted input and fast on data
+ * consisting of a few ordered runs. Temporary buffer is at most nmemb / 2
+ * elements.
+ */
+void timsort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
+
+/* LSD radix sort by bytes for arrays where all elements are of the same
+ * numeric type (G_INT_T, G_SIZE_T or G_REAL_T), other arrays are sorted with
+ * hybrid_sort(). Order is the same as of ugeneric_compare_v() except that
+ * -0.0 goes before 0.0, NaN aborts. Needs an auxiliary buffer of nmemb
+ * elements. radix_sort_supports() tells if the radix path is taken.
+ */
+void radix_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp);
+bool radix_sort_supports(const ugeneric_t *base, size_t nmemb);
+
+/* Stable sort by keys which are extracted once per element instead of once
+ * per comparison. Numeric keys of a single type are radix sorted, other
+ * keys are compared by a 64-bit normalized prefix first and fully only on
+ * prefix ties. cmp is used to compare G_PTR keys. Keys must stay valid
+ * until the sort is done and are not freed by it.
+ */
+void key_sort(ugeneric_t *base, size_t nmemb, ugeneric_key_extractor_t key,
+              void *ctx, void_cmp_t cmp);
+
+/* key_sort() of an array of dicts by the value of the given key, elements
+ * missing the key go first.
+ */
+void field_sort(ugeneric_t *base, size_t nmemb, const char *field);
+
+/* Parallel merge sort: array is split into nthreads chunks which are sorted
+ * with hybrid_sort() concurrently and then merged pairwise, each merge of a
+ * round running in its own thread. Stable across chunk boundaries only, i.e.
+ * not stable in general. nthreads == 0 means the number of online CPUs.
+ * The comparator must be safe to call concurrently.
+ */
+void parallel_sort(ugeneric_t *base, size_t nmemb, void_cmp_t cmp,
+                   size_t nthreads);
+/* Same as parallel_sort() with a caller provided buffer of nmemb elements
+ * for the merges, NULL makes it allocated.
+ */
+void parallel_sort_ext(ugeneric_t *base, size_t nmemb, void_cmp_t cmp,
+                       size_t nthreads, ugeneric_t *aux);
+
+/* Number of threads uvector_sort() uses with the default sorter, 1 (default)
+ * means sort serially, 0 means the number of online CPUs.
+ */
+void libugeneric_set_sort_threads(size_t nthreads);
+size_t libugeneric_get_sort_threads(void);
+
 #endif
@@ -0,0 +1,318 @@
+#include "spsc.h"
+
+#include "asserts.h"
+#include "mem.h"
+
+#include <sched.h>
+#include <stdatomic.h>
+
+/*
+ * head and tail are free running counters, element i lives in
+ * cells[i & mask] and the queue holds tail - head elements.
+ *
+ *     consumer --> [head][e][e][...][e][tail - 1] <-- producer
+ */
+
+struct uspsc_queue_opaq {
+    uvoid_handlers_t void_handlers;
+    bool is_data_owner;
+    ugeneric_t *cells;
+    size_t mask;
+
+    // Written by the consumer.
+    _Alignas(UCACHE_LINE_SIZE) atomic_size_t head;
+    size_t cached_tail;
+
+    // Written by the producer.
+    _Alignas(UCACHE_LINE_SIZE) atomic_size_t tail;
+    size_t cached_head;
+};
+
+static inline size_t _load(const atomic_size_t *a, memory_order order)
+{
+    return atomic_load_explicit((atomic_size_t *)a, order);
+}
+
+uspsc_queue_t *uspsc_queue_create(size_t capacity)
+{
+    UASSERT_INPUT(capacity);
+    UASSERT_INPUT(capacity <= (SIZE_MAX / 2 + 1) / sizeof(ugeneric_t));
+
+    size_t c = 1;
+    while (c < capacity)
+    {
+        c <<= 1;
+    }
+
+    uspsc_queue_t *q = umalloc_aligned(UCACHE_LINE_SIZE, sizeof(*q));
+    memset(&q->void_handlers, 0, sizeof(q->void_handlers));
+    q->is_data_owner = true;
+    q->cells = umalloc_large(c * sizeof(q->cells[0]));
+    q->mask = c - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->cached_tail = 0;
+    q->cached_head = 0;
+
+    return q;
+}
+
+void uspsc_queue_destroy(uspsc_queue_t *q)
+{
+    if (q)
+    {
+        uspsc_queue_clear(q);
+        ufree_large(q->cells, (q->mask + 1) * sizeof(q->cells[0]));
+        ufree(q);
+    }
+}
+
+void uspsc_queue_clear(uspsc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    size_t tail = _load(&q->tail, memory_order_relaxed);
+    if (q->is_data_owner)
+    {
+        for (size_t i = _load(&q->head, memory_order_relaxed); i != tail; i++)
+        {
+            ugeneric_destroy_v(q->cells[i & q->mask], q->void_handlers.dtr);
+        }
+    }
+    atomic_store_explicit(&q->head, tail, memory_order_relaxed);
+    q->cached_tail = tail;
+    q->cached_head = tail;
+}
+
+/* Room the producer can fill without waiting, refreshes the cached head
+ * only if the cached value shows less than wanted.
+ */
+static size_t _get_room(uspsc_queue_t *q, size_t tail, size_t wanted)
+{
+    size_t capacity = q->mask + 1;
+    size_t room = capacity - (tail - q->cached_head);
+    if (room < wanted)
+    {
+        q->cached_head = _load(&q->head, memory_order_acquire);
+        room = capacity - (tail - q->cached_head);
+    }
+
+    return room;
+}
+
+// Same as _get_room() for elements available to the consumer.
+static size_t _get_available(uspsc_queue_t *q, size_t head, size_t wanted)
+{
+    size_t available = q->cached_tail - head;
+    if (available < wanted)
+    {
+        q->cached_tail = _load(&q->tail, memory_order_acquire);
+        available = q->cached_tail - head;
+    }
+
+    return available;
+}
+
+bool uspsc_queue_try_enq(uspsc_queue_t *q, ugeneric_t e)
+{
+    UASSERT_INPUT(q);
+
+    size_t tail = _load(&q->tail, memory_order_relaxed);
+    if (_get_room(q, tail, 1) == 0)
+    {
+        return false;
+    }
+    q->cells[tail & q->mask] = e;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+bool uspsc_queue_try_deq(uspsc_queue_t *q, ugeneric_t *e)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(e);
+
+    size_t head = _load(&q->head, memory_order_relaxed);
+    if (_get_available(q, head, 1) == 0)
+    {
+        return false;
+    }
+    *e = q->cells[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+bool uspsc_queue_try_peek(uspsc_queue_t *q, ugeneric_t *e)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(e);
+
+    size_t head = _load(&q->head, memory_order_relaxed);
+    if (_get_available(q, head, 1) == 0)
+    {
+        return false;
+    }
+    *e = q->cells[head & q->mask];
+
+    return true;
+}
+
+void uspsc_queue_enq(uspsc_queue_t *q, ugeneric_t e)
+{
+    while (!uspsc_queue_try_enq(q, e))
+    {
+        sched_yield();
+    }
+}
+
+ugeneric_t uspsc_queue_deq(uspsc_queue_t *q)
+{
+    ugeneric_t e;
+    while (!uspsc_queue_try_deq(q, &e))
+    {
+        sched_yield();
+    }
+
+    return e;
+}
+
+size_t uspsc_queue_enq_batch(uspsc_queue_t *q, const ugeneric_t *elements,
+                             size_t n)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(elements || !n);
+
+    size_t tail = _load(&q->tail, memory_order_relaxed);
+    size_t room = _get_room(q, tail, n);
+    n = MIN(n, room);
+    if (n)
+    {
+        size_t i = tail & q->mask;
+        size_t first = MIN(n, q->mask + 1 - i);
+        memcpy(&q->cells[i], elements, first * sizeof(elements[0]));
+        memcpy(q->cells, &elements[first], (n - first) * sizeof(elements[0]));
+        atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+    }
+
+    return n;
+}
+
+size_t uspsc_queue_deq_batch(uspsc_queue_t *q, ugeneric_t *elements,
+                             size_t n)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(elements || !n);
+
+    size_t head = _load(&q->head, memory_order_relaxed);
+    size_t available = _get_available(q, head, n);
+    n = MIN(n, available);
+    if (n)
+    {
+        size_t i = head & q->mask;
+        size_t first = MIN(n, q->mask + 1 - i);
+        memcpy(elements, &q->cells[i], first * sizeof(elements[0]));
+        memcpy(&elements[first], q->cells, (n - first) * sizeof(elements[0]));
+        atomic_store_explicit(&q->head, head + n, memory_order_release);
+    }
+
+    return n;
+}
+
+size_t uspsc_queue_get_size(const uspsc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    // Head never passes tail, loading head first keeps the difference sane.
+    size_t head = _load(&q->head, memory_order_acquire);
+    size_t tail = _load(&q->tail, memory_order_acquire);
+
+    return MIN(tail - head, q->mask + 1);
+}
+
+size_t uspsc_queue_get_capacity(const uspsc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+    return q->mask + 1;
+}
+
+bool uspsc_queue_is_empty(const uspsc_queue_t *q)
+{
+    return uspsc_queue_get_size(q) == 0;
+}
+
+bool uspsc_queue_is_full(const uspsc_queue_t *q)
+{
+    return uspsc_queue_get_size(q) == uspsc_queue_get_capacity(q);
+}
+
+umemusage_t uspsc_queue_get_memory_usage(const uspsc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    size_t head = _load(&q->head, memory_order_relaxed);
+    size_t size = uspsc_queue_get_size(q);
+    umemusage_t u = {0};
+    u.structure = sizeof(*q) + size * sizeof(q->cells[0]);
+    u.slack = (q->mask + 1 - size) * sizeof(q->cells[0]);
+    if (q->is_data_owner)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            ugeneric_t e = q->cells[(head + i) & q->mask];
+            umemusage_add(&u, ugeneric_get_memory_usage(e));
+        }
+    }
+
+    return u;
+}
+
+void uspsc_queue_serialize(const uspsc_queue_t *q, ubuffer_t *buf)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(buf);
+
+    size_t head = _load(&q->head, memory_order_relaxed);
+    size_t size = uspsc_queue_get_size(q);
+    ubuffer_append_byte(buf, '[');
+    for (size_t i = 0; i < size; i++)
+    {
+        ugeneric_serialize_v(q->cells[(head + i) & q->mask], buf,
+                             q->void_handlers.s8r);
+        if (i < size - 1)
+        {
+            ubuffer_append_data(buf, ", ", 2);
+        }
+    }
+    ubuffer_append_byte(buf, ']');
+}
+
+char *uspsc_queue_as_str(const uspsc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+
+    ubuffer_t buf = {0};
+    uspsc_queue_serialize(q, &buf);
+    ubuffer_null_terminate(&buf);
+
+    return buf.data;
+}
+
+int uspsc_queue_fprint(const uspsc_queue_t *q, FILE *out)
+{
+    UASSERT_INPUT(q);
+    UASSERT_INPUT(out);
+
+    char *str = uspsc_queue_as_str(q);
+    int ret = fprintf(out, "%s\n", str);
+    ufree(str);
+
+    return ret;
+}
+
+ugeneric_base_t *uspsc_queue_get_base(uspsc_queue_t *q)
+{
+    UASSERT_INPUT(q);
+    return (ugeneric_base_t *)q;
+}
@@ -0,0 +1,65 @@
+#ifndef USPSC_H__
+#define USPSC_H__
+
+#include "generic.h"
+
+/*
+ * Bounded lock-free queue passing elements from one producer thread to one
+ * consumer thread. Capacity is rounded up to a power of two and never
+ * changes. Producer and consumer indices live on separate cache lines and
+ * each side caches the other one's index, so the shared lines are touched
+ * only when the queue looks full (or empty) to the side.
+ *
+ * Producer side: uspsc_queue_try_enq(), uspsc_queue_enq(),
+ *                uspsc_queue_enq_batch().
+ * Consumer side: uspsc_queue_try_deq(), uspsc_queue_deq(),
+ *                uspsc_queue_deq_batch(), uspsc_queue_try_peek().
+ *
+ * Size and emptiness checks are safe from any thread but racy by nature.
+ * The rest (clear, serialization, memory usage, destroy) must not run
+ * concurrently with producer or consumer.
+ */
+
+typedef struct uspsc_queue_opaq uspsc_queue_t;
+
+uspsc_queue_t *uspsc_queue_create(size_t capacity);
+/* Destroys elements left in the queue if it owns data. */
+void uspsc_queue_destroy(uspsc_queue_t *q);
+void uspsc_queue_clear(uspsc_queue_t *q);
+
+/* Return false if the queue is full (empty). */
+bool uspsc_queue_try_enq(uspsc_queue_t *q, ugeneric_t e);
+bool uspsc_queue_try_deq(uspsc_queue_t *q, ugeneric_t *e);
+bool uspsc_queue_try_peek(uspsc_queue_t *q, ugeneric_t *e);
+
+/* Wait (yielding the CPU) until there is room (an element). */
+void uspsc_queue_enq(uspsc_queue_t *q, ugeneric_t e);
+ugeneric_t uspsc_queue_deq(uspsc_queue_t *q);
+
+/* Move up to n elements with at most two memcpy() calls and a single
+ * index update, return the number of elements moved.
+ */
+size_t uspsc_queue_enq_batch(uspsc_queue_t *q, const ugeneric_t *elements,
+                             size_t n);
+size_t uspsc_queue_deq_batch(uspsc_queue_t *q, ugeneric_t *elements,
+                             size_t n);
+
+size_t uspsc_queue_get_size(const uspsc_queue_t *q);
+size_t uspsc_queue_get_capacity(const uspsc_queue_t *q);
+bool uspsc_queue_is_empty(const uspsc_queue_t *q);
+bool uspsc_queue_is_full(const uspsc_queue_t *q);
+umemusage_t uspsc_queue_get_memory_usage(const uspsc_queue_t *q);
+
+char *uspsc_queue_as_str(const uspsc_queue_t *q);
+void uspsc_queue_serialize(const uspsc_queue_t *q, ubuffer_t *buf);
+int uspsc_queue_fprint(const uspsc_queue_t *q, FILE *out);
+static inline int uspsc_queue_print(const uspsc_queue_t *q) {return uspsc_queue_fprint(q, stdout);}
+
+static void uspsc_queue_take_data_ownership(uspsc_queue_t *q);
+static void uspsc_queue_drop_data_ownership(uspsc_queue_t *q);
+static bool uspsc_queue_is_data_owner(uspsc_queue_t *q);
+
+ugeneric_base_t *uspsc_queue_get_base(uspsc_queue_t *q);
+DEFINE_BASE_FUNCS(uspsc_queue)
+
+#endif
@@ -70,6 +70,16 @@ size_t ustack_get_capacity(const ustack_t *s)
     return uvector_get_capacity(s->data);
 }
 
+umemusage_t ustack_get_memory_usage(const ustack_t *s)
+{
+    UASSERT_INPUT(s);
+
+    umemusage_t u = uvector_get_memory_usage(s->data);
+    u.structure += sizeof(*s);
+
+    return u;
+}
+
 void ustack_clear(ustack_t *s)
 {
     UASSERT_INPUT(s);
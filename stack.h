@@ -14,6 +14,7 @@ size_t ustack_get_size(const ustack_t *s);
 bool ustack_is_empty(const ustack_t *s);
 void ustack_reserve_capacity(ustack_t *s, size_t capacity);
 size_t ustack_get_capacity(const ustack_t *s);
+umemusage_t ustack_get_memory_usage(const ustack_t *s);
 void ustack_clear(ustack_t *s);
 
 static void ustack_take_data_ownership(ustack_t *s);
@@ -353,6 +353,24 @@ void test_udict_cmp(udict_backend_t backend)
     }
 }
 
+void test_udict_memory_usage(udict_backend_t backend)
+{
+    udict_t *d = udict_create_with_backend(backend);
+    umemusage_t u = udict_get_memory_usage(d);
+    UASSERT(u.structure > 0);
+    UASSERT_SIZE_EQ(u.payload, 0);
+
+    for (size_t i = 0; i < 100; i++)
+    {
+        udict_put(d, G_STR(ustring_fmt("%03zu", i)), G_INT(i));
+    }
+    umemusage_t u2 = udict_get_memory_usage(d);
+    UASSERT_SIZE_EQ(u2.payload, 100 * sizeof("000"));
+    UASSERT(u2.structure >= u.structure + 100 * sizeof(ugeneric_kv_t));
+
+    udict_destroy(d);
+}
+
 void test_2sum(void)
 {
     const char *path = "utdata/2sum.txt";
@@ -423,6 +441,7 @@ int main(int argc, char **argv)
         test_single(i);
         test_udict_put(i);
         test_udict_cmp(i);
+        test_udict_memory_usage(i);
     }
 
     test_2sum();
@@ -1,6 +1,7 @@
 #include "file_utils.h"
 
 #include "mem.h"
+#include "sort.h"
 #include "ut_utils.h"
 
 size_t execute_read(const char *path, size_t buffer_size)
@@ -163,11 +164,95 @@ void test_open_dir(void)
     ugeneric_error_destroy(g);
 }
 
+static int _cmp_num_lines(const void *l1, const void *l2)
+{
+    long n1 = atol(l1);
+    long n2 = atol(l2);
+    return (n1 > n2) - (n1 < n2);
+}
+
+static ugeneric_t _collect_line(const char *line, size_t size, void *ctx)
+{
+    UASSERT_SIZE_EQ(strlen(line), size);
+    uvector_append(ctx, G_STR(ustring_dup(line)));
+    return G_NULL();
+}
+
+void test_ufile_sort(void)
+{
+    const char *in = "utdata/array.txt";
+    const char *out = "utdata/array.sorted.tmp";
+
+    ugeneric_t g = ufile_read_lines(in, "\n");
+    UASSERT_NO_ERROR(g);
+    uvector_t *expected = G_AS_PTR(g);
+
+    // Line reader.
+    g = ufile_reader_create(in, 16);
+    UASSERT_NO_ERROR(g);
+    ufile_reader_t *fr = G_AS_PTR(g);
+    for (size_t i = 0; i < uvector_get_size(expected); i++)
+    {
+        g = ufile_reader_read_line(fr);
+        UASSERT_NO_ERROR(g);
+        UASSERT_STR_EQ(G_AS_MEMCHUNK_DATA(g), G_AS_STR(uvector_get_at(expected, i)));
+    }
+    UASSERT(!ufile_reader_has_next(fr));
+    UASSERT(G_IS_NULL(ufile_reader_read_line(fr)));
+    UASSERT_NO_ERROR(ufile_reader_destroy(fr));
+
+    // In-memory path, strcmp order, output to callback.
+    uvector_sort(expected);
+    uvector_t *v = uvector_create();
+    g = ufile_sort_ext(in, _collect_line, v, NULL, 0);
+    UASSERT_NO_ERROR(g);
+    UASSERT_INT_EQ(uvector_compare(v, expected), 0);
+    uvector_destroy(v);
+
+    // Small budget makes hundreds of runs which are merged in several passes.
+    g = ufile_sort(in, out, _cmp_num_lines, 4096);
+    UASSERT_NO_ERROR(g);
+    g = ufile_read_lines(out, "\n");
+    UASSERT_NO_ERROR(g);
+    v = G_AS_PTR(g);
+    UASSERT_SIZE_EQ(uvector_get_size(v), uvector_get_size(expected));
+    for (size_t i = 1; i < uvector_get_size(v); i++)
+    {
+        UASSERT(atol(G_AS_STR(uvector_get_at(v, i - 1))) <=
+                atol(G_AS_STR(uvector_get_at(v, i))));
+    }
+    uvector_sort(v);
+    UASSERT_INT_EQ(uvector_compare(v, expected), 0);
+    uvector_destroy(v);
+    remove(out);
+
+    g = ufile_sort(in, out, NULL, UFILE_SORT_MIN_MEMORY_BUDGET);
+    UASSERT_NO_ERROR(g);
+    remove(out);
+
+    // Threaded runs take their merge buffer from the arena.
+    libugeneric_set_sort_threads(4);
+    v = uvector_create();
+    g = ufile_sort_ext(in, _collect_line, v, NULL, 0);
+    UASSERT_NO_ERROR(g);
+    UASSERT_INT_EQ(uvector_compare(v, expected), 0);
+    uvector_destroy(v);
+    v = uvector_create();
+    g = ufile_sort_ext(in, _collect_line, v, NULL, 3 << 20);
+    UASSERT_NO_ERROR(g);
+    UASSERT_INT_EQ(uvector_compare(v, expected), 0);
+    uvector_destroy(v);
+    libugeneric_set_sort_threads(1);
+
+    uvector_destroy(expected);
+}
+
 int main(int argc, char **argv)
 {
     (void)argc;
     (void)argv;
 
+    test_ufile_sort();
     test_ufile_api();
     test_ufile_reader();
     //test_ufile_writer(atoi(argv[1]));
@@ -199,9 +199,48 @@ void test_running_median(void)
     uheap_destroy(rheap);
 }
 
+void test_uheap_pushpop(void)
+{
+    uheap_t *h = uheap_create();
+
+    // Empty heap gives the element back.
+    UASSERT_INT_EQ(G_AS_INT(uheap_pushpop(h, G_INT(5))), 5);
+    UASSERT(uheap_is_empty(h));
+
+    // Keep the 3 largest elements in a min heap.
+    long data[] = {4, 9, 1, 7, 3, 8, 2, 6, 5};
+    for (size_t i = 0; i < ARR_LEN(data); i++)
+    {
+        if (uheap_get_size(h) < 3)
+        {
+            uheap_push(h, G_INT(data[i]));
+        }
+        else
+        {
+            ugeneric_t e = uheap_pushpop(h, G_INT(data[i]));
+            UASSERT(G_AS_INT(e) <= G_AS_INT(uheap_peek(h)));
+        }
+    }
+    UASSERT_INT_EQ(G_AS_INT(uheap_pop(h)), 7);
+    UASSERT_INT_EQ(G_AS_INT(uheap_pop(h)), 8);
+    UASSERT_INT_EQ(G_AS_INT(uheap_pop(h)), 9);
+    uheap_destroy(h);
+
+    // Max heap keeps the smallest ones.
+    h = uheap_create_ext(4, UHEAP_TYPE_MAX);
+    uheap_push(h, G_INT(3));
+    uheap_push(h, G_INT(1));
+    UASSERT_INT_EQ(G_AS_INT(uheap_pushpop(h, G_INT(2))), 3);
+    UASSERT_INT_EQ(G_AS_INT(uheap_pushpop(h, G_INT(5))), 5);
+    UASSERT_INT_EQ(G_AS_INT(uheap_pop(h)), 2);
+    UASSERT_INT_EQ(G_AS_INT(uheap_pop(h)), 1);
+    uheap_destroy(h);
+}
+
 int main(void)
 {
     test_uheap_api();
+    test_uheap_pushpop();
     test_running_median();
 
     return 0;
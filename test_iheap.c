@@ -0,0 +1,211 @@
+#include "iheap.h"
+
+#include "mem.h"
+#include "string_utils.h"
+#include "ut_utils.h"
+
+#include <limits.h>
+
+void test_uiheap_api(void)
+{
+    uiheap_t *h = uiheap_create();
+    UASSERT(uiheap_is_empty(h));
+    UASSERT(!uiheap_contains(h, 0));
+    UASSERT(!uiheap_contains(h, 1000));
+
+    uiheap_push(h, 3, G_INT(30));
+    uiheap_push(h, 1, G_INT(10));
+    uiheap_push(h, 2, G_INT(20));
+    UASSERT_SIZE_EQ(uiheap_get_size(h), 3);
+    UASSERT(uiheap_contains(h, 2));
+    UASSERT_INT_EQ(G_AS_INT(uiheap_get_priority(h, 2)), 20);
+
+    ugeneric_t p;
+    UASSERT_SIZE_EQ(uiheap_peek(h, &p), 1);
+    UASSERT_INT_EQ(G_AS_INT(p), 10);
+
+    // Handles move with their priorities.
+    uiheap_decrease_key(h, 3, G_INT(5));
+    UASSERT_SIZE_EQ(uiheap_peek(h, NULL), 3);
+    uiheap_increase_key(h, 3, G_INT(25));
+    UASSERT_SIZE_EQ(uiheap_peek(h, NULL), 1);
+    uiheap_update(h, 2, G_INT(0));
+    UASSERT_SIZE_EQ(uiheap_peek(h, NULL), 2);
+
+    char *str = uiheap_as_str(h);
+    UASSERT_STR_EQ(str, "{2: 0, 3: 25, 1: 10}");
+    ufree(str);
+
+    uiheap_remove(h, 1, &p);
+    UASSERT_INT_EQ(G_AS_INT(p), 10);
+    UASSERT(!uiheap_contains(h, 1));
+    UASSERT_SIZE_EQ(uiheap_pop(h, &p), 2);
+    UASSERT_INT_EQ(G_AS_INT(p), 0);
+    UASSERT_SIZE_EQ(uiheap_pop(h, NULL), 3);
+    UASSERT(uiheap_is_empty(h));
+
+    // Handles may come back after they have left.
+    uiheap_push(h, 3, G_INT(1));
+    UASSERT(uiheap_contains(h, 3));
+
+    // Tables grow to the largest handle.
+    uiheap_push(h, 100, G_INT(0));
+    UASSERT(uiheap_get_capacity(h) > 100);
+    UASSERT_SIZE_EQ(uiheap_pop(h, NULL), 100);
+
+    umemusage_t u = uiheap_get_memory_usage(h);
+    UASSERT(u.structure > 0);
+    uiheap_clear(h);
+    UASSERT(uiheap_is_empty(h));
+    UASSERT(!uiheap_contains(h, 3));
+    uiheap_destroy(h);
+    uiheap_destroy(NULL);
+
+    // Max heap.
+    h = uiheap_create_ext(4, UHEAP_TYPE_MAX);
+    UASSERT_SIZE_EQ(uiheap_get_capacity(h), 4);
+    uiheap_push(h, 0, G_INT(1));
+    uiheap_push(h, 1, G_INT(3));
+    uiheap_push(h, 2, G_INT(2));
+    UASSERT_SIZE_EQ(uiheap_peek(h, NULL), 1);
+    uiheap_increase_key(h, 0, G_INT(4));
+    UASSERT_SIZE_EQ(uiheap_pop(h, NULL), 0);
+    uiheap_decrease_key(h, 1, G_INT(0));
+    UASSERT_SIZE_EQ(uiheap_pop(h, NULL), 2);
+    UASSERT_SIZE_EQ(uiheap_pop(h, NULL), 1);
+    uiheap_destroy(h);
+}
+
+void test_uiheap_ownership(void)
+{
+    // Replaced, removed and left behind priorities are destroyed.
+    uiheap_t *h = uiheap_create();
+    uiheap_push(h, 0, G_STR(ustring_fmt("b")));
+    uiheap_push(h, 1, G_STR(ustring_fmt("c")));
+    uiheap_push(h, 2, G_STR(ustring_fmt("d")));
+    uiheap_decrease_key(h, 1, G_STR(ustring_fmt("a")));
+    UASSERT_SIZE_EQ(uiheap_pop(h, NULL), 1);
+
+    ugeneric_t p;
+    uiheap_remove(h, 0, &p);
+    UASSERT_STR_EQ(G_AS_STR(p), "b");
+    ugeneric_destroy(p);
+
+    // Owned priority changed in place is re-keyed, not destroyed.
+    char *key = G_AS_STR(uiheap_get_priority(h, 2));
+    key[0] = 'a';
+    uiheap_update(h, 2, G_STR(key));
+    UASSERT_STR_EQ(G_AS_STR(uiheap_get_priority(h, 2)), "a");
+    uiheap_update(h, 2, uiheap_get_priority(h, 2));
+    UASSERT_SIZE_EQ(uiheap_pop(h, &p), 2);
+    UASSERT_STR_EQ(G_AS_STR(p), "a");
+    ugeneric_destroy(p);
+    uiheap_destroy(h);
+
+    h = uiheap_create();
+    uiheap_drop_data_ownership(h);
+    UASSERT(!uiheap_is_data_owner(h));
+    uiheap_push(h, 0, G_CSTR("x"));
+    uiheap_update(h, 0, G_CSTR("y"));
+    uiheap_pop(h, NULL);
+    uiheap_destroy(h);
+}
+
+typedef struct {
+    int key;
+} _task_t;
+
+static int _task_cmp(const void *t1, const void *t2)
+{
+    const _task_t *a = t1;
+    const _task_t *b = t2;
+    return (a->key > b->key) - (a->key < b->key);
+}
+
+void test_uiheap_random(void)
+{
+    enum {HANDLES = 64, ROUNDS = 20000};
+
+    // Checked against a brute force model, priorities live outside.
+    _task_t tasks[HANDLES];
+    bool in[HANDLES] = {false};
+    size_t size = 0;
+
+    uiheap_t *h = uiheap_create();
+    uiheap_set_void_comparator(h, _task_cmp);
+    uiheap_drop_data_ownership(h);
+
+    for (size_t r = 0; r < ROUNDS; r++)
+    {
+        size_t i = rand() % HANDLES;
+        int key = rand() % 1000;
+        switch (rand() % 4)
+        {
+            case 0:
+                if (in[i])
+                {
+                    uiheap_remove(h, i, NULL);
+                    in[i] = false;
+                    size--;
+                }
+                else
+                {
+                    tasks[i].key = key;
+                    uiheap_push(h, i, G_PTR(&tasks[i]));
+                    in[i] = true;
+                    size++;
+                }
+                break;
+            case 1:
+                if (in[i])
+                {
+                    tasks[i].key = key;
+                    uiheap_update(h, i, G_PTR(&tasks[i]));
+                }
+                break;
+            case 2:
+                if (size)
+                {
+                    int min = INT_MAX;
+                    for (size_t j = 0; j < HANDLES; j++)
+                    {
+                        if (in[j] && tasks[j].key < min)
+                        {
+                            min = tasks[j].key;
+                        }
+                    }
+                    ugeneric_t p;
+                    size_t top = uiheap_pop(h, &p);
+                    UASSERT(in[top]);
+                    UASSERT_INT_EQ(((_task_t *)G_AS_PTR(p))->key, min);
+                    in[top] = false;
+                    size--;
+                }
+                break;
+            default:
+                UASSERT(uiheap_contains(h, i) == in[i]);
+                break;
+        }
+        UASSERT_SIZE_EQ(uiheap_get_size(h), size);
+    }
+
+    int last = INT_MIN;
+    while (!uiheap_is_empty(h))
+    {
+        ugeneric_t p;
+        uiheap_pop(h, &p);
+        int key = ((_task_t *)G_AS_PTR(p))->key;
+        UASSERT(key >= last);
+        last = key;
+    }
+    uiheap_destroy(h);
+}
+
+int main(void)
+{
+    test_uiheap_api();
+    test_uiheap_ownership();
+    test_uiheap_random();
+
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include "mem.h"
 #include "list.h"
+#include "string_utils.h"
 #include "vector.h"
 #include "ut_utils.h"
 
@@ -212,6 +213,441 @@ void test_ulist_serialize(void)
     ulist_destroy(l);
 }
 
+static void _check_list(const ulist_t *l, const uvector_t *model)
+{
+    char *s1 = ulist_as_str(l);
+    char *s2 = uvector_as_str(model);
+    UASSERT_STR_EQ(s1, s2);
+    ufree(s1);
+    ufree(s2);
+    UASSERT_SIZE_EQ(ulist_get_size(l), uvector_get_size(model));
+}
+
+void test_ulist_unrolled(void)
+{
+    // Random operations mirrored on a vector, for various node sizes.
+    size_t capacities[] = {1, 2, 3, 4, 7, ULIST_DEFAULT_NODE_CAPACITY};
+    for (size_t c = 0; c < ARR_LEN(capacities); c++)
+    {
+        ulist_t *l = ulist_create_ext(capacities[c]);
+        UASSERT_SIZE_EQ(ulist_get_node_capacity(l), capacities[c]);
+        uvector_t *model = uvector_create();
+        srand(c);
+
+        for (long op = 0; op < 3000; op++)
+        {
+            size_t size = uvector_get_size(model);
+            switch (rand() % 7)
+            {
+                case 0:
+                    ulist_append(l, G_INT(op));
+                    uvector_append(model, G_INT(op));
+                    break;
+                case 1:
+                    ulist_prepend(l, G_INT(op));
+                    uvector_append(model, G_INT(op));
+                    uvector_insert_range(model, 0, model, size, size + 1,
+                                         UCOPY_SHALLOW);
+                    uvector_pop_back(model);
+                    break;
+                case 2:
+                case 3:
+                {
+                    size_t i = rand() % (size + 1);
+                    ulist_insert_at(l, i, G_INT(op));
+                    uvector_append(model, G_INT(op));
+                    uvector_insert_range(model, i, model, size, size + 1,
+                                         UCOPY_SHALLOW);
+                    uvector_pop_back(model);
+                    break;
+                }
+                case 4:
+                    if (size)
+                    {
+                        size_t i = rand() % size;
+                        ulist_remove_at(l, i);
+                        uvector_remove_at(model, i);
+                    }
+                    break;
+                case 5:
+                    if (size)
+                    {
+                        UASSERT_INT_EQ(G_AS_INT(ulist_pop_front(l)),
+                                       G_AS_INT(uvector_pop_at(model, 0)));
+                    }
+                    break;
+                default:
+                    if (size)
+                    {
+                        UASSERT_INT_EQ(G_AS_INT(ulist_pop_back(l)),
+                                       G_AS_INT(uvector_pop_back(model)));
+                    }
+                    break;
+            }
+
+            if (op % 100 == 0)
+            {
+                _check_list(l, model);
+                for (size_t i = 0; i < uvector_get_size(model); i++)
+                {
+                    UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l, i)),
+                                   G_AS_INT(uvector_get_at(model, i)));
+                }
+            }
+        }
+        _check_list(l, model);
+
+        ulist_iterator_t *li = ulist_iterator_create(l);
+        for (size_t i = 0; i < uvector_get_size(model); i++)
+        {
+            UASSERT(ulist_iterator_has_next(li));
+            UASSERT_INT_EQ(G_AS_INT(ulist_iterator_get_next(li)),
+                           G_AS_INT(uvector_get_at(model, i)));
+        }
+        UASSERT(!ulist_iterator_has_next(li));
+        ulist_iterator_destroy(li);
+
+        ulist_reverse(l);
+        uvector_reverse(model);
+        _check_list(l, model);
+
+        ulist_t *copy = ulist_copy(l);
+        UASSERT_INT_EQ(ulist_compare(l, copy, NULL), 0);
+        ulist_destroy(copy);
+
+        ulist_clear(l);
+        UASSERT(ulist_is_empty(l));
+        ulist_append(l, G_INT(1));
+        UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l, 0)), 1);
+
+        ulist_destroy(l);
+        uvector_destroy(model);
+    }
+}
+
+void test_ulist_positional_loops(void)
+{
+    const long n = 100000;
+    ulist_t *l = ulist_create();
+    for (long i = 0; i < n; i++)
+    {
+        ulist_append(l, G_INT(i));
+    }
+
+    // Index based loops are linear thanks to the finger.
+    for (long i = 0; i < n; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l, i)), i);
+        ulist_set_at(l, i, G_INT(2 * i));
+    }
+    for (long i = n - 1; i >= 0; i--)
+    {
+        UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l, i)), 2 * i);
+    }
+
+    // Drop every other element, then put them back.
+    for (long i = 0; i < n / 2; i++)
+    {
+        ulist_remove_at(l, i + 1);
+    }
+    UASSERT_SIZE_EQ(ulist_get_size(l), n / 2);
+    for (long i = 0; i < n / 2; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l, 2 * i)), 4 * i);
+        ulist_insert_at(l, 2 * i + 1, G_INT(4 * i + 2));
+    }
+    for (long i = 0; i < n; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l, i)), 2 * i);
+    }
+
+    ulist_destroy(l);
+}
+
+void test_ulist_memory(void)
+{
+    // Short lists do not take a whole node.
+    ulist_t *l = ulist_create();
+    ulist_append(l, G_INT(1));
+    umemusage_t u = ulist_get_memory_usage(l);
+    UASSERT(u.slack < ULIST_INITIAL_NODE_CAPACITY * sizeof(ugeneric_t));
+    ulist_destroy(l);
+
+    // Long lists take little more than an element per element.
+    l = ulist_create();
+    for (long i = 0; i < 10000; i++)
+    {
+        ulist_append(l, G_INT(i));
+    }
+    u = ulist_get_memory_usage(l);
+    UASSERT(umemusage_get_total(u) / 10000 < sizeof(ugeneric_t) + 2);
+    ulist_destroy(l);
+
+    // Owned elements are destroyed on removal and clearing.
+    l = ulist_create_ext(2);
+    for (long i = 0; i < 10; i++)
+    {
+        ulist_append(l, G_STR(ustring_fmt("%ld", i)));
+    }
+    ulist_remove_at(l, 3);
+    ulist_set_at(l, 0, G_STR(ustring_fmt("x")));
+    ulist_t *copy = ulist_deep_copy(l);
+    ulist_clear(l);
+    char *str = ulist_as_str(copy);
+    UASSERT_STR_EQ(str, "[\"x\", \"1\", \"2\", \"4\", \"5\", \"6\", \"7\", \"8\", \"9\"]");
+    ufree(str);
+    UASSERT_STR_EQ(G_AS_STR(*ulist_find(copy, G_CSTR("5"))), "5");
+    UASSERT(!ulist_contains(copy, G_CSTR("3")));
+    ulist_destroy(copy);
+    ulist_destroy(l);
+}
+
+void test_ulist_splice(void)
+{
+    size_t capacities[] = {1, 3, ULIST_DEFAULT_NODE_CAPACITY};
+    for (size_t c = 0; c < ARR_LEN(capacities); c++)
+    {
+        ulist_t *l[2];
+        uvector_t *model[2];
+        for (size_t k = 0; k < 2; k++)
+        {
+            l[k] = ulist_create_ext(capacities[c]);
+            model[k] = uvector_create();
+            for (long i = 0; i < 200; i++)
+            {
+                ulist_append(l[k], G_INT(1000 * k + i));
+                uvector_append(model[k], G_INT(1000 * k + i));
+            }
+        }
+        srand(c);
+
+        for (int op = 0; op < 1000; op++)
+        {
+            size_t s = rand() % 2;
+            size_t d = rand() % 2;
+            size_t size = uvector_get_size(model[s]);
+            size_t begin = rand() % (size + 1);
+            size_t end = begin + rand() % (size - begin + 1);
+            size_t i = rand() % (uvector_get_size(model[d]) + 1);
+            if ((s == d) && (i > begin) && (i < end))
+            {
+                continue;
+            }
+
+            ulist_splice(l[d], i, l[s], begin, end);
+
+            uvector_t *range = uvector_create();
+            uvector_extend(range, model[s], UCOPY_SHALLOW);
+            uvector_remove_range(range, end, size);
+            uvector_remove_range(range, 0, begin);
+            uvector_remove_range(model[s], begin, end);
+            if ((s == d) && (i >= end))
+            {
+                i -= end - begin;
+            }
+            uvector_insert_range(model[d], i, range, 0, end - begin,
+                                 UCOPY_SHALLOW);
+            uvector_destroy(range);
+
+            if (op % 50 == 0)
+            {
+                _check_list(l[0], model[0]);
+                _check_list(l[1], model[1]);
+            }
+        }
+        _check_list(l[0], model[0]);
+        _check_list(l[1], model[1]);
+
+        ulist_concat(l[0], l[1]);
+        uvector_extend(model[0], model[1], UCOPY_SHALLOW);
+        uvector_clear(model[1]);
+        _check_list(l[0], model[0]);
+        _check_list(l[1], model[1]);
+        ulist_append(l[1], G_INT(-1));
+        UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l[1], 0)), -1);
+
+        for (size_t k = 0; k < 2; k++)
+        {
+            ulist_destroy(l[k]);
+            uvector_destroy(model[k]);
+        }
+    }
+
+    // Moving elements around a list of single element nodes only relinks.
+    ulist_t *l = ulist_create_ext(1);
+    ulist_t *lru = ulist_create_ext(1);
+    for (long i = 0; i < 10; i++)
+    {
+        ulist_append(l, G_INT(i));
+    }
+    size_t allocations = libugeneric_get_allocation_count();
+    ulist_splice(l, 0, l, 9, 10);
+    ulist_splice(l, 10, l, 1, 3);
+    ulist_splice(lru, 0, l, 2, 5);
+    ulist_concat(l, lru);
+    UASSERT_SIZE_EQ(libugeneric_get_allocation_count(), allocations);
+    char *str = ulist_as_str(l);
+    UASSERT_STR_EQ(str, "[9, 2, 6, 7, 8, 0, 1, 3, 4, 5]");
+    ufree(str);
+    UASSERT(ulist_is_empty(lru));
+    ulist_destroy(lru);
+    ulist_destroy(l);
+
+    // Nodes taken over from a list with bigger nodes keep their capacity
+    // and are split safely on inserts in the middle.
+    ulist_t *big = ulist_create_ext(64);
+    ulist_t *small = ulist_create_ext(2);
+    uvector_t *model = uvector_create();
+    for (long i = 0; i < 64; i++)
+    {
+        ulist_append(big, G_INT(i));
+        uvector_append(model, G_INT(i));
+    }
+    ulist_concat(small, big);
+    for (long i = 0; i < 8; i++)
+    {
+        ulist_insert_at(small, 10 + i, G_INT(-i));
+        uvector_insert_at(model, 10 + i, G_INT(-i));
+    }
+    ulist_splice(big, 0, small, 20, 60);
+    ulist_insert_at(big, 5, G_INT(100));
+    uvector_t *spliced = uvector_create();
+    for (size_t i = 20; i < 60; i++)
+    {
+        uvector_append(spliced, uvector_get_at(model, i));
+    }
+    uvector_insert_at(spliced, 5, G_INT(100));
+    uvector_remove_range(model, 20, 60);
+
+    char *s1 = ulist_as_str(small);
+    char *s2 = uvector_as_str(model);
+    UASSERT_STR_EQ(s1, s2);
+    ufree(s1);
+    ufree(s2);
+    s1 = ulist_as_str(big);
+    s2 = uvector_as_str(spliced);
+    UASSERT_STR_EQ(s1, s2);
+    ufree(s1);
+    ufree(s2);
+    ulist_destroy(small);
+    ulist_destroy(big);
+    uvector_destroy(spliced);
+    uvector_destroy(model);
+}
+
+typedef struct {
+    int key;
+    int seq;
+} _record_t;
+
+static int _record_cmp(const void *p1, const void *p2)
+{
+    const _record_t *r1 = p1;
+    const _record_t *r2 = p2;
+    return r1->key - r2->key;
+}
+
+void test_ulist_sort(void)
+{
+    size_t capacities[] = {1, 2, 5, ULIST_DEFAULT_NODE_CAPACITY};
+    size_t sizes[] = {0, 1, 2, 3, 31, 32, 33, 100, 1000, 4097};
+    for (size_t c = 0; c < ARR_LEN(capacities); c++)
+    {
+        for (size_t s = 0; s < ARR_LEN(sizes); s++)
+        {
+            size_t n = sizes[s];
+            ulist_t *l = ulist_create_ext(capacities[c]);
+            uvector_t *model = uvector_create();
+            srand(n);
+            for (size_t i = 0; i < n; i++)
+            {
+                long e = rand() % (n + 1);
+                // Middle insertions leave nodes partially filled.
+                ulist_insert_at(l, (i % 3) ? ulist_get_size(l) : i / 2, G_INT(e));
+                uvector_append(model, G_INT(e));
+            }
+
+            ulist_sort(l);
+            uvector_sort(model);
+            _check_list(l, model);
+            // Sorted lists are kept as is.
+            ulist_sort(l);
+            _check_list(l, model);
+            ulist_reverse(l);
+            ulist_sort(l);
+            _check_list(l, model);
+
+            ulist_destroy(l);
+            uvector_destroy(model);
+        }
+    }
+
+    // Equal elements keep their order.
+    _record_t records[3000];
+    for (size_t c = 0; c < ARR_LEN(capacities); c++)
+    {
+        ulist_t *l = ulist_create_ext(capacities[c]);
+        ulist_drop_data_ownership(l);
+        ulist_set_void_comparator(l, _record_cmp);
+        for (size_t i = 0; i < ARR_LEN(records); i++)
+        {
+            records[i].key = rand() % 50;
+            records[i].seq = (int)i;
+            ulist_append(l, G_PTR(&records[i]));
+        }
+        ulist_sort(l);
+
+        const _record_t *prev = NULL;
+        ulist_iterator_t *li = ulist_iterator_create(l);
+        while (ulist_iterator_has_next(li))
+        {
+            const _record_t *r = G_AS_PTR(ulist_iterator_get_next(li));
+            if (prev)
+            {
+                UASSERT((prev->key < r->key) ||
+                        ((prev->key == r->key) && (prev->seq < r->seq)));
+            }
+            prev = r;
+        }
+        ulist_iterator_destroy(li);
+        UASSERT_SIZE_EQ(ulist_get_size(l), ARR_LEN(records));
+        ulist_destroy(l);
+    }
+
+    // Sorting a list of single element nodes does not allocate.
+    ulist_t *l = ulist_create_ext(1);
+    for (long i = 0; i < 1000; i++)
+    {
+        ulist_append(l, G_INT((i * 7919) % 1000));
+    }
+    size_t allocations = libugeneric_get_allocation_count();
+    ulist_sort(l);
+    UASSERT_SIZE_EQ(libugeneric_get_allocation_count(), allocations);
+    for (long i = 0; i < 1000; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(ulist_get_at(l, i)), i);
+    }
+    ulist_destroy(l);
+
+    // Bigger nodes take a few spare nodes, as many for a long list as for
+    // a short one.
+    size_t spares[2];
+    size_t lengths[ARR_LEN(spares)] = {1000, 100000};
+    for (size_t k = 0; k < ARR_LEN(spares); k++)
+    {
+        l = ulist_create();
+        for (size_t i = 0; i < lengths[k]; i++)
+        {
+            ulist_append(l, G_INT(rand()));
+        }
+        allocations = libugeneric_get_allocation_count();
+        ulist_sort(l);
+        spares[k] = libugeneric_get_allocation_count() - allocations;
+        ulist_destroy(l);
+    }
+    UASSERT_SIZE_EQ(spares[0], spares[1]);
+}
+
 int main(int argc, char **argv)
 {
     (void)argv;
@@ -219,6 +655,11 @@ int main(int argc, char **argv)
 
     test_ulist_serialize();
     test_ulist_api();
+    test_ulist_unrolled();
+    test_ulist_positional_loops();
+    test_ulist_memory();
+    test_ulist_splice();
+    test_ulist_sort();
 //    test_ulist_iterator(void);
 
     return 0;
@@ -68,10 +68,76 @@ void test_memchunk(void)
     uvector_destroy(v);
 }
 
+void test_large_alloc(void)
+{
+    size_t small = 4096;
+    size_t large = UMEM_LARGE_THRESHOLD + 1;
+
+    // small -> large -> larger -> small
+    unsigned char *p = umalloc_large(small);
+    for (size_t i = 0; i < small; i++)
+    {
+        p[i] = i % 251;
+    }
+    p = urealloc_large(p, small, large);
+    for (size_t i = small; i < large; i++)
+    {
+        p[i] = i % 251;
+    }
+    p = urealloc_large(p, large, 2 * large);
+    for (size_t i = 0; i < large; i++)
+    {
+        UASSERT_INT_EQ(p[i], i % 251);
+    }
+    p = urealloc_large(p, 2 * large, small);
+    for (size_t i = 0; i < small; i++)
+    {
+        UASSERT_INT_EQ(p[i], i % 251);
+    }
+    ufree_large(p, small);
+
+    // Mapped data starts at a huge page boundary, heap data is aligned for
+    // any type.
+    p = umalloc_large(large);
+    UASSERT_SIZE_EQ((uintptr_t)p % UMEM_HUGE_PAGE_SIZE, 0);
+    p[large - 1] = 1;
+    ufree_large(p, large);
+    p = umalloc_large(small);
+    UASSERT_SIZE_EQ((uintptr_t)p % _Alignof(max_align_t), 0);
+    ufree_large(p, small);
+
+    // Shrinking within the same mapping keeps the block in place.
+    p = umalloc_large(2 * large);
+    unsigned char *q = urealloc_large(p, 2 * large, 2 * large - 1);
+    UASSERT(p == q);
+    ufree_large(q, 2 * large - 1);
+
+    ufree_large(NULL, 0);
+}
+
+void test_large_vector(void)
+{
+    size_t n = UMEM_LARGE_THRESHOLD / sizeof(ugeneric_t) + 1;
+    uvector_t *v = uvector_create();
+    for (size_t i = 0; i < n; i++)
+    {
+        uvector_append(v, G_SIZE(i));
+    }
+    UASSERT_SIZE_EQ(G_AS_SIZE(uvector_get_at(v, n - 1)), n - 1);
+    uvector_shrink_to_size(v);
+    UASSERT_SIZE_EQ(uvector_get_capacity(v), n);
+    uvector_resize(v, 10, G_NULL());
+    uvector_shrink_to_size(v);
+    UASSERT_SIZE_EQ(G_AS_SIZE(uvector_get_at(v, 9)), 9);
+    uvector_destroy(v);
+}
+
 int main(void)
 {
     test_umemdup();
     test_memchunk();
+    test_large_alloc();
+    test_large_vector();
 
     //test_oom();
 }
@@ -0,0 +1,239 @@
+#include "mpmc.h"
+
+#include "mem.h"
+#include "string_utils.h"
+#include "ut_utils.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+void test_umpmc_queue_api(void)
+{
+    umpmc_queue_t *q = umpmc_queue_create(3);
+    UASSERT_SIZE_EQ(umpmc_queue_get_capacity(q), 4);
+    UASSERT(umpmc_queue_is_empty(q));
+
+    ugeneric_t e;
+    UASSERT(!umpmc_queue_try_deq(q, &e));
+
+    for (long round = 0; round < 5; round++)
+    {
+        for (long i = 0; i < 4; i++)
+        {
+            UASSERT(umpmc_queue_try_enq(q, G_INT(round * 10 + i)));
+        }
+        UASSERT(umpmc_queue_is_full(q));
+        UASSERT(!umpmc_queue_try_enq(q, G_INT(-1)));
+
+        UASSERT(umpmc_queue_try_deq(q, &e));
+        UASSERT_INT_EQ(G_AS_INT(e), round * 10);
+        UASSERT_SIZE_EQ(umpmc_queue_get_size(q), 3);
+        for (long i = 1; i < 4; i++)
+        {
+            UASSERT_INT_EQ(G_AS_INT(umpmc_queue_deq(q)), round * 10 + i);
+        }
+        UASSERT(umpmc_queue_is_empty(q));
+    }
+
+    umpmc_queue_enq(q, G_INT(1));
+    umpmc_queue_enq(q, G_CSTR("two"));
+    char *str = umpmc_queue_as_str(q);
+    UASSERT_STR_EQ(str, "[1, \"two\"]");
+    ufree(str);
+    UASSERT(umpmc_queue_get_memory_usage(q).slack > 0);
+
+    umpmc_queue_clear(q);
+    UASSERT(umpmc_queue_is_empty(q));
+    umpmc_queue_enq(q, G_INT(3));
+    UASSERT_INT_EQ(G_AS_INT(umpmc_queue_deq(q)), 3);
+    umpmc_queue_destroy(q);
+    umpmc_queue_destroy(NULL);
+}
+
+void test_umpmc_queue_batch(void)
+{
+    umpmc_queue_t *q = umpmc_queue_create(8);
+    ugeneric_t in[12];
+    ugeneric_t out[12];
+    for (long i = 0; i < 12; i++)
+    {
+        in[i] = G_INT(i);
+    }
+
+    UASSERT_SIZE_EQ(umpmc_queue_enq_batch(q, in, 6), 6);
+    UASSERT_SIZE_EQ(umpmc_queue_deq_batch(q, out, 4), 4);
+    UASSERT_SIZE_EQ(umpmc_queue_enq_batch(q, &in[6], 6), 6);
+    UASSERT_SIZE_EQ(umpmc_queue_enq_batch(q, in, 12), 0);
+    UASSERT(umpmc_queue_is_full(q));
+    UASSERT_SIZE_EQ(umpmc_queue_deq_batch(q, &out[4], 12), 8);
+    for (long i = 0; i < 12; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(out[i]), i);
+    }
+    UASSERT_SIZE_EQ(umpmc_queue_deq_batch(q, out, 12), 0);
+    UASSERT_SIZE_EQ(umpmc_queue_enq_batch(q, in, 12), 8);
+    UASSERT_SIZE_EQ(umpmc_queue_enq_batch(q, NULL, 0), 0);
+    umpmc_queue_destroy(q);
+
+    // Owned elements left in the queue are destroyed with it.
+    q = umpmc_queue_create(4);
+    umpmc_queue_enq(q, G_STR(ustring_fmt("%d", 1)));
+    umpmc_queue_enq(q, G_STR(ustring_fmt("%d", 2)));
+    UASSERT(umpmc_queue_get_memory_usage(q).payload > 0);
+    umpmc_queue_destroy(q);
+}
+
+#define PRODUCERS 4
+#define CONSUMERS 4
+#define ITEMS_PER_PRODUCER 20000
+
+typedef struct {
+    umpmc_queue_t *q;
+    size_t id;
+    bool batch;
+    atomic_size_t *consumed;
+    unsigned char *seen;
+} _worker_t;
+
+static void *_produce(void *arg)
+{
+    _worker_t *w = arg;
+    ugeneric_t batch[5];
+
+    for (size_t i = 0; i < ITEMS_PER_PRODUCER;)
+    {
+        if (!w->batch || (i % 2))
+        {
+            umpmc_queue_enq(w->q, G_SIZE(w->id * ITEMS_PER_PRODUCER + i++));
+            continue;
+        }
+
+        size_t n = 0;
+        for (; (n < ARR_LEN(batch)) && (i + n < ITEMS_PER_PRODUCER); n++)
+        {
+            batch[n] = G_SIZE(w->id * ITEMS_PER_PRODUCER + i + n);
+        }
+        size_t done = umpmc_queue_enq_batch(w->q, batch, n);
+        if (!done)
+        {
+            sched_yield();
+        }
+        i += done;
+    }
+
+    return NULL;
+}
+
+static void _consume_one(_worker_t *w, ugeneric_t e, size_t *last)
+{
+    size_t v = G_AS_SIZE(e);
+    size_t producer = v / ITEMS_PER_PRODUCER;
+
+    // Elements of a producer come out in order.
+    UASSERT(v + 1 > last[producer]);
+    last[producer] = v + 1;
+    w->seen[v]++;
+    atomic_fetch_add(w->consumed, 1);
+}
+
+static void *_consume(void *arg)
+{
+    _worker_t *w = arg;
+    size_t last[PRODUCERS] = {0};
+    ugeneric_t batch[7];
+
+    if (!w->batch)
+    {
+        for (;;)
+        {
+            ugeneric_t e = umpmc_queue_deq(w->q);
+            if (G_IS_NULL(e))
+            {
+                break;
+            }
+            _consume_one(w, e, last);
+        }
+        return NULL;
+    }
+
+    while (atomic_load(w->consumed) < PRODUCERS * ITEMS_PER_PRODUCER)
+    {
+        size_t n = umpmc_queue_deq_batch(w->q, batch, ARR_LEN(batch));
+        for (size_t i = 0; i < n; i++)
+        {
+            _consume_one(w, batch[i], last);
+        }
+        if (!n)
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void _run_threads(bool batch)
+{
+    umpmc_queue_t *q = umpmc_queue_create(8);
+    atomic_size_t consumed;
+    atomic_init(&consumed, 0);
+    unsigned char *seen = ucalloc(PRODUCERS * ITEMS_PER_PRODUCER, 1);
+
+    pthread_t producers[PRODUCERS];
+    pthread_t consumers[CONSUMERS];
+    _worker_t pw[PRODUCERS];
+    _worker_t cw[CONSUMERS];
+
+    for (size_t i = 0; i < CONSUMERS; i++)
+    {
+        cw[i] = (_worker_t){q, i, batch, &consumed, seen};
+        UASSERT(pthread_create(&consumers[i], NULL, _consume, &cw[i]) == 0);
+    }
+    for (size_t i = 0; i < PRODUCERS; i++)
+    {
+        pw[i] = (_worker_t){q, i, batch, &consumed, seen};
+        UASSERT(pthread_create(&producers[i], NULL, _produce, &pw[i]) == 0);
+    }
+
+    for (size_t i = 0; i < PRODUCERS; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    if (!batch)
+    {
+        for (size_t i = 0; i < CONSUMERS; i++)
+        {
+            umpmc_queue_enq(q, G_NULL());
+        }
+    }
+    for (size_t i = 0; i < CONSUMERS; i++)
+    {
+        pthread_join(consumers[i], NULL);
+    }
+
+    UASSERT_SIZE_EQ(atomic_load(&consumed), PRODUCERS * ITEMS_PER_PRODUCER);
+    for (size_t i = 0; i < PRODUCERS * ITEMS_PER_PRODUCER; i++)
+    {
+        UASSERT_INT_EQ(seen[i], 1);
+    }
+    UASSERT(umpmc_queue_is_empty(q));
+
+    ufree(seen);
+    umpmc_queue_destroy(q);
+}
+
+void test_umpmc_queue_threads(void)
+{
+    _run_threads(false);
+    _run_threads(true);
+}
+
+int main(void)
+{
+    test_umpmc_queue_api();
+    test_umpmc_queue_batch();
+    test_umpmc_queue_threads();
+
+    return EXIT_SUCCESS;
+}
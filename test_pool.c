@@ -0,0 +1,108 @@
+#include "pool.h"
+
+#include "mem.h"
+#include "ut_utils.h"
+
+#include <stdatomic.h>
+
+typedef struct {
+    unsigned char *hits;
+    size_t chunk;
+    atomic_size_t calls;
+    upool_t *pool;
+} _pool_test_t;
+
+static void _mark(size_t begin, size_t end, void *ctx)
+{
+    _pool_test_t *t = ctx;
+    UASSERT(begin % t->chunk == 0);
+    UASSERT(end - begin <= t->chunk);
+    for (size_t i = begin; i < end; i++)
+    {
+        t->hits[i]++;
+    }
+    atomic_fetch_add(&t->calls, 1);
+}
+
+static void _check_run(upool_t *p, size_t n, size_t chunk)
+{
+    _pool_test_t t = {.hits = ucalloc(n + 1, 1), .chunk = chunk};
+    atomic_init(&t.calls, 0);
+
+    upool_run(p, n, chunk, _mark, &t);
+    for (size_t i = 0; i < n; i++)
+    {
+        UASSERT_INT_EQ(t.hits[i], 1);
+    }
+    UASSERT_SIZE_EQ(atomic_load(&t.calls), (n + chunk - 1) / chunk);
+    ufree(t.hits);
+}
+
+void test_upool_run(void)
+{
+    size_t threads[] = {1, 2, 4, 0};
+    for (size_t i = 0; i < ARR_LEN(threads); i++)
+    {
+        upool_t *p = upool_create(threads[i]);
+        UASSERT(upool_get_threads(p) >= 1);
+        for (size_t j = 0; j < 50; j++)
+        {
+            _check_run(p, 0, 1);
+            _check_run(p, 1, 1);
+            _check_run(p, 1000, 7);
+            _check_run(p, 10000, 64);
+            _check_run(p, 64, 64);
+        }
+        upool_destroy(p);
+    }
+    upool_destroy(NULL);
+}
+
+static void _nested(size_t begin, size_t end, void *ctx)
+{
+    _pool_test_t *t = ctx;
+    for (size_t i = begin; i < end; i++)
+    {
+        // Nested job is run inline by the calling thread.
+        _pool_test_t inner = {.hits = ucalloc(10, 1), .chunk = 2};
+        atomic_init(&inner.calls, 0);
+        upool_run(t->pool, 10, 2, _mark, &inner);
+        UASSERT_SIZE_EQ(atomic_load(&inner.calls), 5);
+        ufree(inner.hits);
+        t->hits[i]++;
+    }
+}
+
+void test_upool_nested(void)
+{
+    _pool_test_t t = {.hits = ucalloc(100, 1), .chunk = 3};
+    t.pool = upool_create(4);
+    upool_run(t.pool, 100, 3, _nested, &t);
+    for (size_t i = 0; i < 100; i++)
+    {
+        UASSERT_INT_EQ(t.hits[i], 1);
+    }
+    ufree(t.hits);
+    upool_destroy(t.pool);
+}
+
+void test_upool_shared(void)
+{
+    UASSERT_SIZE_EQ(libugeneric_get_pool_threads(), 0);
+    libugeneric_set_pool_threads(3);
+    UASSERT_SIZE_EQ(libugeneric_get_pool_threads(), 3);
+
+    upool_t *p = upool_get_shared();
+    UASSERT(p == upool_get_shared());
+    UASSERT(upool_get_threads(p) <= 3);
+    _check_run(p, 12345, 100);
+}
+
+int main(void)
+{
+    test_upool_run();
+    test_upool_nested();
+    test_upool_shared();
+
+    return EXIT_SUCCESS;
+}
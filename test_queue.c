@@ -1,6 +1,8 @@
 #include "queue.h"
 
 #include "asserts.h"
+#include "mem.h"
+#include "string_utils.h"
 #include "ut_utils.h"
 
 int main(void)
@@ -48,5 +50,115 @@ int main(void)
 
     uqueue_destroy(q);
 
+    // grow the queue when it is wrapped around
+    q = uqueue_create();
+    for (size_t i = 0; i < 10; i++)
+    {
+        uqueue_enq(q, G_INT(i));
+    }
+    for (size_t i = 0; i < 5; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(uqueue_deq(q)), i);
+    }
+    for (size_t i = 10; i < 40; i++)
+    {
+        uqueue_enq(q, G_INT(i));
+    }
+    for (size_t i = 5; i < 40; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(uqueue_deq(q)), i);
+    }
+    UASSERT(uqueue_is_empty(q));
+    uqueue_destroy(q);
+
+    // overwrite mode keeps the newest elements
+    q = uqueue_create_ext(4, UQUEUE_OVERWRITE);
+    UASSERT(uqueue_get_mode(q) == UQUEUE_OVERWRITE);
+    for (size_t i = 0; i < 10; i++)
+    {
+        uqueue_enq(q, G_INT(i));
+        UASSERT_SIZE_EQ(uqueue_get_size(q), MIN(i + 1, 4));
+    }
+    UASSERT(uqueue_is_full(q));
+    UASSERT_SIZE_EQ(uqueue_get_capacity(q), 4);
+    char *str = uqueue_as_str(q);
+    UASSERT_STR_EQ(str, "[6, 7, 8, 9]");
+    ufree(str);
+    UASSERT_INT_EQ(G_AS_INT(uqueue_deq(q)), 6);
+    UASSERT(!uqueue_is_full(q));
+    uqueue_destroy(q);
+
+    // batches wrap around the storage end
+    ugeneric_t in[10];
+    ugeneric_t out[10];
+    for (size_t i = 0; i < ARR_LEN(in); i++)
+    {
+        in[i] = G_INT(i);
+    }
+    q = uqueue_create_ext(8, UQUEUE_GROW);
+    UASSERT_SIZE_EQ(uqueue_get_capacity(q), 8);
+    uqueue_enq_batch(q, in, 6);
+    UASSERT_SIZE_EQ(uqueue_deq_batch(q, out, 4), 4);
+    uqueue_enq_batch(q, &in[6], 4);
+    UASSERT_SIZE_EQ(uqueue_get_capacity(q), 8);
+    uqueue_enq_batch(q, in, 10);
+    UASSERT_SIZE_EQ(uqueue_get_size(q), 16);
+    UASSERT_SIZE_EQ(uqueue_deq_batch(q, &out[4], 6), 6);
+    for (size_t i = 0; i < ARR_LEN(out); i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(out[i]), i);
+    }
+    UASSERT_SIZE_EQ(uqueue_deq_batch(q, out, 20), 10);
+    UASSERT_INT_EQ(G_AS_INT(out[9]), 9);
+    UASSERT_SIZE_EQ(uqueue_deq_batch(q, out, 20), 0);
+    uqueue_destroy(q);
+
+    q = uqueue_create_ext(4, UQUEUE_OVERWRITE);
+    uqueue_enq_batch(q, in, 3);
+    uqueue_enq_batch(q, &in[3], 3);
+    str = uqueue_as_str(q);
+    UASSERT_STR_EQ(str, "[2, 3, 4, 5]");
+    ufree(str);
+    uqueue_enq_batch(q, in, 10);
+    str = uqueue_as_str(q);
+    UASSERT_STR_EQ(str, "[6, 7, 8, 9]");
+    ufree(str);
+
+    // iterator does not consume elements
+    uqueue_iterator_t *qi = uqueue_iterator_create(q);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (long i = 6; i < 10; i++)
+        {
+            UASSERT(uqueue_iterator_has_next(qi));
+            UASSERT_INT_EQ(G_AS_INT(uqueue_iterator_get_next(qi)), i);
+        }
+        UASSERT(!uqueue_iterator_has_next(qi));
+        uqueue_iterator_reset(qi);
+    }
+    uqueue_iterator_destroy(qi);
+    UASSERT_SIZE_EQ(uqueue_get_size(q), 4);
+    uqueue_destroy(q);
+
+    // owned elements are destroyed when dropped, cleared or left behind
+    q = uqueue_create_ext(2, UQUEUE_OVERWRITE);
+    for (int i = 0; i < 5; i++)
+    {
+        uqueue_enq(q, G_STR(ustring_fmt("%d", i)));
+    }
+    ugeneric_t batch[3];
+    for (int i = 0; i < 3; i++)
+    {
+        batch[i] = G_STR(ustring_fmt("b%d", i));
+    }
+    uqueue_enq_batch(q, batch, 3);
+    str = uqueue_as_str(q);
+    UASSERT_STR_EQ(str, "[\"b1\", \"b2\"]");
+    ufree(str);
+    uqueue_clear(q);
+    UASSERT(uqueue_is_empty(q));
+    uqueue_enq(q, G_STR(ustring_fmt("left")));
+    uqueue_destroy(q);
+
     return 0;
 }
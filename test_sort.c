@@ -1,8 +1,10 @@
 #include "mem.h"
 
 #include "file_utils.h"
+#include "dict.h"
 #include "generic.h"
 #include "sort.h"
+#include "string_utils.h"
 #include "ut_utils.h"
 #include "vector.h"
 
@@ -229,14 +231,421 @@ void test_count_iversions(void)
     UASSERT_LLINT_EQ(2407905288, count_inversions(f, ARR_LEN(f), NULL));
 }
 
+static size_t _ncmp;
+
+static int _counting_cmp(const void *p1, const void *p2)
+{
+    long l1 = *(const long *)p1;
+    long l2 = *(const long *)p2;
+    _ncmp++;
+    return (l1 > l2) - (l1 < l2);
+}
+
+void test_hybrid_sort_patterns(void)
+{
+    enum {N = 50000};
+    static long data[N];
+    static ugeneric_t a[N];
+    static ugeneric_t b[N];
+    size_t sizes[] = {0, 1, 2, 23, 24, 25, 129, 1000, N};
+
+    for (int pattern = 0; pattern < 7; pattern++)
+    {
+        for (size_t k = 0; k < ARR_LEN(sizes); k++)
+        {
+            size_t n = sizes[k];
+            for (size_t i = 0; i < n; i++)
+            {
+                switch (pattern)
+                {
+                    case 0: data[i] = i; break;                          // sorted
+                    case 1: data[i] = n - i; break;                      // reversed
+                    case 2: data[i] = 7; break;                          // all equal
+                    case 3: data[i] = (i < n / 2) ? i : n - i; break;    // organ pipe
+                    case 4: data[i] = i % 37; break;                     // sawtooth
+                    case 5: data[i] = rand() % 4; break;                 // few distinct
+                    default: data[i] = rand(); break;
+                }
+                a[i] = G_PTR(&data[i]);
+                b[i] = G_INT(data[i]);
+            }
+
+            _ncmp = 0;
+            hybrid_sort(a, n, _counting_cmp);
+            merge_sort(b, n, NULL);
+            for (size_t i = 0; i < n; i++)
+            {
+                UASSERT_INT_EQ(*(long *)G_AS_PTR(a[i]), G_AS_INT(b[i]));
+            }
+
+            /* Sorted and all-equal input is recognized in linear time, the
+             * rest is bounded by n*log(n) with a small factor.
+             */
+            if (n == N)
+            {
+                size_t limit = (pattern == 0 || pattern == 2) ? 4 * N : 3 * N * 16;
+                UASSERT(_ncmp < limit);
+            }
+        }
+    }
+}
+
+typedef struct {
+    long key;
+    size_t idx;
+} keyidx_t;
+
+static int _keyidx_cmp(const void *p1, const void *p2)
+{
+    const keyidx_t *k1 = p1;
+    const keyidx_t *k2 = p2;
+    _ncmp++;
+    return (k1->key > k2->key) - (k1->key < k2->key);
+}
+
+void test_timsort(void)
+{
+    enum {N = 30000};
+    static keyidx_t data[N];
+    static ugeneric_t a[N];
+
+    for (int pattern = 0; pattern < 6; pattern++)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            switch (pattern)
+            {
+                case 0: data[i].key = i; break;
+                case 1: data[i].key = N - i; break;
+                case 2: data[i].key = (i % 1000) + (i / 1000) * 10; break;   // overlapping runs
+                case 3: data[i].key = (i < N - 10) ? (long)i : rand() % N; break; // appended tail
+                case 4: data[i].key = rand() % 16; break;
+                default: data[i].key = rand(); break;
+            }
+            data[i].idx = i;
+            a[i] = G_PTR(&data[i]);
+        }
+
+        _ncmp = 0;
+        timsort(a, N, _keyidx_cmp);
+        if (pattern < 2)
+        {
+            UASSERT_SIZE_EQ(_ncmp, N - 1);
+        }
+        for (size_t i = 1; i < N; i++)
+        {
+            const keyidx_t *prev = G_AS_PTR(a[i - 1]);
+            const keyidx_t *cur = G_AS_PTR(a[i]);
+            UASSERT(prev->key <= cur->key);
+            if ((prev->key == cur->key) && (pattern != 1))
+            {
+                // Stability, reversed input has no equal keys.
+                UASSERT(prev->idx < cur->idx);
+            }
+        }
+    }
+
+    uvector_t *v = uvector_create();
+    UASSERT(uvector_get_sorter(v) == hybrid_sort);
+    uvector_set_sorter(v, timsort);
+    UASSERT(uvector_get_sorter(v) == timsort);
+    for (long i = 0; i < 1000; i++)
+    {
+        uvector_append(v, G_INT(i % 100 == 0 ? -i : i));
+    }
+    uvector_sort(v);
+    UASSERT(uvector_is_sorted(v));
+    uvector_set_sorter(v, NULL);
+    UASSERT(uvector_get_sorter(v) == hybrid_sort);
+    uvector_destroy(v);
+}
+
+static ugeneric_t _abs_key(ugeneric_t g, void *ctx)
+{
+    (void)ctx;
+    return G_INT(labs(G_AS_INT(g)));
+}
+
+void test_key_sort(void)
+{
+    const char *names[] = {
+        "carol", "alice", "long_common_prefix_b", "bob",
+        "long_common_prefix_a", "dave", "alice",
+    };
+    long ages[] = {30, 25, 40, 30, 25, 30, 41};
+
+    uvector_t *v = uvector_create();
+    for (size_t i = 0; i < ARR_LEN(names); i++)
+    {
+        udict_t *d = udict_create();
+        udict_put(d, G_CSTR("name"), G_CSTR(names[i]));
+        udict_put(d, G_CSTR("age"), G_INT(ages[i]));
+        udict_put(d, G_CSTR("idx"), G_SIZE(i));
+        uvector_append(v, G_DICT(d));
+    }
+    // No "age" field, goes first.
+    udict_t *d = udict_create();
+    udict_put(d, G_CSTR("name"), G_CSTR("zed"));
+    udict_put(d, G_CSTR("idx"), G_SIZE(ARR_LEN(names)));
+    uvector_append(v, G_DICT(d));
+
+    uvector_sort_by_field(v, "age");
+    size_t order_by_age[] = {7, 1, 4, 0, 3, 5, 2, 6};
+    for (size_t i = 0; i < ARR_LEN(order_by_age); i++)
+    {
+        udict_t *e = G_AS_PTR(uvector_get_at(v, i));
+        UASSERT_SIZE_EQ(G_AS_SIZE(udict_get(e, G_CSTR("idx"), G_NULL())),
+                        order_by_age[i]);
+    }
+
+    uvector_sort_by_field(v, "name");
+    size_t order_by_name[] = {1, 6, 3, 0, 5, 4, 2, 7};
+    for (size_t i = 0; i < ARR_LEN(order_by_name); i++)
+    {
+        udict_t *e = G_AS_PTR(uvector_get_at(v, i));
+        UASSERT_SIZE_EQ(G_AS_SIZE(udict_get(e, G_CSTR("idx"), G_NULL())),
+                        order_by_name[i]);
+    }
+    uvector_destroy(v);
+
+    // Numeric keys take the radix path and stay stable.
+    v = uvector_create();
+    for (long i = -500; i < 500; i++)
+    {
+        uvector_append(v, G_INT(i));
+    }
+    uvector_sort_by_key(v, _abs_key, NULL);
+    UASSERT_INT_EQ(G_AS_INT(uvector_get_at(v, 0)), 0);
+    for (size_t i = 1; i < uvector_get_size(v) - 1; i += 2)
+    {
+        UASSERT_INT_EQ(G_AS_INT(uvector_get_at(v, i)), -(long)(i + 1) / 2);
+        UASSERT_INT_EQ(G_AS_INT(uvector_get_at(v, i + 1)), (long)(i + 1) / 2);
+    }
+    UASSERT_INT_EQ(G_AS_INT(uvector_get_back(v)), -500);
+    uvector_destroy(v);
+}
+
+void test_selection(void)
+{
+    enum {N = 5000};
+    static ugeneric_t a[N];
+    static ugeneric_t sorted[N];
+    size_t sizes[] = {1, 2, 24, 25, 200, N};
+
+    for (int pattern = 0; pattern < 4; pattern++)
+    {
+        for (size_t k = 0; k < ARR_LEN(sizes); k++)
+        {
+            size_t n = sizes[k];
+            for (size_t i = 0; i < n; i++)
+            {
+                switch (pattern)
+                {
+                    case 0: sorted[i] = G_INT(i); break;
+                    case 1: sorted[i] = G_INT(n - i); break;
+                    case 2: sorted[i] = G_INT(rand() % 3); break;
+                    default: sorted[i] = G_INT(rand()); break;
+                }
+            }
+            memcpy(a, sorted, n * sizeof(a[0]));
+            merge_sort(sorted, n, NULL);
+
+            size_t nths[] = {0, n / 3, n / 2, n - 1};
+            for (size_t j = 0; j < ARR_LEN(nths); j++)
+            {
+                size_t nth = nths[j];
+                ugeneric_array_nth_element(a, n, nth, NULL);
+                UASSERT_INT_EQ(G_AS_INT(a[nth]), G_AS_INT(sorted[nth]));
+                for (size_t i = 0; i < n; i++)
+                {
+                    int c = ugeneric_compare(a[i], a[nth]);
+                    UASSERT((i < nth) ? (c <= 0) : (c >= 0));
+                }
+
+                ugeneric_array_partial_sort(a, n, nth + 1, NULL);
+                for (size_t i = 0; i <= nth; i++)
+                {
+                    UASSERT_INT_EQ(G_AS_INT(a[i]), G_AS_INT(sorted[i]));
+                }
+            }
+        }
+    }
+    ugeneric_array_partial_sort(a, 10, 0, NULL);
+
+    uvector_t *v = uvector_create();
+    for (long i = 0; i < 1000; i++)
+    {
+        uvector_append(v, G_INT((i * 7919) % 1000));
+    }
+    uvector_nth_element(v, 500);
+    UASSERT_INT_EQ(G_AS_INT(uvector_get_at(v, 500)), 500);
+    uvector_partial_sort(v, 10);
+    for (long i = 0; i < 10; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(uvector_get_at(v, i)), i);
+    }
+    uvector_destroy(v);
+}
+
+void test_network_sort(void)
+{
+    ugeneric_t a[USORT_NETWORK_MAX];
+
+    /* 0-1 principle: a network which sorts all sequences of zeros and ones
+     * sorts any sequence.
+     */
+    for (size_t n = 0; n <= USORT_NETWORK_MAX; n++)
+    {
+        for (size_t mask = 0; mask < ((size_t)1 << n); mask++)
+        {
+            for (int type = 0; type < 4; type++)
+            {
+                if ((type == 3) && (n > 10))
+                {
+                    break;
+                }
+                for (size_t i = 0; i < n; i++)
+                {
+                    bool bit = (mask >> i) & 1;
+                    switch (type)
+                    {
+                        case 0: a[i] = G_INT(bit ? 1 : -1); break;
+                        case 1: a[i] = G_SIZE(bit); break;
+                        case 2: a[i] = G_REAL(bit ? 0.5 : -0.5); break;
+                        default: a[i] = G_CSTR(bit ? "1" : "0"); break;
+                    }
+                }
+                network_sort(a, n, NULL);
+                UASSERT(ugeneric_array_is_sorted(a, n, NULL));
+            }
+        }
+    }
+
+    for (size_t n = 0; n <= USORT_NETWORK_MAX; n++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            a[i] = G_INT(rand() % 10 - 5);
+        }
+        network_sort(a, n, NULL);
+        UASSERT(ugeneric_array_is_sorted(a, n, NULL));
+        UASSERT(n == 0 || G_IS_INT(a[0]));
+    }
+}
+
+void test_radix_sort(void)
+{
+    static ugeneric_t a[10000];
+    static ugeneric_t b[ARR_LEN(a)];
+
+    for (int type = 0; type < 4; type++)
+    {
+        for (size_t i = 0; i < ARR_LEN(a); i++)
+        {
+            long r = rand() - RAND_MAX / 2;
+            switch (type)
+            {
+                case 0: a[i] = G_INT(r); break;
+                case 1: a[i] = G_INT(r * 1000003L); break;
+                case 2: a[i] = G_SIZE((size_t)rand() << (i % 32)); break;
+                default: a[i] = G_REAL((double)r / (i + 1)); break;
+            }
+        }
+        memcpy(b, a, sizeof(a));
+        UASSERT(radix_sort_supports(a, ARR_LEN(a)));
+        radix_sort(a, ARR_LEN(a), NULL);
+        merge_sort(b, ARR_LEN(b), NULL);
+        for (size_t i = 0; i < ARR_LEN(a); i++)
+        {
+            UASSERT_INT_EQ(ugeneric_compare(a[i], b[i]), 0);
+        }
+    }
+
+    // Keys with constant bytes, including the most significant ones.
+    for (size_t i = 0; i < ARR_LEN(a); i++)
+    {
+        a[i] = G_INT(ARR_LEN(a) - i);
+    }
+    radix_sort(a, ARR_LEN(a), NULL);
+    for (size_t i = 0; i < ARR_LEN(a); i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(a[i]), i + 1);
+    }
+
+    // Mixed types are not radix sortable.
+    a[ARR_LEN(a) / 2] = G_REAL(1.5);
+    UASSERT(!radix_sort_supports(a, ARR_LEN(a)));
+    radix_sort(a, ARR_LEN(a), NULL);
+    UASSERT(ugeneric_array_is_sorted(a, ARR_LEN(a), NULL));
+
+    double d[] = {0.0, -0.0, -1e300, 1e300, 1e-300, -1e-300, 3.5, -3.5};
+    uvector_t *v = uvector_create();
+    for (size_t i = 0; i < 100; i++)
+    {
+        uvector_append(v, G_REAL(d[i % ARR_LEN(d)]));
+    }
+    uvector_sort(v);
+    UASSERT(uvector_is_sorted(v));
+    UASSERT(G_AS_REAL(uvector_get_at(v, 0)) == -1e300);
+    UASSERT(G_AS_REAL(uvector_get_back(v)) == 1e300);
+    uvector_destroy(v);
+}
+
+void test_parallel_sort(void)
+{
+    static ugeneric_t a[3 * USORT_PARALLEL_THRESHOLD + 17];
+    static ugeneric_t b[ARR_LEN(a)];
+    size_t threads[] = {0, 1, 2, 3, 4, 7, 64};
+
+    for (size_t i = 0; i < ARR_LEN(a); i++)
+    {
+        a[i] = G_INT(rand() % 1000);
+    }
+
+    for (size_t i = 0; i < ARR_LEN(threads); i++)
+    {
+        memcpy(b, a, sizeof(a));
+        parallel_sort(b, ARR_LEN(b), NULL, threads[i]);
+        UASSERT(ugeneric_array_is_sorted(b, ARR_LEN(b), NULL));
+        UASSERT_INT_EQ(count_inversions(b, ARR_LEN(b), NULL), 0);
+    }
+
+    // Small arrays take the serial path.
+    memcpy(b, a, 100 * sizeof(a[0]));
+    parallel_sort(b, 100, NULL, 4);
+    UASSERT(ugeneric_array_is_sorted(b, 100, NULL));
+
+    // Strings are not radix sorted, so uvector_sort() takes parallel_sort().
+    uvector_t *v = uvector_create();
+    for (size_t i = 0; i < ARR_LEN(a); i++)
+    {
+        uvector_append(v, G_STR(ustring_fmt("%d", rand())));
+    }
+    libugeneric_set_sort_threads(4);
+    UASSERT_SIZE_EQ(libugeneric_get_sort_threads(), 4);
+    uvector_sort(v);
+    UASSERT(uvector_is_sorted(v));
+    libugeneric_set_sort_threads(1);
+    uvector_destroy(v);
+}
+
 int main(void)
 {
     test_count_iversions();
+    test_hybrid_sort_patterns();
+    test_timsort();
+    test_key_sort();
+    test_selection();
+    test_network_sort();
+    test_radix_sort();
+    test_parallel_sort();
     test_sort(merge_sort);
     test_sort(insertion_sort);
     test_sort(quick_sort);
     test_sort(hybrid_sort);
     test_sort(selection_sort);
+    test_sort(radix_sort);
+    test_sort(timsort);
 }
 
 void print_array(ugeneric_t *base, size_t nmemb)
@@ -0,0 +1,182 @@
+#include "spsc.h"
+
+#include "mem.h"
+#include "string_utils.h"
+#include "ut_utils.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+void test_uspsc_queue_api(void)
+{
+    uspsc_queue_t *q = uspsc_queue_create(5);
+    UASSERT_SIZE_EQ(uspsc_queue_get_capacity(q), 8);
+    UASSERT(uspsc_queue_is_empty(q));
+
+    ugeneric_t e;
+    UASSERT(!uspsc_queue_try_deq(q, &e));
+    UASSERT(!uspsc_queue_try_peek(q, &e));
+
+    // Wrap around the ring a few times.
+    for (long round = 0; round < 5; round++)
+    {
+        for (long i = 0; i < 8; i++)
+        {
+            UASSERT(uspsc_queue_try_enq(q, G_INT(round * 10 + i)));
+        }
+        UASSERT(uspsc_queue_is_full(q));
+        UASSERT(!uspsc_queue_try_enq(q, G_INT(-1)));
+        UASSERT(uspsc_queue_try_peek(q, &e));
+        UASSERT_INT_EQ(G_AS_INT(e), round * 10);
+
+        for (long i = 0; i < 5; i++)
+        {
+            UASSERT(uspsc_queue_try_deq(q, &e));
+            UASSERT_INT_EQ(G_AS_INT(e), round * 10 + i);
+        }
+        UASSERT_SIZE_EQ(uspsc_queue_get_size(q), 3);
+        for (long i = 5; i < 8; i++)
+        {
+            UASSERT_INT_EQ(G_AS_INT(uspsc_queue_deq(q)), round * 10 + i);
+        }
+        UASSERT(uspsc_queue_is_empty(q));
+        uspsc_queue_enq(q, G_INT(-1));
+        UASSERT_INT_EQ(G_AS_INT(uspsc_queue_deq(q)), -1);
+    }
+
+    uspsc_queue_enq(q, G_INT(1));
+    uspsc_queue_enq(q, G_CSTR("two"));
+    uspsc_queue_enq(q, G_REAL(3.5));
+    char *str = uspsc_queue_as_str(q);
+    UASSERT_STR_EQ(str, "[1, \"two\", 3.5]");
+    ufree(str);
+
+    umemusage_t u = uspsc_queue_get_memory_usage(q);
+    UASSERT_SIZE_EQ(u.slack, 5 * sizeof(ugeneric_t));
+
+    uspsc_queue_clear(q);
+    UASSERT(uspsc_queue_is_empty(q));
+    uspsc_queue_destroy(q);
+    uspsc_queue_destroy(NULL);
+}
+
+void test_uspsc_queue_batch(void)
+{
+    uspsc_queue_t *q = uspsc_queue_create(16);
+    ugeneric_t in[20];
+    ugeneric_t out[32];
+    for (long i = 0; i < 20; i++)
+    {
+        in[i] = G_INT(i);
+    }
+
+    UASSERT_SIZE_EQ(uspsc_queue_enq_batch(q, in, 10), 10);
+    UASSERT_SIZE_EQ(uspsc_queue_deq_batch(q, out, 7), 7);
+    // Wraps around the end of the ring and is cut at the capacity.
+    UASSERT_SIZE_EQ(uspsc_queue_enq_batch(q, &in[10], 10), 10);
+    UASSERT_SIZE_EQ(uspsc_queue_enq_batch(q, in, 20), 3);
+    UASSERT_SIZE_EQ(uspsc_queue_enq_batch(q, in, 1), 0);
+    UASSERT_SIZE_EQ(uspsc_queue_deq_batch(q, &out[7], 20), 16);
+    for (long i = 0; i < 23; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(out[i]), i % 20);
+    }
+    UASSERT_SIZE_EQ(uspsc_queue_deq_batch(q, out, 20), 0);
+    UASSERT_SIZE_EQ(uspsc_queue_enq_batch(q, NULL, 0), 0);
+    uspsc_queue_destroy(q);
+}
+
+void test_uspsc_queue_ownership(void)
+{
+    uspsc_queue_t *q = uspsc_queue_create(4);
+    uspsc_queue_enq(q, G_STR(ustring_fmt("%d", 1)));
+    uspsc_queue_enq(q, G_STR(ustring_fmt("%d", 2)));
+    UASSERT(uspsc_queue_get_memory_usage(q).payload > 0);
+    ugeneric_t e = uspsc_queue_deq(q);
+    UASSERT_STR_EQ(G_AS_STR(e), "1");
+    ugeneric_destroy(e);
+    // The rest is freed by the queue.
+    uspsc_queue_destroy(q);
+
+    q = uspsc_queue_create(4);
+    uspsc_queue_drop_data_ownership(q);
+    UASSERT(!uspsc_queue_is_data_owner(q));
+    char *str = ustring_fmt("x");
+    uspsc_queue_enq(q, G_STR(str));
+    uspsc_queue_destroy(q);
+    ufree(str);
+}
+
+#define TRANSFER_COUNT 200000
+
+static void *_producer(void *arg)
+{
+    uspsc_queue_t *q = arg;
+    ugeneric_t batch[37];
+    long next = 0;
+
+    while (next < TRANSFER_COUNT)
+    {
+        if (next % 3)
+        {
+            uspsc_queue_enq(q, G_INT(next++));
+            continue;
+        }
+
+        size_t n = 0;
+        for (; (n < ARR_LEN(batch)) && (next + (long)n < TRANSFER_COUNT); n++)
+        {
+            batch[n] = G_INT(next + n);
+        }
+        size_t done = uspsc_queue_enq_batch(q, batch, n);
+        if (!done)
+        {
+            sched_yield();
+        }
+        next += done;
+    }
+
+    return NULL;
+}
+
+void test_uspsc_queue_threads(void)
+{
+    uspsc_queue_t *q = uspsc_queue_create(64);
+    pthread_t producer;
+    UASSERT(pthread_create(&producer, NULL, _producer, q) == 0);
+
+    ugeneric_t batch[29];
+    long expected = 0;
+    while (expected < TRANSFER_COUNT)
+    {
+        if (expected % 2)
+        {
+            UASSERT_INT_EQ(G_AS_INT(uspsc_queue_deq(q)), expected++);
+            continue;
+        }
+
+        size_t n = uspsc_queue_deq_batch(q, batch, ARR_LEN(batch));
+        if (!n)
+        {
+            sched_yield();
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            UASSERT_INT_EQ(G_AS_INT(batch[i]), expected++);
+        }
+    }
+
+    pthread_join(producer, NULL);
+    UASSERT(uspsc_queue_is_empty(q));
+    uspsc_queue_destroy(q);
+}
+
+int main(void)
+{
+    test_uspsc_queue_api();
+    test_uspsc_queue_batch();
+    test_uspsc_queue_ownership();
+    test_uspsc_queue_threads();
+
+    return EXIT_SUCCESS;
+}
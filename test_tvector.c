@@ -0,0 +1,173 @@
+#include "tvector.h"
+
+#include "mem.h"
+#include "ut_utils.h"
+
+void test_uvector_i64_api(void)
+{
+    uvector_i64_t *v = uvector_i64_create();
+    UASSERT(uvector_i64_is_empty(v));
+
+    for (long i = 0; i < 100; i++)
+    {
+        uvector_i64_append(v, 99 - i);
+    }
+    UASSERT_SIZE_EQ(uvector_i64_get_size(v), 100);
+    UASSERT_INT_EQ(uvector_i64_get_at(v, 0), 99);
+    UASSERT_INT_EQ(uvector_i64_get_back(v), 0);
+    UASSERT(!uvector_i64_is_sorted(v));
+
+    uvector_i64_sort(v);
+    UASSERT(uvector_i64_is_sorted(v));
+    for (long i = 0; i < 100; i++)
+    {
+        UASSERT_INT_EQ(uvector_i64_get_at(v, i), i);
+        UASSERT_SIZE_EQ(uvector_i64_bsearch(v, i), i);
+    }
+    UASSERT_SIZE_EQ(uvector_i64_bsearch(v, -1), SIZE_MAX);
+    UASSERT_SIZE_EQ(uvector_i64_bsearch(v, 100), SIZE_MAX);
+
+    uvector_i64_set_at(v, 0, -5);
+    UASSERT_INT_EQ(uvector_i64_get_cells(v)[0], -5);
+    UASSERT_INT_EQ(uvector_i64_pop_back(v), 99);
+    UASSERT_SIZE_EQ(uvector_i64_get_size(v), 99);
+
+    uvector_i64_shrink_to_size(v);
+    UASSERT_SIZE_EQ(uvector_i64_get_capacity(v), 99);
+    umemusage_t u = uvector_i64_get_memory_usage(v);
+    UASSERT_SIZE_EQ(u.slack, 0);
+    UASSERT_SIZE_EQ(u.payload, 0);
+    UASSERT(u.structure >= 99 * sizeof(long));
+
+    uvector_i64_resize(v, 3, 0);
+    uvector_i64_resize(v, 5, 7);
+    char *str = uvector_i64_as_str(v);
+    UASSERT_STR_EQ(str, "[-5, 1, 2, 7, 7]");
+    ufree(str);
+
+    uvector_i64_t *c = uvector_i64_copy(v);
+    UASSERT_INT_EQ(uvector_i64_compare(v, c), 0);
+    uvector_i64_append(c, 1);
+    UASSERT(uvector_i64_compare(v, c) < 0);
+    uvector_i64_set_at(c, 0, 0);
+    UASSERT(uvector_i64_compare(v, c) < 0);
+    UASSERT(uvector_i64_compare(c, v) > 0);
+    uvector_i64_destroy(c);
+
+    uvector_i64_clear(v);
+    UASSERT(uvector_i64_is_empty(v));
+    uvector_i64_destroy(v);
+}
+
+void test_uvector_f64_slice(void)
+{
+    const double a[] = {0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5};
+    uvector_f64_t *v = uvector_f64_create_from_array(a, ARR_LEN(a));
+
+    uvector_f64_t *s = uvector_f64_get_slice(v, 1, 7, 2);
+    char *str = uvector_f64_as_str(s);
+    UASSERT_STR_EQ(str, "[1.5, 3.5, 5.5]");
+    ufree(str);
+    uvector_f64_destroy(s);
+
+    s = uvector_f64_get_slice(v, 0, 7, 3);
+    UASSERT_SIZE_EQ(uvector_f64_get_size(s), 3);
+    UASSERT(uvector_f64_get_at(s, 2) == 6.5);
+    uvector_f64_destroy(s);
+
+    s = uvector_f64_get_slice(v, 3, 3, 1);
+    UASSERT(uvector_f64_is_empty(s));
+    uvector_f64_destroy(s);
+
+    uvector_f64_destroy(v);
+}
+
+void test_uvector_size_conversion(void)
+{
+    uvector_t *boxed = uvector_create();
+    for (size_t i = 0; i < 10; i++)
+    {
+        uvector_append(boxed, G_SIZE(10 - i));
+    }
+
+    uvector_size_t *v = uvector_size_create_from_uvector(boxed);
+    UASSERT_SIZE_EQ(uvector_size_get_size(v), 10);
+    uvector_size_sort(v);
+    uvector_sort(boxed);
+
+    // Boxed and unboxed vectors serialize the same way.
+    char *s1 = uvector_as_str(boxed);
+    char *s2 = uvector_size_as_str(v);
+    UASSERT_STR_EQ(s1, s2);
+    ufree(s1);
+    ufree(s2);
+
+    uvector_t *back = uvector_size_as_uvector(v);
+    UASSERT_INT_EQ(uvector_compare(back, boxed), 0);
+    uvector_destroy(back);
+
+    uvector_size_destroy(v);
+    uvector_destroy(boxed);
+
+    v = uvector_size_create_with_size(4, 42);
+    s1 = uvector_size_as_str(v);
+    UASSERT_STR_EQ(s1, "[42, 42, 42, 42]");
+    ufree(s1);
+    uvector_size_destroy(v);
+}
+
+void test_uvector_typed_sort(void)
+{
+    // Typed sort agrees with the boxed one on a few input patterns.
+    size_t sizes[] = {0, 1, 2, 3, 24, 25, 100, 1000, 5000};
+    for (size_t k = 0; k < ARR_LEN(sizes); k++)
+    {
+        size_t n = sizes[k];
+        for (int pattern = 0; pattern < 5; pattern++)
+        {
+            uvector_i64_t *v = uvector_i64_create();
+            uvector_t *boxed = uvector_create();
+            for (size_t i = 0; i < n; i++)
+            {
+                long e = 0;
+                switch (pattern)
+                {
+                    case 0: e = rand() - RAND_MAX / 2; break;
+                    case 1: e = i; break;
+                    case 2: e = n - i; break;
+                    case 3: e = rand() % 4; break;
+                    default: e = (i < n / 2) ? i : n - i; break;
+                }
+                uvector_i64_append(v, e);
+                uvector_append(boxed, G_INT(e));
+            }
+            uvector_i64_sort(v);
+            uvector_sort(boxed);
+
+            uvector_t *back = uvector_i64_as_uvector(v);
+            UASSERT_INT_EQ(uvector_compare(back, boxed), 0);
+            uvector_destroy(back);
+            uvector_destroy(boxed);
+            uvector_i64_destroy(v);
+        }
+    }
+
+    // Negative zeros and duplicates of doubles.
+    double a[] = {3.5, -0.0, 0.0, -1.25, 3.5, 1e300, -1e300, 0.0};
+    uvector_f64_t *f = uvector_f64_create_from_array(a, ARR_LEN(a));
+    uvector_f64_sort(f);
+    UASSERT(uvector_f64_is_sorted(f));
+    UASSERT(uvector_f64_get_at(f, 0) == -1e300);
+    UASSERT(uvector_f64_get_back(f) == 1e300);
+    uvector_f64_destroy(f);
+}
+
+int main(void)
+{
+    test_uvector_i64_api();
+    test_uvector_f64_slice();
+    test_uvector_size_conversion();
+    test_uvector_typed_sort();
+
+    return EXIT_SUCCESS;
+}
@@ -150,6 +150,11 @@ void test_uvector_api()
 {
     uvector_t *v = uvector_create();
     uvector_append(v, G_INT(0));
+    UASSERT_SIZE_EQ(uvector_get_capacity(v), UVECTOR_INLINE_CAPACITY);
+    for (size_t i = 0; i < UVECTOR_INLINE_CAPACITY; i++)
+    {
+        uvector_append(v, G_INT(i));
+    }
     UASSERT(uvector_get_capacity(v) >= VECTOR_INITIAL_CAPACITY);
     uvector_reserve_capacity(v, 1000);
     UASSERT_INT_EQ(uvector_get_capacity(v), 1000);
@@ -407,6 +412,365 @@ void test_uvector_slice(void)
     uvector_destroy(v);
 }
 
+void test_uvector_view(void)
+{
+    ugeneric_t g = ugeneric_parse("[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]");
+    UASSERT_NO_ERROR(g);
+    uvector_t *v = G_AS_PTR(g);
+
+    // Views serialize the same way as slices do.
+    size_t params[][3] = {{0, 10, 1}, {1, 10, 2}, {0, 10, 3}, {1, 10, 9},
+                          {1, 1, 1}, {0, 10, 25}};
+    for (size_t i = 0; i < ARR_LEN(params); i++)
+    {
+        uvector_view_t w = uvector_view(v, params[i][0], params[i][1],
+                                        params[i][2]);
+        uvector_t *slice = uvector_get_slice(v, params[i][0], params[i][1],
+                                             params[i][2]);
+        char *s1 = uvector_view_as_str(w);
+        char *s2 = uvector_as_str(slice);
+        UASSERT_STR_EQ(s1, s2);
+        UASSERT_SIZE_EQ(uvector_view_get_size(w), uvector_get_size(slice));
+        ufree(s1);
+        ufree(s2);
+        uvector_destroy(slice);
+    }
+
+    uvector_view_t odd = uvector_view(v, 0, 10, 2);
+    UASSERT_SIZE_EQ(uvector_view_get_size(odd), 5);
+    UASSERT_INT_EQ(G_AS_INT(uvector_view_get_at(odd, 4)), 9);
+    UASSERT(uvector_view_is_sorted(odd));
+    UASSERT(uvector_view_contains(odd, G_INT(7)));
+    UASSERT(!uvector_view_contains(odd, G_INT(8)));
+    UASSERT_SIZE_EQ(uvector_view_bsearch(odd, G_INT(1)), 0);
+    UASSERT_SIZE_EQ(uvector_view_bsearch(odd, G_INT(7)), 3);
+    UASSERT_SIZE_EQ(uvector_view_bsearch(odd, G_INT(9)), 4);
+    UASSERT_SIZE_EQ(uvector_view_bsearch(odd, G_INT(4)), SIZE_MAX);
+    UASSERT_SIZE_EQ(uvector_view_bsearch(odd, G_INT(11)), SIZE_MAX);
+
+    // View of a view multiplies strides: [1, 5, 9].
+    uvector_view_t sub = uvector_view_get_view(odd, 0, 5, 2);
+    char *str = uvector_view_as_str(sub);
+    UASSERT_STR_EQ(str, "[1, 5, 9]");
+    ufree(str);
+
+    uvector_view_t even = uvector_view(v, 1, 10, 2);
+    UASSERT(uvector_view_compare(odd, even) < 0);
+    UASSERT(uvector_view_compare(even, odd) > 0);
+    UASSERT_INT_EQ(uvector_view_compare(odd, odd), 0);
+    UASSERT(uvector_view_compare(sub, uvector_view(v, 0, 1, 1)) > 0);
+    UASSERT(uvector_view_compare(uvector_view(v, 0, 1, 1), sub) < 0);
+
+    uvector_t *copy = uvector_view_as_uvector(even);
+    str = uvector_as_str(copy);
+    UASSERT_STR_EQ(str, "[2, 4, 6, 8, 10]");
+    ufree(str);
+    uvector_destroy(copy);
+
+    uvector_view_t empty = uvector_view(v, 3, 3, 1);
+    UASSERT(uvector_view_is_empty(empty));
+    UASSERT(uvector_view_is_sorted(empty));
+    UASSERT_SIZE_EQ(uvector_view_bsearch(empty, G_INT(1)), SIZE_MAX);
+    copy = uvector_view_as_uvector(empty);
+    UASSERT(uvector_is_empty(copy));
+    uvector_destroy(copy);
+
+    uvector_destroy(v);
+}
+
+static void _check_vector(const uvector_t *v, const char *exp)
+{
+    char *str = uvector_as_str(v);
+    UASSERT_STR_EQ(str, exp);
+    ufree(str);
+}
+
+void test_uvector_bulk(void)
+{
+    ugeneric_t g = ugeneric_parse("[\"a\", \"b\", \"c\"]");
+    UASSERT_NO_ERROR(g);
+    uvector_t *src = G_AS_PTR(g);
+    uvector_t *v = uvector_create();
+
+    // Deep copies are owned by v, src keeps its strings.
+    uvector_extend(v, src, UCOPY_DEEP);
+    uvector_extend(v, src, UCOPY_DEEP);
+    _check_vector(v, "[\"a\", \"b\", \"c\", \"a\", \"b\", \"c\"]");
+    UASSERT(G_AS_STR(uvector_get_at(v, 0)) != G_AS_STR(uvector_get_at(src, 0)));
+
+    uvector_remove_range(v, 1, 4);
+    _check_vector(v, "[\"a\", \"b\", \"c\"]");
+    uvector_remove_range(v, 1, 1);
+    uvector_remove_range(v, 3, 3);
+    UASSERT_SIZE_EQ(uvector_get_size(v), 3);
+
+    uvector_insert_range(v, 1, src, 1, 3, UCOPY_DEEP);
+    _check_vector(v, "[\"a\", \"b\", \"c\", \"b\", \"c\"]");
+    uvector_insert_range(v, 5, src, 0, 1, UCOPY_DEEP);
+    _check_vector(v, "[\"a\", \"b\", \"c\", \"b\", \"c\", \"a\"]");
+
+    // Self insertion and extension copy the source range first.
+    uvector_remove_range(v, 0, 6);
+    UASSERT(uvector_is_empty(v));
+    uvector_append(v, G_INT(1));
+    uvector_append(v, G_INT(2));
+    uvector_append(v, G_INT(3));
+    uvector_extend(v, v, UCOPY_SHALLOW);
+    _check_vector(v, "[1, 2, 3, 1, 2, 3]");
+    uvector_insert_range(v, 2, v, 0, 4, UCOPY_SHALLOW);
+    _check_vector(v, "[1, 2, 1, 2, 3, 1, 3, 1, 2, 3]");
+
+    const ugeneric_t a[] = {G_INT(7), G_INT(8)};
+    uvector_append_array(v, a, ARR_LEN(a), UCOPY_SHALLOW);
+    uvector_append_array(v, NULL, 0, UCOPY_SHALLOW);
+    _check_vector(v, "[1, 2, 1, 2, 3, 1, 3, 1, 2, 3, 7, 8]");
+    UASSERT_INT_EQ(G_AS_INT(uvector_pop_at(v, 4)), 3);
+    _check_vector(v, "[1, 2, 1, 2, 1, 3, 1, 2, 3, 7, 8]");
+
+    // Shallow extension of a non-owning vector shares the strings.
+    uvector_t *shared = uvector_create();
+    uvector_drop_data_ownership(shared);
+    uvector_extend(shared, src, UCOPY_SHALLOW);
+    UASSERT(G_AS_STR(uvector_get_at(shared, 2)) == G_AS_STR(uvector_get_at(src, 2)));
+    uvector_assign(v, shared, UCOPY_DEEP);
+    _check_vector(v, "[\"a\", \"b\", \"c\"]");
+    uvector_assign(v, v, UCOPY_DEEP);
+    UASSERT_SIZE_EQ(uvector_get_size(v), 3);
+    uvector_destroy(shared);
+
+    // One reservation per call.
+    uvector_t *big = uvector_create();
+    uvector_t *ints = uvector_create_with_size(1000, G_INT(0));
+    uvector_extend(big, ints, UCOPY_SHALLOW);
+    UASSERT_SIZE_EQ(uvector_get_capacity(big), 1000);
+    uvector_destroy(ints);
+    uvector_destroy(big);
+
+    uvector_destroy(v);
+    uvector_destroy(src);
+}
+
+void test_uvector_inline_storage(void)
+{
+    // Short vectors take a single allocation.
+#ifdef UMEM_COUNT_ALLOCATIONS
+    size_t count = libugeneric_get_allocation_count();
+#endif
+    uvector_t *v = uvector_create();
+    for (long i = 0; i < UVECTOR_INLINE_CAPACITY; i++)
+    {
+        uvector_append(v, G_INT(i));
+    }
+#ifdef UMEM_COUNT_ALLOCATIONS
+    UASSERT_SIZE_EQ(libugeneric_get_allocation_count() - count, 1);
+#endif
+    UASSERT_SIZE_EQ(uvector_get_memory_usage(v).slack, 0);
+
+    uvector_t *c = uvector_deep_copy(v);
+#ifdef UMEM_COUNT_ALLOCATIONS
+    UASSERT_SIZE_EQ(libugeneric_get_allocation_count() - count, 2);
+#endif
+    UASSERT_INT_EQ(uvector_compare(v, c), 0);
+    uvector_destroy(c);
+
+    // Spill to the heap and move back on shrinking.
+    uvector_append(v, G_INT(UVECTOR_INLINE_CAPACITY));
+    UASSERT_SIZE_EQ(uvector_get_capacity(v), VECTOR_INITIAL_CAPACITY);
+    for (long i = 0; i <= UVECTOR_INLINE_CAPACITY; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(uvector_get_at(v, i)), i);
+    }
+    c = uvector_copy(v);
+    UASSERT_INT_EQ(uvector_compare(v, c), 0);
+    uvector_destroy(c);
+    uvector_remove_range(v, 2, UVECTOR_INLINE_CAPACITY + 1);
+    uvector_shrink_to_size(v);
+    UASSERT_SIZE_EQ(uvector_get_capacity(v), UVECTOR_INLINE_CAPACITY);
+    UASSERT_SIZE_EQ(uvector_get_memory_usage(v).slack, 0);
+    char *str = uvector_as_str(v);
+    UASSERT_STR_EQ(str, "[0, 1]");
+    ufree(str);
+    uvector_destroy(v);
+
+    // Zero initial capacity grows from inline cells by SCALE_FACTOR.
+    v = uvector_create_ext(0);
+    for (long i = 0; i <= UVECTOR_INLINE_CAPACITY; i++)
+    {
+        uvector_append(v, G_INT(i));
+    }
+    UASSERT(uvector_get_capacity(v) < VECTOR_INITIAL_CAPACITY);
+    uvector_destroy(v);
+
+    v = uvector_create_ext(100);
+    UASSERT_SIZE_EQ(uvector_get_capacity(v), 100);
+    uvector_t *s = uvector_get_slice(v, 0, 0, 1);
+    UASSERT(uvector_is_empty(s));
+    uvector_destroy(s);
+    uvector_destroy(v);
+}
+
+void test_uvector_find(void)
+{
+    ugeneric_t g = ugeneric_parse("[1, \"1\", 2.5, -0.0, 1, null, 7, 2.5, 1]");
+    UASSERT_NO_ERROR(g);
+    uvector_t *v = G_AS_PTR(g);
+    uvector_append(v, G_SIZE(7));
+
+    UASSERT_SIZE_EQ(uvector_find(v, G_INT(1)), 0);
+    UASSERT_SIZE_EQ(uvector_count(v, G_INT(1)), 3);
+    UASSERT_SIZE_EQ(uvector_find(v, G_CSTR("1")), 1);
+    UASSERT_SIZE_EQ(uvector_find(v, G_REAL(2.5)), 2);
+    UASSERT_SIZE_EQ(uvector_count(v, G_REAL(2.5)), 2);
+    UASSERT_SIZE_EQ(uvector_find(v, G_REAL(0.0)), 3);
+    UASSERT_SIZE_EQ(uvector_find(v, G_NULL()), 5);
+    UASSERT_SIZE_EQ(uvector_find(v, G_SIZE(7)), 9);
+    UASSERT_SIZE_EQ(uvector_count(v, G_INT(7)), 1);
+    UASSERT_SIZE_EQ(uvector_find(v, G_INT(2)), SIZE_MAX);
+    UASSERT_SIZE_EQ(uvector_count(v, G_REAL(1.0)), 0);
+    UASSERT(uvector_contains(v, G_INT(7)));
+    UASSERT(!uvector_contains(v, G_SIZE(1)));
+
+    uvector_unique(v);
+    char *str = uvector_as_str(v);
+    UASSERT_STR_EQ(str, "[1, \"1\", 2.5, -0, null, 7, 7]");
+    ufree(str);
+    uvector_destroy(v);
+
+    // Matches are found in every position of blocks and tails.
+    for (long n = 1; n < 11; n++)
+    {
+        v = uvector_create();
+        for (long i = 0; i < n; i++)
+        {
+            uvector_append(v, G_REAL(i));
+        }
+        for (long i = 0; i < n; i++)
+        {
+            UASSERT_SIZE_EQ(uvector_find(v, G_REAL(i)), i);
+            UASSERT_SIZE_EQ(uvector_find(v, G_INT(i)), SIZE_MAX);
+            uvector_set_at(v, i, G_INT(i));
+            UASSERT_SIZE_EQ(uvector_find(v, G_INT(i)), i);
+        }
+        UASSERT_SIZE_EQ(uvector_find(v, G_INT(n)), SIZE_MAX);
+        uvector_destroy(v);
+    }
+}
+
+void test_uvector_unique(void)
+{
+    // Sorted input is compacted in place.
+    uvector_t *v = uvector_create();
+    for (long i = 0; i < 100; i++)
+    {
+        uvector_append(v, G_INT(i / 3));
+    }
+    uvector_unique(v);
+    UASSERT_SIZE_EQ(uvector_get_size(v), 34);
+    UASSERT(uvector_is_sorted(v));
+    uvector_destroy(v);
+
+    // Unsorted input keeps the first occurrences in order, owned
+    // duplicates are destroyed.
+    v = uvector_create();
+    uvector_t *exp = uvector_create();
+    for (long i = 0; i < 3 * UVECTOR_UNIQUE_HASH_THRESHOLD; i++)
+    {
+        long k = (i * 7) % UVECTOR_UNIQUE_HASH_THRESHOLD;
+        uvector_append(v, G_STR(ustring_fmt("%ld", k)));
+        if (i < UVECTOR_UNIQUE_HASH_THRESHOLD)
+        {
+            uvector_append(exp, G_STR(ustring_fmt("%ld", k)));
+        }
+    }
+    uvector_append(v, G_REAL(0.0));
+    uvector_append(v, G_REAL(-0.0));
+    uvector_append(exp, G_REAL(0.0));
+    uvector_unique(v);
+    UASSERT_INT_EQ(uvector_compare(v, exp), 0);
+    uvector_destroy(exp);
+    uvector_destroy(v);
+
+    // Unhashable elements fall back to pairwise comparison.
+    ugeneric_t g = ugeneric_parse("[[1], {\"a\": 1}, [1], [2], {\"a\": 1}, [2]]");
+    UASSERT_NO_ERROR(g);
+    v = G_AS_PTR(g);
+    uvector_unique(v);
+    char *str = uvector_as_str(v);
+    UASSERT_STR_EQ(str, "[[1], {\"a\": 1}, [2]]");
+    ufree(str);
+    uvector_destroy(v);
+}
+
+static ugeneric_t _format(ugeneric_t g, void *ctx)
+{
+    return G_STR(ustring_fmt(ctx, G_AS_INT(g)));
+}
+
+static bool _is_odd(ugeneric_t g, void *ctx)
+{
+    (void)ctx;
+    return G_AS_INT(g) % 2;
+}
+
+static ugeneric_t _sum(ugeneric_t acc, ugeneric_t g, void *ctx)
+{
+    (void)ctx;
+    return G_INT(G_AS_INT(acc) + G_AS_INT(g));
+}
+
+static void _square(ugeneric_t *g, void *ctx)
+{
+    (void)ctx;
+    G_AS_INT(*g) *= G_AS_INT(*g);
+}
+
+void test_uvector_map_filter_reduce(void)
+{
+    const long n = 10 * UVECTOR_PARALLEL_CHUNK + 3;
+    uvector_t *v = uvector_create();
+    for (long i = 0; i < n; i++)
+    {
+        uvector_append(v, G_INT(i));
+    }
+
+    uvector_t *m = uvector_map(v, _format, "<%ld>");
+    UASSERT_SIZE_EQ(uvector_get_size(m), n);
+    UASSERT_STR_EQ(G_AS_STR(uvector_get_at(m, 0)), "<0>");
+    UASSERT_STR_EQ(G_AS_STR(uvector_get_at(m, n - 1)), "<10242>");
+    uvector_destroy(m);
+
+    uvector_t *f = uvector_filter(v, _is_odd, NULL);
+    UASSERT_SIZE_EQ(uvector_get_size(f), n / 2);
+    UASSERT(uvector_is_sorted(f));
+    UASSERT_INT_EQ(G_AS_INT(uvector_get_at(f, 0)), 1);
+    UASSERT_INT_EQ(G_AS_INT(uvector_get_back(f)), n - 2);
+    UASSERT_INT_EQ(G_AS_INT(uvector_reduce(f, _sum, G_INT(0), NULL)),
+                   (n / 2) * (n / 2));
+    uvector_destroy(f);
+
+    UASSERT_INT_EQ(G_AS_INT(uvector_reduce(v, _sum, G_INT(5), NULL)),
+                   5 + n * (n - 1) / 2);
+
+    uvector_for_each_parallel(v, _square, NULL);
+    for (long i = 0; i < n; i++)
+    {
+        UASSERT_INT_EQ(G_AS_INT(uvector_get_at(v, i)), i * i);
+    }
+
+    // Empty vectors.
+    uvector_clear(v);
+    m = uvector_map(v, _format, "%ld");
+    UASSERT(uvector_is_empty(m));
+    uvector_destroy(m);
+    f = uvector_filter(v, _is_odd, NULL);
+    UASSERT(uvector_is_empty(f));
+    uvector_destroy(f);
+    UASSERT_INT_EQ(G_AS_INT(uvector_reduce(v, _sum, G_INT(42), NULL)), 42);
+    uvector_for_each_parallel(v, _square, NULL);
+
+    uvector_destroy(v);
+}
+
 void test_uvector_data_ownership(void)
 {
     uvector_t *v = uvector_create();
@@ -452,6 +816,82 @@ void test_uvector_reverse(void)
     _check_reverse("[1, 2, 3, 4, 5]", "[5, 4, 3, 2, 1]");
 }
 
+void test_uvector_memory_usage(void)
+{
+    uvector_t *v = uvector_create();
+    umemusage_t u = uvector_get_memory_usage(v);
+    UASSERT_SIZE_EQ(u.payload, 0);
+    UASSERT_SIZE_EQ(u.slack, 0);
+
+    uvector_reserve_capacity(v, 10);
+    uvector_append(v, G_INT(1));
+    uvector_append(v, G_STR(ustring_dup("str")));
+    uvector_append(v, G_CSTR("cstr"));
+    u = uvector_get_memory_usage(v);
+    UASSERT_SIZE_EQ(u.payload, sizeof("str"));
+    UASSERT_SIZE_EQ(u.slack, 7 * sizeof(ugeneric_t));
+
+    // Nested vectors are accounted as a part of payload.
+    uvector_t *n = uvector_create();
+    uvector_append(n, G_STR(ustring_dup("nested")));
+    uvector_shrink_to_size(n);
+    umemusage_t un = uvector_get_memory_usage(n);
+    uvector_append(v, G_VECTOR(n));
+    umemusage_t u2 = uvector_get_memory_usage(v);
+    UASSERT_SIZE_EQ(u2.payload, u.payload + sizeof("nested"));
+    UASSERT_SIZE_EQ(u2.structure, u.structure + un.structure + sizeof(ugeneric_t));
+    UASSERT_SIZE_EQ(umemusage_get_total(ugeneric_get_memory_usage(G_VECTOR(v))),
+                    umemusage_get_total(u2));
+
+    // Shallow copy does not own payload.
+    uvector_t *c = uvector_copy(v);
+    u = uvector_get_memory_usage(c);
+    UASSERT_SIZE_EQ(u.payload, 0);
+    UASSERT_SIZE_EQ(u.slack, 0);
+    uvector_destroy(c);
+
+    uvector_destroy(v);
+}
+
+void test_uvector_top_k(void)
+{
+    uvector_t *v = uvector_create();
+    for (long i = 0; i < 1000; i++)
+    {
+        uvector_append(v, G_INT((i * 7919) % 1000));
+    }
+
+    uvector_t *top = uvector_top_k(v, 5);
+    char *str = uvector_as_str(top);
+    UASSERT_STR_EQ(str, "[999, 998, 997, 996, 995]");
+    ufree(str);
+    uvector_destroy(top);
+
+    top = uvector_top_k(v, 0);
+    UASSERT(uvector_is_empty(top));
+    uvector_destroy(top);
+
+    top = uvector_top_k(v, 2000);
+    UASSERT_SIZE_EQ(uvector_get_size(top), 1000);
+    uvector_reverse(top);
+    UASSERT(uvector_is_sorted(top));
+    uvector_destroy(top);
+    uvector_destroy(v);
+
+    // Result shares elements with the source.
+    v = uvector_create();
+    uvector_append(v, G_STR(ustring_dup("b")));
+    uvector_append(v, G_STR(ustring_dup("a")));
+    uvector_append(v, G_STR(ustring_dup("c")));
+    top = uvector_top_k(v, 2);
+    str = uvector_as_str(top);
+    UASSERT_STR_EQ(str, "[\"c\", \"b\"]");
+    ufree(str);
+    UASSERT(!uvector_is_data_owner(top));
+    uvector_destroy(top);
+    uvector_destroy(v);
+}
+
 int main(int argc, char **argv)
 {
 //    test_gnuplot();
@@ -464,8 +904,16 @@ int main(int argc, char **argv)
     test_uvector_bsearch();
     test_uvector_compare();
     test_uvector_slice();
+    test_uvector_view();
+    test_uvector_bulk();
+    test_uvector_inline_storage();
+    test_uvector_find();
+    test_uvector_unique();
+    test_uvector_map_filter_reduce();
     test_uvector_data_ownership();
     test_uvector_reverse();
+    test_uvector_memory_usage();
+    test_uvector_top_k();
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,158 @@
+#include "wsdeque.h"
+
+#include "mem.h"
+#include "string_utils.h"
+#include "ut_utils.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+void test_uwsdeque_api(void)
+{
+    uwsdeque_t *d = uwsdeque_create();
+    UASSERT(uwsdeque_is_empty(d));
+    UASSERT_SIZE_EQ(uwsdeque_get_capacity(d), UWSDEQUE_INITIAL_CAPACITY);
+
+    ugeneric_t e;
+    UASSERT(!uwsdeque_pop(d, &e));
+    UASSERT(!uwsdeque_steal(d, &e));
+
+    // Owner pops newest, thieves steal oldest elements.
+    const long n = 10 * UWSDEQUE_INITIAL_CAPACITY;
+    for (long i = 0; i < n; i++)
+    {
+        uwsdeque_push(d, G_INT(i));
+    }
+    UASSERT_SIZE_EQ(uwsdeque_get_size(d), n);
+    UASSERT(uwsdeque_get_capacity(d) >= (size_t)n);
+    for (long i = 0; i < n / 2; i++)
+    {
+        UASSERT(uwsdeque_steal(d, &e));
+        UASSERT_INT_EQ(G_AS_INT(e), i);
+        UASSERT(uwsdeque_pop(d, &e));
+        UASSERT_INT_EQ(G_AS_INT(e), n - 1 - i);
+    }
+    UASSERT(uwsdeque_is_empty(d));
+    UASSERT(!uwsdeque_pop(d, &e));
+    UASSERT(!uwsdeque_steal(d, &e));
+
+    // Indices keep going around the ring.
+    for (long i = 0; i < 1000; i++)
+    {
+        uwsdeque_push(d, G_INT(i));
+        uwsdeque_push(d, G_INT(-i));
+        UASSERT(uwsdeque_steal(d, &e));
+        UASSERT_INT_EQ(G_AS_INT(e), i);
+        UASSERT(uwsdeque_pop(d, &e));
+        UASSERT_INT_EQ(G_AS_INT(e), -i);
+    }
+
+    uwsdeque_push(d, G_INT(1));
+    umemusage_t u = uwsdeque_get_memory_usage(d);
+    UASSERT(u.structure >= sizeof(ugeneric_t));
+    uwsdeque_clear(d);
+    UASSERT(uwsdeque_is_empty(d));
+    uwsdeque_destroy(d);
+    uwsdeque_destroy(NULL);
+
+    // Owned elements left behind are destroyed with the deque.
+    d = uwsdeque_create();
+    for (int i = 0; i < 100; i++)
+    {
+        uwsdeque_push(d, G_STR(ustring_fmt("%d", i)));
+    }
+    UASSERT(uwsdeque_steal(d, &e));
+    UASSERT_STR_EQ(G_AS_STR(e), "0");
+    ugeneric_destroy(e);
+    UASSERT(uwsdeque_get_memory_usage(d).payload > 0);
+    uwsdeque_destroy(d);
+}
+
+#define THIEVES 3
+#define ITEMS 100000
+
+typedef struct {
+    uwsdeque_t *d;
+    atomic_bool done;
+    atomic_size_t taken;
+    atomic_uchar seen[ITEMS];
+} _shared_t;
+
+static void _take(_shared_t *s, ugeneric_t e)
+{
+    atomic_fetch_add(&s->seen[G_AS_SIZE(e)], 1);
+    atomic_fetch_add(&s->taken, 1);
+}
+
+static void *_thief(void *arg)
+{
+    _shared_t *s = arg;
+    ugeneric_t e;
+
+    while (!atomic_load(&s->done) || !uwsdeque_is_empty(s->d))
+    {
+        if (uwsdeque_steal(s->d, &e))
+        {
+            _take(s, e);
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+void test_uwsdeque_threads(void)
+{
+    _shared_t *s = ucalloc(1, sizeof(*s));
+    s->d = uwsdeque_create();
+    atomic_init(&s->done, false);
+    atomic_init(&s->taken, 0);
+
+    pthread_t thieves[THIEVES];
+    for (size_t i = 0; i < THIEVES; i++)
+    {
+        UASSERT(pthread_create(&thieves[i], NULL, _thief, s) == 0);
+    }
+
+    // Owner pushes in bursts and pops a part back, as a task scheduler does.
+    ugeneric_t e;
+    for (size_t i = 0; i < ITEMS; i++)
+    {
+        uwsdeque_push(s->d, G_SIZE(i));
+        if ((i % 7 == 0) && uwsdeque_pop(s->d, &e))
+        {
+            _take(s, e);
+        }
+    }
+    while (uwsdeque_pop(s->d, &e))
+    {
+        _take(s, e);
+    }
+    atomic_store(&s->done, true);
+
+    for (size_t i = 0; i < THIEVES; i++)
+    {
+        pthread_join(thieves[i], NULL);
+    }
+
+    UASSERT_SIZE_EQ(atomic_load(&s->taken), ITEMS);
+    for (size_t i = 0; i < ITEMS; i++)
+    {
+        UASSERT_INT_EQ(atomic_load(&s->seen[i]), 1);
+    }
+
+    uwsdeque_destroy(s->d);
+    ufree(s);
+}
+
+int main(void)
+{
+    test_uwsdeque_api();
+    test_uwsdeque_threads();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,495 @@
+#include "tvector.h"
+
+#include "asserts.h"
+#include "mem.h"
+#include "sort.h"
+
+/* [0][1][2][...][size - 1][.][.][...][.][.][capacity - 1] */
+
+#define DEFINE_TYPED_VECTOR(_name_, _type_, _tag_, _box_, _unbox_)              \
+                                                                                \
+struct _name_##_opaq {                                                          \
+    _type_ *cells;                                                              \
+    size_t size;                                                                \
+    size_t capacity;                                                            \
+};                                                                              \
+                                                                                \
+static int _name_##_cmp(const void *ptr1, const void *ptr2)                     \
+{                                                                               \
+    _type_ e1 = *(const _type_ *)ptr1;                                          \
+    _type_ e2 = *(const _type_ *)ptr2;                                          \
+    if ((e1 != e1) || (e2 != e2))                                               \
+    {                                                                           \
+        UABORT("NAN in comparison");                                            \
+    }                                                                           \
+    return (e1 > e2) - (e1 < e2);                                               \
+}                                                                               \
+                                                                                \
+_name_##_t *_name_##_create(void)                                               \
+{                                                                               \
+    _name_##_t *v = umalloc(sizeof(*v));                                        \
+    v->cells = NULL;                                                            \
+    v->size = 0;                                                                \
+    v->capacity = 0;                                                            \
+                                                                                \
+    return v;                                                                   \
+}                                                                               \
+                                                                                \
+_name_##_t *_name_##_create_with_size(size_t size, _type_ value)                \
+{                                                                               \
+    _name_##_t *v = _name_##_create();                                          \
+    _name_##_resize(v, size, value);                                            \
+                                                                                \
+    return v;                                                                   \
+}                                                                               \
+                                                                                \
+_name_##_t *_name_##_create_from_array(const _type_ *array, size_t array_len)   \
+{                                                                               \
+    UASSERT_INPUT(array || !array_len);                                         \
+                                                                                \
+    _name_##_t *v = _name_##_create();                                          \
+    if (array_len)                                                              \
+    {                                                                           \
+        _name_##_reserve_capacity(v, array_len);                                \
+        memcpy(v->cells, array, array_len * sizeof(v->cells[0]));               \
+        v->size = array_len;                                                    \
+    }                                                                           \
+                                                                                \
+    return v;                                                                   \
+}                                                                               \
+                                                                                \
+_name_##_t *_name_##_create_from_uvector(const uvector_t *v)                    \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    size_t size = uvector_get_size(v);                                          \
+    const ugeneric_t *cells = uvector_get_cells(v);                             \
+    _name_##_t *tv = _name_##_create();                                         \
+    if (size)                                                                   \
+    {                                                                           \
+        _name_##_reserve_capacity(tv, size);                                    \
+        for (size_t i = 0; i < size; i++)                                       \
+        {                                                                       \
+            UASSERT_INPUT(ugeneric_get_type(cells[i]) == _tag_);                \
+            tv->cells[i] = _unbox_(cells[i]);                                   \
+        }                                                                       \
+        tv->size = size;                                                        \
+    }                                                                           \
+                                                                                \
+    return tv;                                                                  \
+}                                                                               \
+                                                                                \
+uvector_t *_name_##_as_uvector(const _name_##_t *v)                             \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    uvector_t *boxed = uvector_create();                                        \
+    if (v->size)                                                                \
+    {                                                                           \
+        uvector_reserve_capacity(boxed, v->size);                               \
+        for (size_t i = 0; i < v->size; i++)                                    \
+        {                                                                       \
+            uvector_append(boxed, _box_(v->cells[i]));                          \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    return boxed;                                                               \
+}                                                                               \
+                                                                                \
+void _name_##_destroy(_name_##_t *v)                                            \
+{                                                                               \
+    if (v)                                                                      \
+    {                                                                           \
+        ufree_large(v->cells, v->capacity * sizeof(v->cells[0]));               \
+        ufree(v);                                                               \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+void _name_##_clear(_name_##_t *v)                                              \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    v->size = 0;                                                                \
+}                                                                               \
+                                                                                \
+_name_##_t *_name_##_copy(const _name_##_t *v)                                  \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    return _name_##_create_from_array(v->cells, v->size);                       \
+}                                                                               \
+                                                                                \
+int _name_##_compare(const _name_##_t *v1, const _name_##_t *v2)                \
+{                                                                               \
+    UASSERT_INPUT(v1);                                                          \
+    UASSERT_INPUT(v2);                                                          \
+                                                                                \
+    size_t len = MIN(v1->size, v2->size);                                       \
+    for (size_t i = 0; i < len; i++)                                            \
+    {                                                                           \
+        int diff = _name_##_cmp(&v1->cells[i], &v2->cells[i]);                  \
+        if (diff)                                                               \
+        {                                                                       \
+            return diff;                                                        \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    return (v1->size > v2->size) - (v1->size < v2->size);                       \
+}                                                                               \
+                                                                                \
+void _name_##_append(_name_##_t *v, _type_ e)                                   \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    if (v->capacity == v->size)                                                 \
+    {                                                                           \
+        size_t new_capacity = MAX(SCALE_FACTOR * v->size,                       \
+                                  VECTOR_INITIAL_CAPACITY);                     \
+        _name_##_reserve_capacity(v, new_capacity);                             \
+    }                                                                           \
+    v->cells[v->size++] = e;                                                    \
+}                                                                               \
+                                                                                \
+_type_ _name_##_pop_back(_name_##_t *v)                                         \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    UASSERT_INPUT(v->size);                                                     \
+    return v->cells[--v->size];                                                 \
+}                                                                               \
+                                                                                \
+_type_ _name_##_get_back(const _name_##_t *v)                                   \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    UASSERT_INPUT(v->size);                                                     \
+    return v->cells[v->size - 1];                                               \
+}                                                                               \
+                                                                                \
+_type_ _name_##_get_at(const _name_##_t *v, size_t i)                           \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    UASSERT_INPUT(i < v->size);                                                 \
+    return v->cells[i];                                                         \
+}                                                                               \
+                                                                                \
+void _name_##_set_at(_name_##_t *v, size_t i, _type_ e)                         \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    UASSERT_INPUT(i < v->size);                                                 \
+    v->cells[i] = e;                                                            \
+}                                                                               \
+                                                                                \
+_type_ *_name_##_get_cells(const _name_##_t *v)                                 \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    return v->cells;                                                            \
+}                                                                               \
+                                                                                \
+bool _name_##_is_empty(const _name_##_t *v)                                     \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    return v->size == 0;                                                        \
+}                                                                               \
+                                                                                \
+size_t _name_##_get_size(const _name_##_t *v)                                   \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    return v->size;                                                             \
+}                                                                               \
+                                                                                \
+void _name_##_resize(_name_##_t *v, size_t new_size, _type_ value)              \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    _name_##_reserve_capacity(v, new_size);                                     \
+    for (size_t i = v->size; i < new_size; i++)                                 \
+    {                                                                           \
+        v->cells[i] = value;                                                    \
+    }                                                                           \
+    v->size = new_size;                                                         \
+}                                                                               \
+                                                                                \
+void _name_##_shrink_to_size(_name_##_t *v)                                     \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    if (v->capacity && v->size && (v->capacity > v->size))                      \
+    {                                                                           \
+        v->cells = urealloc_large(v->cells, v->capacity * sizeof(v->cells[0]), \
+                                  v->size * sizeof(v->cells[0]));               \
+        v->capacity = v->size;                                                  \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+void _name_##_reserve_capacity(_name_##_t *v, size_t new_capacity)              \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    if (v->capacity < new_capacity)                                             \
+    {                                                                           \
+        v->cells = urealloc_large(v->cells, v->capacity * sizeof(v->cells[0]), \
+                                  new_capacity * sizeof(v->cells[0]));          \
+        v->capacity = new_capacity;                                             \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+size_t _name_##_get_capacity(const _name_##_t *v)                               \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    return v->capacity;                                                         \
+}                                                                               \
+                                                                                \
+umemusage_t _name_##_get_memory_usage(const _name_##_t *v)                      \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    umemusage_t u = {0};                                                        \
+    u.structure = sizeof(*v) + v->size * sizeof(v->cells[0]);                   \
+    u.slack = (v->capacity - v->size) * sizeof(v->cells[0]);                    \
+                                                                                \
+    return u;                                                                   \
+}                                                                               \
+                                                                                \
+_name_##_t *_name_##_get_slice(const _name_##_t *v, size_t begin, size_t end,   \
+                               size_t stride)                                   \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    UASSERT_INPUT(begin <= end);                                                \
+    UASSERT_INPUT(end <= v->size);                                              \
+    UASSERT_INPUT(stride != 0);                                                 \
+                                                                                \
+    _name_##_t *slice = _name_##_create();                                      \
+    size_t size = (end - begin) / stride + (bool)((end - begin) % stride);      \
+    if (size)                                                                   \
+    {                                                                           \
+        _name_##_reserve_capacity(slice, size);                                 \
+        for (size_t i = 0; i < size; i++)                                       \
+        {                                                                       \
+            slice->cells[i] = v->cells[begin + i * stride];                     \
+        }                                                                       \
+        slice->size = size;                                                     \
+    }                                                                           \
+                                                                                \
+    return slice;                                                               \
+}                                                                               \
+                                                                                \
+static inline void _name_##_swap(_type_ *a, size_t i, size_t j)                 \
+{                                                                               \
+    _type_ t = a[i];                                                            \
+    a[i] = a[j];                                                                \
+    a[j] = t;                                                                   \
+}                                                                               \
+                                                                                \
+static void _name_##_insertion_sort(_type_ *a, size_t n)                        \
+{                                                                               \
+    for (size_t i = 1; i < n; i++)                                              \
+    {                                                                           \
+        _type_ x = a[i];                                                        \
+        size_t j = i;                                                           \
+        for (; (j > 0) && (x < a[j - 1]); j--)                                  \
+        {                                                                       \
+            a[j] = a[j - 1];                                                    \
+        }                                                                       \
+        a[j] = x;                                                               \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static void _name_##_sift_down(_type_ *a, size_t i, size_t n)                   \
+{                                                                               \
+    _type_ x = a[i];                                                            \
+    for (size_t c = 2 * i + 1; c < n; i = c, c = 2 * i + 1)                     \
+    {                                                                           \
+        if ((c + 1 < n) && (a[c] < a[c + 1]))                                   \
+        {                                                                       \
+            c++;                                                                \
+        }                                                                       \
+        if (!(x < a[c]))                                                        \
+        {                                                                       \
+            break;                                                              \
+        }                                                                       \
+        a[i] = a[c];                                                            \
+    }                                                                           \
+    a[i] = x;                                                                   \
+}                                                                               \
+                                                                                \
+static void _name_##_heap_sort(_type_ *a, size_t n)                             \
+{                                                                               \
+    for (size_t i = n / 2; i-- > 0;)                                            \
+    {                                                                           \
+        _name_##_sift_down(a, i, n);                                            \
+    }                                                                           \
+    for (size_t i = n - 1; i > 0; i--)                                          \
+    {                                                                           \
+        _name_##_swap(a, 0, i);                                                 \
+        _name_##_sift_down(a, 0, i);                                            \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+/* Quick sort with median of three pivots, falls back to heap sort when         \
+ * recursion gets too deep and to insertion sort on short ranges.               \
+ */                                                                             \
+static void _name_##_introsort(_type_ *a, size_t n, size_t depth)               \
+{                                                                               \
+    while (n > USORT_HYBRID_THRESHOLD)                                          \
+    {                                                                           \
+        if (depth-- == 0)                                                       \
+        {                                                                       \
+            _name_##_heap_sort(a, n);                                           \
+            return;                                                             \
+        }                                                                       \
+                                                                                \
+        size_t m = n / 2;                                                       \
+        if (a[m] < a[0])                                                        \
+        {                                                                       \
+            _name_##_swap(a, 0, m);                                             \
+        }                                                                       \
+        if (a[n - 1] < a[m])                                                    \
+        {                                                                       \
+            _name_##_swap(a, m, n - 1);                                         \
+            if (a[m] < a[0])                                                    \
+            {                                                                   \
+                _name_##_swap(a, 0, m);                                         \
+            }                                                                   \
+        }                                                                       \
+                                                                                \
+        /* a[0] <= p <= a[n - 1] stop both scans on the first pass, so          \
+         * [0, i) <= p <= [i, n) ends up with both parts non-empty.             \
+         */                                                                     \
+        _type_ p = a[m];                                                        \
+        size_t i = 0;                                                           \
+        size_t j = n - 1;                                                       \
+        for (;;)                                                                \
+        {                                                                       \
+            while (a[i] < p)                                                    \
+            {                                                                   \
+                i++;                                                            \
+            }                                                                   \
+            while (p < a[j])                                                    \
+            {                                                                   \
+                j--;                                                            \
+            }                                                                   \
+            if (i >= j)                                                         \
+            {                                                                   \
+                break;                                                          \
+            }                                                                   \
+            _name_##_swap(a, i++, j--);                                         \
+        }                                                                       \
+                                                                                \
+        /* Recurse into the shorter part, loop over the longer one. */          \
+        if (i < n - i)                                                          \
+        {                                                                       \
+            _name_##_introsort(a, i, depth);                                    \
+            a += i;                                                             \
+            n -= i;                                                             \
+        }                                                                       \
+        else                                                                    \
+        {                                                                       \
+            _name_##_introsort(a + i, n - i, depth);                            \
+            n = i;                                                              \
+        }                                                                       \
+    }                                                                           \
+    _name_##_insertion_sort(a, n);                                              \
+}                                                                               \
+                                                                                \
+void _name_##_sort(_name_##_t *v)                                               \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    for (size_t i = 0; i < v->size; i++)                                        \
+    {                                                                           \
+        if (v->cells[i] != v->cells[i])                                         \
+        {                                                                       \
+            UABORT("NAN in comparison");                                        \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    size_t depth = 0;                                                           \
+    for (size_t n = v->size; n > 1; n >>= 1)                                    \
+    {                                                                           \
+        depth += 2;                                                             \
+    }                                                                           \
+    _name_##_introsort(v->cells, v->size, depth);                               \
+}                                                                               \
+                                                                                \
+bool _name_##_is_sorted(const _name_##_t *v)                                    \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    for (size_t i = 1; i < v->size; i++)                                        \
+    {                                                                           \
+        if (v->cells[i - 1] > v->cells[i])                                      \
+        {                                                                       \
+            return false;                                                       \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+size_t _name_##_bsearch(const _name_##_t *v, _type_ e)                          \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    /* [l, r) */                                                                \
+    size_t l = 0;                                                               \
+    size_t r = v->size;                                                         \
+    while (l < r)                                                               \
+    {                                                                           \
+        size_t m = l + (r - l) / 2;                                             \
+        if (v->cells[m] < e)                                                    \
+        {                                                                       \
+            l = m + 1;                                                          \
+        }                                                                       \
+        else                                                                    \
+        {                                                                       \
+            r = m;                                                              \
+        }                                                                       \
+    }                                                                           \
+                                                                                \
+    return ((l < v->size) && (v->cells[l] == e)) ? l : SIZE_MAX;                \
+}                                                                               \
+                                                                                \
+void _name_##_serialize(const _name_##_t *v, ubuffer_t *buf)                    \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    UASSERT_INPUT(buf);                                                         \
+                                                                                \
+    ubuffer_append_byte(buf, '[');                                              \
+    for (size_t i = 0; i < v->size; i++)                                        \
+    {                                                                           \
+        ugeneric_serialize(_box_(v->cells[i]), buf);                            \
+        if (i < v->size - 1)                                                    \
+        {                                                                       \
+            ubuffer_append_data(buf, ", ", 2);                                  \
+        }                                                                       \
+    }                                                                           \
+    ubuffer_append_byte(buf, ']');                                              \
+}                                                                               \
+                                                                                \
+char *_name_##_as_str(const _name_##_t *v)                                      \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+                                                                                \
+    ubuffer_t buf = {0};                                                        \
+    _name_##_serialize(v, &buf);                                                \
+    ubuffer_null_terminate(&buf);                                               \
+                                                                                \
+    return buf.data;                                                            \
+}                                                                               \
+                                                                                \
+int _name_##_fprint(const _name_##_t *v, FILE *out)                             \
+{                                                                               \
+    UASSERT_INPUT(v);                                                           \
+    UASSERT_INPUT(out);                                                         \
+                                                                                \
+    char *str = _name_##_as_str(v);                                             \
+    int ret = fprintf(out, "%s\n", str);                                        \
+    ufree(str);                                                                 \
+                                                                                \
+    return ret;                                                                 \
+}
+
+static inline long _unbox_int(ugeneric_t g)     {return G_AS_INT(g);}
+static inline double _unbox_real(ugeneric_t g)  {return G_AS_REAL(g);}
+static inline size_t _unbox_size(ugeneric_t g)  {return G_AS_SIZE(g);}
+
+DEFINE_TYPED_VECTOR(uvector_i64, long, G_INT_T, G_INT, _unbox_int)
+DEFINE_TYPED_VECTOR(uvector_f64, double, G_REAL_T, G_REAL, _unbox_real)
+DEFINE_TYPED_VECTOR(uvector_size, size_t, G_SIZE_T, G_SIZE, _unbox_size)
@@ -0,0 +1,61 @@
+#ifndef UTVECTOR_H__
+#define UTVECTOR_H__
+
+#include "generic.h"
+#include "vector.h"
+
+/*
+ * Typed vectors keep numeric elements unboxed in a contiguous array of
+ * the native type instead of an array of ugeneric_t, so they take half
+ * of the memory and compare elements without type dispatching:
+ *
+ *     uvector_i64_t  - long   (G_INT_T)
+ *     uvector_f64_t  - double (G_REAL_T)
+ *     uvector_size_t - size_t (G_SIZE_T)
+ *
+ * API mirrors uvector_t, uvector_xxx_as_uvector() and
+ * uvector_xxx_create_from_uvector() convert from/to boxed vectors.
+ */
+
+typedef struct uvector_i64_opaq uvector_i64_t;
+typedef struct uvector_f64_opaq uvector_f64_t;
+typedef struct uvector_size_opaq uvector_size_t;
+
+#define DECLARE_TYPED_VECTOR(_name_, _type_)                                    \
+_name_##_t *_name_##_create(void);                                              \
+_name_##_t *_name_##_create_with_size(size_t size, _type_ value);               \
+_name_##_t *_name_##_create_from_array(const _type_ *array, size_t array_len);  \
+_name_##_t *_name_##_create_from_uvector(const uvector_t *v);                   \
+uvector_t *_name_##_as_uvector(const _name_##_t *v);                            \
+void _name_##_destroy(_name_##_t *v);                                           \
+void _name_##_clear(_name_##_t *v);                                             \
+_name_##_t *_name_##_copy(const _name_##_t *v);                                 \
+int _name_##_compare(const _name_##_t *v1, const _name_##_t *v2);               \
+void _name_##_append(_name_##_t *v, _type_ e);                                  \
+_type_ _name_##_pop_back(_name_##_t *v);                                        \
+_type_ _name_##_get_back(const _name_##_t *v);                                  \
+_type_ _name_##_get_at(const _name_##_t *v, size_t i);                          \
+void _name_##_set_at(_name_##_t *v, size_t i, _type_ e);                        \
+_type_ *_name_##_get_cells(const _name_##_t *v);                                \
+bool _name_##_is_empty(const _name_##_t *v);                                    \
+size_t _name_##_get_size(const _name_##_t *v);                                  \
+void _name_##_resize(_name_##_t *v, size_t new_size, _type_ value);             \
+void _name_##_shrink_to_size(_name_##_t *v);                                    \
+void _name_##_reserve_capacity(_name_##_t *v, size_t new_capacity);             \
+size_t _name_##_get_capacity(const _name_##_t *v);                              \
+umemusage_t _name_##_get_memory_usage(const _name_##_t *v);                     \
+_name_##_t *_name_##_get_slice(const _name_##_t *v, size_t begin, size_t end,   \
+                               size_t stride);                                  \
+void _name_##_sort(_name_##_t *v);                                              \
+bool _name_##_is_sorted(const _name_##_t *v);                                   \
+size_t _name_##_bsearch(const _name_##_t *v, _type_ e);                         \
+char *_name_##_as_str(const _name_##_t *v);                                     \
+void _name_##_serialize(const _name_##_t *v, ubuffer_t *buf);                   \
+int _name_##_fprint(const _name_##_t *v, FILE *out);                            \
+static inline int _name_##_print(const _name_##_t *v) {return _name_##_fprint(v, stdout);}
+
+DECLARE_TYPED_VECTOR(uvector_i64, long)
+DECLARE_TYPED_VECTOR(uvector_f64, double)
+DECLARE_TYPED_VECTOR(uvector_size, size_t)
+
+#endif
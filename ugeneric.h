@@ -11,13 +11,19 @@ extern "C" {
 #include "file_utils.h"
 #include "heap.h"
 #include "htbl.h"
+#include "iheap.h"
 #include "list.h"
 #include "mem.h"
+#include "mpmc.h"
+#include "pool.h"
 #include "queue.h"
 #include "set.h"
 #include "sort.h"
+#include "spsc.h"
 #include "string_utils.h"
+#include "tvector.h"
 #include "vector.h"
+#include "wsdeque.h"
 
 #if defined(__cplusplus)
 }
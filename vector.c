@@ -1,18 +1,32 @@
 #include "vector.h"
 
 #include "asserts.h"
+#include "heap.h"
+#include "htbl.h"
 #include "mem.h"
+#include "pool.h"
 #include "sort.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 /* [0][1][2][...][size - 1][.][.][...][.][.][capacity - 1] */
 
+/*
+ * Cells live in inline_cells until the vector outgrows them, so short
+ * vectors take a single allocation. capacity is never less than
+ * UVECTOR_INLINE_CAPACITY.
+ */
 struct uvector_opaq {
     uvoid_handlers_t void_handlers;
     bool is_data_owner;
     ugeneric_t *cells;
     size_t size;
     size_t capacity;
+    size_t initial_capacity;
     ugeneric_sorter_t sorter;
+    ugeneric_t inline_cells[UVECTOR_INLINE_CAPACITY];
 };
 
 static ugeneric_sorter_t _default_vector_sorter = hybrid_sort;
@@ -22,24 +36,29 @@ static uvector_t *_allocate_vector(void)
     uvector_t *v = umalloc(sizeof(*v));
     memset(&v->void_handlers, 0, sizeof(v->void_handlers));
     v->size = 0;
-    v->capacity = 0;
-    v->cells = NULL;
+    v->capacity = UVECTOR_INLINE_CAPACITY;
+    v->initial_capacity = VECTOR_INITIAL_CAPACITY;
+    v->cells = v->inline_cells;
     v->is_data_owner = true;
     v->sorter = _default_vector_sorter;
 
     return v;
 }
 
+static inline bool _is_inline(const uvector_t *v)
+{
+    return v->cells == v->inline_cells;
+}
+
 static uvector_t *_vcpy(const uvector_t *v, bool deep)
 {
     UASSERT_INPUT(v);
 
     uvector_t *copy = _allocate_vector();
-    memcpy(copy, v, sizeof(*v));
-    if (v->size)
-    {
-        copy->cells = umalloc(v->size * sizeof(copy->cells[0]));
-    }
+    copy->void_handlers = v->void_handlers;
+    copy->initial_capacity = v->initial_capacity;
+    copy->sorter = v->sorter;
+    uvector_reserve_capacity(copy, v->size);
 
     copy->is_data_owner = deep;
     if (deep)
@@ -56,6 +75,7 @@ static uvector_t *_vcpy(const uvector_t *v, bool deep)
             memcpy(copy->cells, v->cells, v->size * sizeof(copy->cells[0]));
         }
     }
+    copy->size = v->size;
 
     return copy;
 }
@@ -110,6 +130,15 @@ uvector_t *uvector_create(void)
     return _allocate_vector();
 }
 
+uvector_t *uvector_create_ext(size_t initial_capacity)
+{
+    uvector_t *v = _allocate_vector();
+    v->initial_capacity = initial_capacity;
+    uvector_reserve_capacity(v, initial_capacity);
+
+    return v;
+}
+
 uvector_t *uvector_create_from_array(void *array, size_t array_len,
                                      size_t array_element_size,
                                      ugeneric_type_e uvector_element_type)
@@ -146,7 +175,10 @@ void uvector_destroy(uvector_t *v)
                 ugeneric_destroy_v(v->cells[i], v->void_handlers.dtr);
             }
         }
-        ufree(v->cells);
+        if (!_is_inline(v))
+        {
+            ufree_large(v->cells, v->capacity * sizeof(v->cells[0]));
+        }
         ufree(v);
     }
 }
@@ -214,9 +246,23 @@ void uvector_shrink_to_size(uvector_t *v)
 {
     UASSERT_INPUT(v);
 
-    if (v->capacity && v->size && (v->capacity > v->size))
+    if (_is_inline(v) || (v->capacity == v->size))
     {
-        void *p = urealloc(v->cells, v->size * sizeof(v->cells[0]));
+        return;
+    }
+
+    if (v->size <= UVECTOR_INLINE_CAPACITY)
+    {
+        // Move back to inline storage.
+        memcpy(v->inline_cells, v->cells, v->size * sizeof(v->cells[0]));
+        ufree_large(v->cells, v->capacity * sizeof(v->cells[0]));
+        v->cells = v->inline_cells;
+        v->capacity = UVECTOR_INLINE_CAPACITY;
+    }
+    else
+    {
+        void *p = urealloc_large(v->cells, v->capacity * sizeof(v->cells[0]),
+                                 v->size * sizeof(v->cells[0]));
         v->cells = p;
         v->capacity = v->size;
     }
@@ -228,7 +274,18 @@ void uvector_reserve_capacity(uvector_t *v, size_t new_capacity)
 
     if (v->capacity < new_capacity)
     {
-        void *p = urealloc(v->cells, new_capacity * sizeof(v->cells[0]));
+        void *p;
+        if (_is_inline(v))
+        {
+            // Spill inline cells to the heap.
+            p = umalloc_large(new_capacity * sizeof(v->cells[0]));
+            memcpy(p, v->cells, v->size * sizeof(v->cells[0]));
+        }
+        else
+        {
+            p = urealloc_large(v->cells, v->capacity * sizeof(v->cells[0]),
+                               new_capacity * sizeof(v->cells[0]));
+        }
         v->cells = p;
         v->capacity = new_capacity;
     }
@@ -240,6 +297,28 @@ size_t uvector_get_capacity(const uvector_t *v)
     return v->capacity;
 }
 
+umemusage_t uvector_get_memory_usage(const uvector_t *v)
+{
+    UASSERT_INPUT(v);
+
+    umemusage_t u = {0};
+    u.structure = sizeof(*v);
+    if (!_is_inline(v))
+    {
+        u.structure += v->size * sizeof(v->cells[0]);
+        u.slack = (v->capacity - v->size) * sizeof(v->cells[0]);
+    }
+    if (v->is_data_owner)
+    {
+        for (size_t i = 0; i < v->size; i++)
+        {
+            umemusage_add(&u, ugeneric_get_memory_usage(v->cells[i]));
+        }
+    }
+
+    return u;
+}
+
 size_t uvector_get_size(const uvector_t *v)
 {
     UASSERT_INPUT(v);
@@ -300,12 +379,122 @@ void uvector_append(uvector_t *v, ugeneric_t e)
     if (v->capacity == v->size)
     {
         size_t new_capacity = MAX(SCALE_FACTOR * v->size,
-                                  VECTOR_INITIAL_CAPACITY);
-        uvector_reserve_capacity(v, new_capacity ? new_capacity : 1);
+                                  v->initial_capacity);
+        uvector_reserve_capacity(v, MAX(new_capacity, v->size + 1));
     }
     v->cells[v->size++] = e;
 }
 
+/*
+ * Makes room for n more elements in one reallocation, keeps growth
+ * geometric so that a sequence of bulk appends stays amortized O(1).
+ */
+static void _grow(uvector_t *v, size_t n)
+{
+    if (v->capacity - v->size < n)
+    {
+        size_t new_capacity = MAX(SCALE_FACTOR * v->size,
+                                  v->initial_capacity);
+        uvector_reserve_capacity(v, MAX(new_capacity, v->size + n));
+    }
+}
+
+static void _insert_cells(uvector_t *v, size_t i, const ugeneric_t *cells,
+                          size_t n, ucopy_kind_t kind, void_cpy_t cpy)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    // Source range may belong to v itself and move on reallocation.
+    ugeneric_t *tmp = NULL;
+    if ((cells >= v->cells) && (cells < v->cells + v->size))
+    {
+        tmp = umemdup(cells, n * sizeof(cells[0]));
+        cells = tmp;
+    }
+
+    _grow(v, n);
+    memmove(v->cells + i + n, v->cells + i, (v->size - i) * sizeof(v->cells[0]));
+    if (kind == UCOPY_DEEP)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            v->cells[i + j] = ugeneric_copy_v(cells[j], cpy);
+        }
+    }
+    else
+    {
+        memcpy(v->cells + i, cells, n * sizeof(v->cells[0]));
+    }
+    v->size += n;
+
+    ufree(tmp);
+}
+
+void uvector_append_array(uvector_t *v, const ugeneric_t *array, size_t n,
+                          ucopy_kind_t kind)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(array || !n);
+
+    _insert_cells(v, v->size, array, n, kind, v->void_handlers.cpy);
+}
+
+void uvector_extend(uvector_t *v, const uvector_t *src, ucopy_kind_t kind)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(src);
+
+    _insert_cells(v, v->size, src->cells, src->size, kind,
+                  src->void_handlers.cpy);
+}
+
+void uvector_insert_range(uvector_t *v, size_t i, const uvector_t *src,
+                          size_t begin, size_t end, ucopy_kind_t kind)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(src);
+    UASSERT_INPUT(i <= v->size);
+    UASSERT_INPUT(begin <= end);
+    UASSERT_INPUT(end <= src->size);
+
+    _insert_cells(v, i, src->cells + begin, end - begin, kind,
+                  src->void_handlers.cpy);
+}
+
+void uvector_remove_range(uvector_t *v, size_t begin, size_t end)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(begin <= end);
+    UASSERT_INPUT(end <= v->size);
+
+    if (v->is_data_owner)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            ugeneric_destroy_v(v->cells[i], v->void_handlers.dtr);
+        }
+    }
+    memmove(v->cells + begin, v->cells + end, (v->size - end) * sizeof(v->cells[0]));
+    v->size -= end - begin;
+}
+
+void uvector_assign(uvector_t *v, const uvector_t *src, ucopy_kind_t kind)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(src);
+
+    if (v != src)
+    {
+        uvector_clear(v);
+        uvector_reserve_capacity(v, src->size);
+        _insert_cells(v, 0, src->cells, src->size, kind,
+                      src->void_handlers.cpy);
+    }
+}
+
 ugeneric_t uvector_get_back(const uvector_t *v)
 {
     UASSERT_INPUT(v);
@@ -318,7 +507,7 @@ ugeneric_t uvector_pop_at(uvector_t *v, size_t i)
     UASSERT_INPUT(i < v->size);
 
     ugeneric_t e = v->cells[i];
-    memmove(v->cells + i, v->cells - i + 1, (v->size - i - 1) * sizeof(v->cells[0]));
+    memmove(v->cells + i, v->cells + i + 1, (v->size - i - 1) * sizeof(v->cells[0]));
     v->size--;
 
     return e;
@@ -344,7 +533,100 @@ void uvector_reverse_range(uvector_t *v, size_t l, size_t r)
 void uvector_sort(uvector_t *v)
 {
     UASSERT_INPUT(v);
-    v->sorter(v->cells, v->size, v->void_handlers.cmp);
+
+    /* Default sorter is replaced with radix sort for numeric vectors and
+     * with parallel sort for anything else if sorting threads are enabled.
+     */
+    size_t nthreads = libugeneric_get_sort_threads();
+    if (v->sorter != hybrid_sort)
+    {
+        v->sorter(v->cells, v->size, v->void_handlers.cmp);
+    }
+    else if (radix_sort_supports(v->cells, v->size))
+    {
+        radix_sort(v->cells, v->size, v->void_handlers.cmp);
+    }
+    else if (nthreads != 1)
+    {
+        parallel_sort(v->cells, v->size, v->void_handlers.cmp, nthreads);
+    }
+    else
+    {
+        hybrid_sort(v->cells, v->size, v->void_handlers.cmp);
+    }
+}
+
+void uvector_nth_element(uvector_t *v, size_t nth)
+{
+    UASSERT_INPUT(v);
+    ugeneric_array_nth_element(v->cells, v->size, nth, v->void_handlers.cmp);
+}
+
+void uvector_partial_sort(uvector_t *v, size_t k)
+{
+    UASSERT_INPUT(v);
+    ugeneric_array_partial_sort(v->cells, v->size, k, v->void_handlers.cmp);
+}
+
+uvector_t *uvector_top_k(const uvector_t *v, size_t k)
+{
+    UASSERT_INPUT(v);
+
+    /* Min heap of at most k elements holds the k largest ones seen so far,
+     * its root is the smallest of them and the first one to be evicted.
+     */
+    k = MIN(k, v->size);
+    uheap_t *h = uheap_create_ext(MAX(k, 1), UHEAP_TYPE_MIN);
+    uheap_drop_data_ownership(h);
+    uheap_set_void_comparator(h, v->void_handlers.cmp);
+
+    for (size_t i = 0; i < v->size; i++)
+    {
+        if (uheap_get_size(h) < k)
+        {
+            uheap_push(h, v->cells[i]);
+        }
+        else if (k)
+        {
+            uheap_pushpop(h, v->cells[i]);
+        }
+    }
+
+    uvector_t *top = _allocate_vector();
+    memcpy(&top->void_handlers, &v->void_handlers, sizeof(v->void_handlers));
+    top->is_data_owner = false;
+    uvector_resize(top, k, G_NULL());
+    while (k)
+    {
+        top->cells[--k] = uheap_pop(h);
+    }
+    uheap_destroy(h);
+
+    return top;
+}
+
+void uvector_sort_by_key(uvector_t *v, ugeneric_key_extractor_t key, void *ctx)
+{
+    UASSERT_INPUT(v);
+    key_sort(v->cells, v->size, key, ctx, v->void_handlers.cmp);
+}
+
+void uvector_sort_by_field(uvector_t *v, const char *field)
+{
+    UASSERT_INPUT(v);
+    field_sort(v->cells, v->size, field);
+}
+
+void uvector_set_sorter(uvector_t *v, ugeneric_sorter_t sorter)
+{
+    UASSERT_INPUT(v);
+    v->sorter = sorter ? sorter : _default_vector_sorter;
+}
+
+ugeneric_sorter_t uvector_get_sorter(const uvector_t *v)
+{
+    UASSERT_INPUT(v);
+    return v->sorter;
 }
 
 bool uvector_is_sorted(const uvector_t *v)
@@ -414,6 +696,142 @@ bool uvector_next_permutation(uvector_t *v)
     return ugeneric_array_next_permutation(v->cells, v->size, v->void_handlers.cmp);
 }
 
+typedef struct {
+    const ugeneric_t *src;
+    ugeneric_t *dst;
+    bool *flags;
+    union {
+        ugeneric_mapper_t map;
+        ugeneric_predicate_t filter;
+        ugeneric_reducer_t reduce;
+        ugeneric_visitor_t visit;
+    } f;
+    void *ctx;
+} _parallel_ctx_t;
+
+static void _map_chunk(size_t begin, size_t end, void *ctx)
+{
+    _parallel_ctx_t *pc = ctx;
+    for (size_t i = begin; i < end; i++)
+    {
+        pc->dst[i] = pc->f.map(pc->src[i], pc->ctx);
+    }
+}
+
+uvector_t *uvector_map(const uvector_t *v, ugeneric_mapper_t f, void *ctx)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(f);
+
+    uvector_t *out = uvector_create();
+    uvector_reserve_capacity(out, v->size);
+    _parallel_ctx_t pc = {.src = v->cells, .dst = out->cells, .f.map = f, .ctx = ctx};
+    upool_run(upool_get_shared(), v->size, UVECTOR_PARALLEL_CHUNK, _map_chunk, &pc);
+    out->size = v->size;
+
+    return out;
+}
+
+static void _filter_chunk(size_t begin, size_t end, void *ctx)
+{
+    _parallel_ctx_t *pc = ctx;
+    for (size_t i = begin; i < end; i++)
+    {
+        pc->flags[i] = pc->f.filter(pc->src[i], pc->ctx);
+    }
+}
+
+uvector_t *uvector_filter(const uvector_t *v, ugeneric_predicate_t f, void *ctx)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(f);
+
+    uvector_t *out = _allocate_vector();
+    out->void_handlers = v->void_handlers;
+    out->is_data_owner = false;
+    if (v->size == 0)
+    {
+        return out;
+    }
+
+    // Evaluate the predicate in parallel, compact serially to keep order.
+    bool *flags = umalloc_large(v->size * sizeof(flags[0]));
+    _parallel_ctx_t pc = {.src = v->cells, .flags = flags, .f.filter = f, .ctx = ctx};
+    upool_run(upool_get_shared(), v->size, UVECTOR_PARALLEL_CHUNK, _filter_chunk, &pc);
+
+    size_t n = 0;
+    for (size_t i = 0; i < v->size; i++)
+    {
+        n += flags[i];
+    }
+    uvector_reserve_capacity(out, n);
+    for (size_t i = 0; i < v->size; i++)
+    {
+        if (flags[i])
+        {
+            out->cells[out->size++] = v->cells[i];
+        }
+    }
+    ufree_large(flags, v->size * sizeof(flags[0]));
+
+    return out;
+}
+
+static void _reduce_chunk(size_t begin, size_t end, void *ctx)
+{
+    _parallel_ctx_t *pc = ctx;
+    ugeneric_t acc = pc->src[begin];
+    for (size_t i = begin + 1; i < end; i++)
+    {
+        acc = pc->f.reduce(acc, pc->src[i], pc->ctx);
+    }
+    pc->dst[begin / UVECTOR_PARALLEL_CHUNK] = acc;
+}
+
+ugeneric_t uvector_reduce(const uvector_t *v, ugeneric_reducer_t f,
+                          ugeneric_t init, void *ctx)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(f);
+
+    if (v->size == 0)
+    {
+        return init;
+    }
+
+    size_t nchunks = (v->size + UVECTOR_PARALLEL_CHUNK - 1) / UVECTOR_PARALLEL_CHUNK;
+    ugeneric_t *partial = umalloc(nchunks * sizeof(partial[0]));
+    _parallel_ctx_t pc = {.src = v->cells, .dst = partial, .f.reduce = f, .ctx = ctx};
+    upool_run(upool_get_shared(), v->size, UVECTOR_PARALLEL_CHUNK, _reduce_chunk, &pc);
+
+    ugeneric_t acc = init;
+    for (size_t i = 0; i < nchunks; i++)
+    {
+        acc = f(acc, partial[i], ctx);
+    }
+    ufree(partial);
+
+    return acc;
+}
+
+static void _for_each_chunk(size_t begin, size_t end, void *ctx)
+{
+    _parallel_ctx_t *pc = ctx;
+    for (size_t i = begin; i < end; i++)
+    {
+        pc->f.visit(&pc->dst[i], pc->ctx);
+    }
+}
+
+void uvector_for_each_parallel(uvector_t *v, ugeneric_visitor_t f, void *ctx)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(f);
+
+    _parallel_ctx_t pc = {.dst = v->cells, .f.visit = f, .ctx = ctx};
+    upool_run(upool_get_shared(), v->size, UVECTOR_PARALLEL_CHUNK, _for_each_chunk, &pc);
+}
+
 ugeneric_base_t *uvector_get_base(uvector_t *v)
 {
     UASSERT_INPUT(v);
@@ -428,30 +846,347 @@ uvector_t *uvector_get_slice(const uvector_t *v, size_t begin, size_t end,
     UASSERT_INPUT(end <= v->size);
     UASSERT_INPUT(stride != 0);
 
-    uvector_t *slice = umalloc(sizeof(*v));
+    uvector_t *slice = _allocate_vector();
     memcpy(&slice->void_handlers, &v->void_handlers, sizeof(v->void_handlers));
-    slice->size = (end - begin) / stride + (bool)((end - begin) % stride);
-    slice->capacity = slice->size;
     slice->is_data_owner = false;
-    slice->sorter = _default_vector_sorter;
-    slice->cells = NULL;
-    if (slice->size)
+    size_t size = (end - begin) / stride + (bool)((end - begin) % stride);
+    uvector_reserve_capacity(slice, size);
+    for (size_t i = 0; i < size; i++)
+    {
+        slice->cells[i] = v->cells[begin + i * stride];
+    }
+    slice->size = size;
+
+    return slice;
+}
+
+/*
+ * Elements of different types never compare equal (except strings), so a
+ * G_INT_T, G_SIZE_T or G_REAL_T element can only be equal to the cells of
+ * exactly the same type and value. Such scans compare raw cells instead of
+ * calling ugeneric_compare_v(): type is the low 4 bytes of t, the upper 4
+ * bytes are garbage and are masked out.
+ */
+static bool _is_raw_scannable(ugeneric_t e)
+{
+    switch (e.t.type)
+    {
+        case G_INT_T:
+        case G_SIZE_T:
+            return true;
+        case G_REAL_T:
+            return G_AS_REAL(e) == G_AS_REAL(e); // NaN aborts on comparison
+        default:
+            return false;
+    }
+}
+
+#ifdef __SSE2__
+
+#define _SCAN_UNROLL 4
+
+/* Returns all ones if the cell matches the key and some zero bits otherwise.
+ * Lane 0 holds the type, lane 1 the garbage, lanes 2 and 3 the value: the
+ * lane mask is folded so every lane ends up with the AND of all four.
+ */
+static inline __m128i _cell_match(__m128i cell, __m128i key, __m128d rkey,
+                                  bool real)
+{
+    const __m128i type_lane = _mm_set_epi32(0, 0, 0, -1);
+    const __m128i pad_lane = _mm_set_epi32(0, 0, -1, 0);
+    const __m128i value_lanes = _mm_set_epi32(-1, -1, 0, 0);
+
+    __m128i eq = _mm_cmpeq_epi32(cell, key);
+    // 0.0 == -0.0 just like in ugeneric_compare_v().
+    __m128i value_eq = real
+        ? _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(cell), rkey))
+        : eq;
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_and_si128(eq, type_lane),
+                                          _mm_and_si128(value_eq, value_lanes)),
+                             pad_lane);
+    m = _mm_and_si128(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_and_si128(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+static size_t _raw_scan(const ugeneric_t *cells, size_t from, size_t to,
+                        ugeneric_t e)
+{
+    const __m128i key = _mm_set_epi64x(e.v.integer, e.t.type);
+    const bool real = (e.t.type == G_REAL_T);
+    const __m128d rkey = _mm_set1_pd(real ? G_AS_REAL(e) : 0);
+    const __m128i *p = (const __m128i *)cells;
+
+    // Match masks of several cells are combined to branch once per block.
+    size_t i = from;
+    for (; i + _SCAN_UNROLL <= to; i += _SCAN_UNROLL)
+    {
+        __m128i m[_SCAN_UNROLL];
+        for (size_t k = 0; k < _SCAN_UNROLL; k++)
+        {
+            m[k] = _cell_match(_mm_loadu_si128(p + i + k), key, rkey, real);
+        }
+        __m128i any = _mm_or_si128(_mm_or_si128(m[0], m[1]),
+                                   _mm_or_si128(m[2], m[3]));
+        if (_mm_movemask_epi8(any))
+        {
+            for (size_t k = 0; ; k++)
+            {
+                if (_mm_movemask_epi8(m[k]))
+                {
+                    return i + k;
+                }
+            }
+        }
+    }
+    for (; i < to; i++)
     {
-        slice->cells = umalloc(sizeof(slice->cells[0]) * slice->size);
-        for (size_t i = 0; i < slice->size; i++)
+        if (_mm_movemask_epi8(_cell_match(_mm_loadu_si128(p + i), key, rkey,
+                                          real)))
         {
-            slice->cells[i] = v->cells[begin + i * stride];
+            return i;
         }
     }
 
-    return slice;
+    return SIZE_MAX;
+}
+
+#else
+
+static size_t _raw_scan(const ugeneric_t *cells, size_t from, size_t to,
+                        ugeneric_t e)
+{
+    for (size_t i = from; i < to; i++)
+    {
+        if (cells[i].t.type != e.t.type)
+        {
+            continue;
+        }
+        if ((e.t.type == G_REAL_T) ? (G_AS_REAL(cells[i]) == G_AS_REAL(e))
+                                   : (G_AS_INT(cells[i]) == G_AS_INT(e)))
+        {
+            return i;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+#endif
+
+static size_t _scan(const uvector_t *v, size_t from, ugeneric_t e)
+{
+    if (_is_raw_scannable(e))
+    {
+        return _raw_scan(v->cells, from, v->size, e);
+    }
+
+    for (size_t i = from; i < v->size; i++)
+    {
+        if (ugeneric_compare_v(v->cells[i], e, v->void_handlers.cmp) == 0)
+        {
+            return i;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+size_t uvector_find(const uvector_t *v, ugeneric_t e)
+{
+    UASSERT_INPUT(v);
+    return _scan(v, 0, e);
+}
+
+size_t uvector_count(const uvector_t *v, ugeneric_t e)
+{
+    UASSERT_INPUT(v);
+
+    size_t count = 0;
+    for (size_t i = _scan(v, 0, e); i != SIZE_MAX; i = _scan(v, i + 1, e))
+    {
+        count++;
+    }
+
+    return count;
 }
 
 bool uvector_contains(const uvector_t *v, ugeneric_t e)
+{
+    return uvector_find(v, e) != SIZE_MAX;
+}
+
+static bool _is_hashable(const uvector_t *v)
 {
     for (size_t i = 0; i < v->size; i++)
     {
-        if (ugeneric_compare_v(v->cells[i], e, v->void_handlers.cmp) == 0)
+        switch (ugeneric_get_type(v->cells[i]))
+        {
+            case G_PTR_T:
+            case G_VECTOR_T:
+            case G_DICT_T:
+                return false;
+            default:
+                break;
+        }
+    }
+
+    return true;
+}
+
+/* Either drops v->cells[i] as a duplicate or moves it to the end of
+ * the kept elements [0, *kept).
+ */
+static void _keep_unique(uvector_t *v, size_t i, bool dup, size_t *kept)
+{
+    if (dup)
+    {
+        if (v->is_data_owner)
+        {
+            ugeneric_destroy_v(v->cells[i], v->void_handlers.dtr);
+        }
+    }
+    else
+    {
+        v->cells[(*kept)++] = v->cells[i];
+    }
+}
+
+void uvector_unique(uvector_t *v)
+{
+    UASSERT_INPUT(v);
+
+    if (v->size < 2)
+    {
+        return;
+    }
+
+    size_t kept = 1;
+    void_cmp_t cmp = v->void_handlers.cmp;
+
+    if (ugeneric_array_is_sorted(v->cells, v->size, cmp))
+    {
+        // Duplicates are adjacent, compact in place.
+        for (size_t i = 1; i < v->size; i++)
+        {
+            bool dup = ugeneric_compare_v(v->cells[kept - 1], v->cells[i], cmp) == 0;
+            _keep_unique(v, i, dup, &kept);
+        }
+    }
+    else if ((v->size >= UVECTOR_UNIQUE_HASH_THRESHOLD) && _is_hashable(v))
+    {
+        uhtbl_t *seen = uhtbl_create();
+        uhtbl_drop_data_ownership(seen);
+        uhtbl_put(seen, v->cells[0], G_NULL());
+        for (size_t i = 1; i < v->size; i++)
+        {
+            bool dup = uhtbl_has_key(seen, v->cells[i]);
+            if (!dup)
+            {
+                uhtbl_put(seen, v->cells[i], G_NULL());
+            }
+            _keep_unique(v, i, dup, &kept);
+        }
+        uhtbl_destroy(seen);
+    }
+    else
+    {
+        for (size_t i = 1; i < v->size; i++)
+        {
+            bool dup = false;
+            for (size_t j = 0; j < kept && !dup; j++)
+            {
+                dup = ugeneric_compare_v(v->cells[j], v->cells[i], cmp) == 0;
+            }
+            _keep_unique(v, i, dup, &kept);
+        }
+    }
+
+    v->size = kept;
+}
+
+static inline const ugeneric_t *_view_at(uvector_view_t w, size_t i)
+{
+    return w.base + i * w.stride;
+}
+
+uvector_view_t uvector_view(const uvector_t *v, size_t begin, size_t end,
+                            size_t stride)
+{
+    UASSERT_INPUT(v);
+    UASSERT_INPUT(begin <= end);
+    UASSERT_INPUT(end <= v->size);
+    UASSERT_INPUT(stride != 0);
+
+    uvector_view_t w = {
+        .base = v->cells + begin,
+        .len = (end - begin) / stride + (bool)((end - begin) % stride),
+        .stride = stride,
+        .void_handlers = v->void_handlers,
+    };
+
+    return w;
+}
+
+uvector_view_t uvector_view_get_view(uvector_view_t w, size_t begin,
+                                     size_t end, size_t stride)
+{
+    UASSERT_INPUT(begin <= end);
+    UASSERT_INPUT(end <= w.len);
+    UASSERT_INPUT(stride != 0);
+
+    uvector_view_t sub = w;
+    sub.base = w.base ? _view_at(w, begin) : NULL;
+    sub.len = (end - begin) / stride + (bool)((end - begin) % stride);
+    sub.stride = w.stride * stride;
+
+    return sub;
+}
+
+uvector_t *uvector_view_as_uvector(uvector_view_t w)
+{
+    uvector_t *v = _allocate_vector();
+    v->void_handlers = w.void_handlers;
+    v->is_data_owner = false;
+    if (w.len)
+    {
+        uvector_reserve_capacity(v, w.len);
+        for (size_t i = 0; i < w.len; i++)
+        {
+            v->cells[i] = *_view_at(w, i);
+        }
+        v->size = w.len;
+    }
+
+    return v;
+}
+
+ugeneric_t uvector_view_get_at(uvector_view_t w, size_t i)
+{
+    UASSERT_INPUT(i < w.len);
+    return *_view_at(w, i);
+}
+
+int uvector_view_compare(uvector_view_t w1, uvector_view_t w2)
+{
+    size_t len = MIN(w1.len, w2.len);
+    for (size_t i = 0; i < len; i++)
+    {
+        int diff = ugeneric_compare_v(*_view_at(w1, i), *_view_at(w2, i),
+                                      w1.void_handlers.cmp);
+        if (diff)
+        {
+            return diff;
+        }
+    }
+
+    return (w1.len > w2.len) - (w1.len < w2.len);
+}
+
+bool uvector_view_contains(uvector_view_t w, ugeneric_t e)
+{
+    for (size_t i = 0; i < w.len; i++)
+    {
+        if (ugeneric_compare_v(*_view_at(w, i), e, w.void_handlers.cmp) == 0)
         {
             return true;
         }
@@ -460,6 +1195,82 @@ bool uvector_contains(const uvector_t *v, ugeneric_t e)
     return false;
 }
 
+bool uvector_view_is_sorted(uvector_view_t w)
+{
+    for (size_t i = 1; i < w.len; i++)
+    {
+        if (ugeneric_compare_v(*_view_at(w, i - 1), *_view_at(w, i),
+                               w.void_handlers.cmp) > 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t uvector_view_bsearch(uvector_view_t w, ugeneric_t e)
+{
+    size_t l = 0;
+    size_t r = w.len;
+
+    while (l < r)
+    {
+        size_t m = l + (r - l) / 2;
+        int diff = ugeneric_compare_v(*_view_at(w, m), e, w.void_handlers.cmp);
+        if (diff == 0)
+        {
+            return m;
+        }
+        else if (diff < 0)
+        {
+            l = m + 1;
+        }
+        else
+        {
+            r = m;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+void uvector_view_serialize(uvector_view_t w, ubuffer_t *buf)
+{
+    UASSERT_INPUT(buf);
+
+    ubuffer_append_byte(buf, '[');
+    for (size_t i = 0; i < w.len; i++)
+    {
+        ugeneric_serialize_v(*_view_at(w, i), buf, w.void_handlers.s8r);
+        if (i < w.len - 1)
+        {
+            ubuffer_append_data(buf, ", ", 2);
+        }
+    }
+    ubuffer_append_byte(buf, ']');
+}
+
+char *uvector_view_as_str(uvector_view_t w)
+{
+    ubuffer_t buf = {0};
+    uvector_view_serialize(w, &buf);
+    ubuffer_null_terminate(&buf);
+
+    return buf.data;
+}
+
+int uvector_view_fprint(uvector_view_t w, FILE *out)
+{
+    UASSERT_INPUT(out);
+
+    char *str = uvector_view_as_str(w);
+    int ret = fprintf(out, "%s\n", str);
+    ufree(str);
+
+    return ret;
+}
+
 void uvector_dump_to_gnuplot(const uvector_t *v, gnuplot_attrs_t *attrs, FILE *out)
 {
     fprintf(out,
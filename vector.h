@@ -3,11 +3,38 @@
 
 #include "generic.h"
 
+/* Capacity a vector grows to when it first outgrows its inline cells,
+ * uvector_create_ext() overrides it per vector.
+ */
 #define VECTOR_INITIAL_CAPACITY 16
 
+/* Number of elements kept inside the vector header, vectors which never
+ * grow beyond it do not allocate cells separately.
+ */
+#ifndef UVECTOR_INLINE_CAPACITY
+#define UVECTOR_INLINE_CAPACITY 4
+#endif
+
+/* uvector_unique() uses a hash table for unsorted vectors of this size and
+ * above, shorter ones are deduplicated by a quadratic scan.
+ */
+#ifndef UVECTOR_UNIQUE_HASH_THRESHOLD
+#define UVECTOR_UNIQUE_HASH_THRESHOLD 32
+#endif
+
+/* Number of elements uvector_map() and friends hand out to a thread at once. */
+#ifndef UVECTOR_PARALLEL_CHUNK
+#define UVECTOR_PARALLEL_CHUNK 1024
+#endif
+
 typedef struct uvector_opaq uvector_t;
 
 uvector_t *uvector_create(void);
+/* Reserves initial_capacity cells upfront and grows to at least that many
+ * when the inline cells are outgrown, 0 lets the vector grow from inline
+ * cells by SCALE_FACTOR for the smallest slack.
+ */
+uvector_t *uvector_create_ext(size_t initial_capacity);
 uvector_t *uvector_create_with_size(size_t size, ugeneric_t value);
 uvector_t *uvector_create_from_array(void *array, size_t array_len,
                                      size_t array_element_size,
@@ -24,12 +51,39 @@ void uvector_insert_at(uvector_t *v, size_t i, ugeneric_t e);
 void uvector_remove_at(uvector_t *v, size_t i);
 ugeneric_t uvector_pop_at(uvector_t *v, size_t i);
 ugeneric_t uvector_pop_back(uvector_t *v);
+
+/*
+ * Bulk operations reserve capacity and move the tail once per call.
+ * UCOPY_SHALLOW copies elements as is, so when both vectors own their data
+ * only one of them may keep the ownership. UCOPY_DEEP copies elements with
+ * the copier of the source vector (of v for arrays).
+ */
+void uvector_append_array(uvector_t *v, const ugeneric_t *array, size_t n,
+                          ucopy_kind_t kind);
+void uvector_extend(uvector_t *v, const uvector_t *src, ucopy_kind_t kind);
+void uvector_insert_range(uvector_t *v, size_t i, const uvector_t *src,
+                          size_t begin, size_t end, ucopy_kind_t kind);
+void uvector_remove_range(uvector_t *v, size_t begin, size_t end);
+void uvector_assign(uvector_t *v, const uvector_t *src, ucopy_kind_t kind);
+
 ugeneric_t uvector_get_back(const uvector_t *v);
 ugeneric_t uvector_get_at(const uvector_t *v, size_t i);
 ugeneric_t uvector_get_at_random(const uvector_t *v);
 void uvector_set_at(uvector_t *v, size_t i, ugeneric_t e);
 ugeneric_t *uvector_get_cells(const uvector_t *v);
 bool uvector_contains(const uvector_t *v, ugeneric_t e);
+/* Returns index of the first element equal to e or SIZE_MAX if there is
+ * none. G_INT_T, G_SIZE_T and G_REAL_T elements are searched by comparing
+ * raw cells (with SSE2 where available), NaN cells never match.
+ */
+size_t uvector_find(const uvector_t *v, ugeneric_t e);
+size_t uvector_count(const uvector_t *v, ugeneric_t e);
+/* Removes duplicates keeping the first occurrence of each element and the
+ * order of elements. Sorted vectors are compacted in place, longer unsorted
+ * ones are deduplicated with a hash table in O(n) unless they hold
+ * unhashable elements (G_PTR, vectors or dicts).
+ */
+void uvector_unique(uvector_t *v);
 
 bool uvector_is_empty(const uvector_t *v);
 size_t uvector_get_size(const uvector_t *v);
@@ -38,6 +92,7 @@ void uvector_shrink_to_size(uvector_t *v);
 
 void uvector_reserve_capacity(uvector_t *v, size_t new_capacity);
 size_t uvector_get_capacity(const uvector_t *v);
+umemusage_t uvector_get_memory_usage(const uvector_t *v);
 uvector_t *uvector_get_slice(const uvector_t *v, size_t begin, size_t end,
                              size_t stride);
 
@@ -45,10 +100,41 @@ void uvector_swap(uvector_t *v, size_t l, size_t r);
 void uvector_reverse(uvector_t *v);
 void uvector_reverse_range(uvector_t *v, size_t l, size_t r);
 void uvector_sort(uvector_t *v);
+void uvector_nth_element(uvector_t *v, size_t nth);
+void uvector_partial_sort(uvector_t *v, size_t k);
+/* Returns a vector of the k largest elements (or all of them if there are
+ * fewer) in descending order. The result does not own the elements.
+ */
+uvector_t *uvector_top_k(const uvector_t *v, size_t k);
+void uvector_sort_by_key(uvector_t *v, ugeneric_key_extractor_t key, void *ctx);
+void uvector_sort_by_field(uvector_t *v, const char *field);
+/* Sorter used by uvector_sort(), say timsort for partially ordered data.
+ * NULL restores the default one.
+ */
+void uvector_set_sorter(uvector_t *v, ugeneric_sorter_t sorter);
+ugeneric_sorter_t uvector_get_sorter(const uvector_t *v);
 bool uvector_is_sorted(const uvector_t *v);
 size_t uvector_bsearch(const uvector_t *v, ugeneric_t e);
 bool uvector_next_permutation(uvector_t *v);
 
+/*
+ * Data parallel operations run on the shared pool (see pool.h) in chunks of
+ * UVECTOR_PARALLEL_CHUNK elements, so callbacks must be safe to call
+ * concurrently. Output order does not depend on scheduling:
+ *   - uvector_map() returns a new vector owning f(e) of every element e;
+ *   - uvector_filter() returns a new vector with elements f(e) is true for,
+ *     it does not own them;
+ *   - uvector_reduce() folds every chunk starting from its first element
+ *     and then folds chunk results into init left to right, so f has to be
+ *     associative;
+ *   - uvector_for_each_parallel() calls f for every cell in place.
+ */
+uvector_t *uvector_map(const uvector_t *v, ugeneric_mapper_t f, void *ctx);
+uvector_t *uvector_filter(const uvector_t *v, ugeneric_predicate_t f, void *ctx);
+ugeneric_t uvector_reduce(const uvector_t *v, ugeneric_reducer_t f,
+                          ugeneric_t init, void *ctx);
+void uvector_for_each_parallel(uvector_t *v, ugeneric_visitor_t f, void *ctx);
+
 static void uvector_take_data_ownership(uvector_t *v);
 static void uvector_drop_data_ownership(uvector_t *v);
 static bool uvector_is_data_owner(uvector_t *v);
@@ -67,6 +153,36 @@ typedef struct {
 void uvector_dump_to_gnuplot(const uvector_t *v, gnuplot_attrs_t *attrs,
                              FILE *out);
 
+/*
+ * View is a read-only window into elements [begin, end) of a vector taken
+ * with the given stride. It is a plain value referencing cells of the vector,
+ * so neither taking a view nor iterating it allocates or copies anything.
+ * View gets invalid once the vector is modified, resized or destroyed.
+ */
+typedef struct {
+    const ugeneric_t *base;
+    size_t len;
+    size_t stride;
+    uvoid_handlers_t void_handlers;
+} uvector_view_t;
+
+uvector_view_t uvector_view(const uvector_t *v, size_t begin, size_t end,
+                            size_t stride);
+uvector_view_t uvector_view_get_view(uvector_view_t w, size_t begin,
+                                     size_t end, size_t stride);
+uvector_t *uvector_view_as_uvector(uvector_view_t w);
+static inline size_t uvector_view_get_size(uvector_view_t w) {return w.len;}
+static inline bool uvector_view_is_empty(uvector_view_t w) {return w.len == 0;}
+ugeneric_t uvector_view_get_at(uvector_view_t w, size_t i);
+int uvector_view_compare(uvector_view_t w1, uvector_view_t w2);
+bool uvector_view_contains(uvector_view_t w, ugeneric_t e);
+bool uvector_view_is_sorted(uvector_view_t w);
+size_t uvector_view_bsearch(uvector_view_t w, ugeneric_t e);
+char *uvector_view_as_str(uvector_view_t w);
+void uvector_view_serialize(uvector_view_t w, ubuffer_t *buf);
+int uvector_view_fprint(uvector_view_t w, FILE *out);
+static inline int uvector_view_print(uvector_view_t w) {return uvector_view_fprint(w, stdout);}
+
 ugeneric_base_t *uvector_get_base(uvector_t *v);
 DEFINE_BASE_FUNCS(uvector)
 
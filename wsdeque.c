@@ -0,0 +1,267 @@
+#include "wsdeque.h"
+
+#include "asserts.h"
+#include "mem.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * Elements [top, bottom) live in cells[i & (capacity - 1)] of the current
+ * array. The owner moves bottom, thieves (and the owner taking the last
+ * element) move top with a CAS. Indices are signed as the owner's pop
+ * moves bottom below top for a moment when the deque is empty.
+ *
+ * A thief may read a cell while the owner overwrites it, the thief's CAS
+ * fails then and the value is thrown away. Cells are accessed as pairs
+ * of relaxed atomic words to keep such reads defined.
+ */
+
+typedef struct {
+    _Atomic uint64_t w[2];
+} _cell_t;
+
+_Static_assert(sizeof(ugeneric_t) == 2 * sizeof(uint64_t),
+               "ugeneric_t is expected to take two words");
+_Static_assert(IS_POWER_OF_TWO(UWSDEQUE_INITIAL_CAPACITY),
+               "capacity has to be a power of two");
+
+typedef struct _array {
+    size_t capacity;
+    struct _array *retired; // arrays replaced by this one
+    _cell_t cells[];
+} _array_t;
+
+struct uwsdeque_opaq {
+    uvoid_handlers_t void_handlers;
+    bool is_data_owner;
+    _Atomic(_array_t *) array;
+
+    _Alignas(UCACHE_LINE_SIZE) atomic_ptrdiff_t top;
+    _Alignas(UCACHE_LINE_SIZE) atomic_ptrdiff_t bottom;
+};
+
+static _array_t *_array_create(size_t capacity)
+{
+    _array_t *a = umalloc(sizeof(*a) + capacity * sizeof(a->cells[0]));
+    a->capacity = capacity;
+    a->retired = NULL;
+
+    return a;
+}
+
+static inline void _put(_array_t *a, ptrdiff_t i, ugeneric_t e)
+{
+    uint64_t w[2];
+    memcpy(w, &e, sizeof(e));
+    _cell_t *c = &a->cells[(size_t)i & (a->capacity - 1)];
+    atomic_store_explicit(&c->w[0], w[0], memory_order_relaxed);
+    atomic_store_explicit(&c->w[1], w[1], memory_order_relaxed);
+}
+
+static inline ugeneric_t _get(_array_t *a, ptrdiff_t i)
+{
+    uint64_t w[2];
+    _cell_t *c = &a->cells[(size_t)i & (a->capacity - 1)];
+    w[0] = atomic_load_explicit(&c->w[0], memory_order_relaxed);
+    w[1] = atomic_load_explicit(&c->w[1], memory_order_relaxed);
+    ugeneric_t e;
+    memcpy(&e, w, sizeof(e));
+
+    return e;
+}
+
+static inline ptrdiff_t _load(const atomic_ptrdiff_t *a, memory_order order)
+{
+    return atomic_load_explicit((atomic_ptrdiff_t *)a, order);
+}
+
+static inline _array_t *_load_array(const uwsdeque_t *d, memory_order order)
+{
+    return atomic_load_explicit((_Atomic(_array_t *) *)&d->array, order);
+}
+
+uwsdeque_t *uwsdeque_create(void)
+{
+    uwsdeque_t *d = umalloc_aligned(UCACHE_LINE_SIZE, sizeof(*d));
+    memset(&d->void_handlers, 0, sizeof(d->void_handlers));
+    d->is_data_owner = true;
+    atomic_init(&d->array, _array_create(UWSDEQUE_INITIAL_CAPACITY));
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+
+    return d;
+}
+
+void uwsdeque_destroy(uwsdeque_t *d)
+{
+    if (d)
+    {
+        uwsdeque_clear(d);
+        _array_t *a = _load_array(d, memory_order_relaxed);
+        while (a)
+        {
+            _array_t *t = a;
+            a = a->retired;
+            ufree(t);
+        }
+        ufree(d);
+    }
+}
+
+void uwsdeque_clear(uwsdeque_t *d)
+{
+    UASSERT_INPUT(d);
+
+    _array_t *a = _load_array(d, memory_order_relaxed);
+    ptrdiff_t b = _load(&d->bottom, memory_order_relaxed);
+    if (d->is_data_owner)
+    {
+        for (ptrdiff_t i = _load(&d->top, memory_order_relaxed); i < b; i++)
+        {
+            ugeneric_destroy_v(_get(a, i), d->void_handlers.dtr);
+        }
+    }
+    atomic_store_explicit(&d->top, b, memory_order_relaxed);
+}
+
+// Moves elements [t, b) to an array twice as big and publishes it.
+static _array_t *_grow(uwsdeque_t *d, _array_t *a, ptrdiff_t t, ptrdiff_t b)
+{
+    _array_t *n = _array_create(2 * a->capacity);
+    for (ptrdiff_t i = t; i < b; i++)
+    {
+        _put(n, i, _get(a, i));
+    }
+    n->retired = a;
+    atomic_store_explicit(&d->array, n, memory_order_release);
+
+    return n;
+}
+
+void uwsdeque_push(uwsdeque_t *d, ugeneric_t e)
+{
+    UASSERT_INPUT(d);
+
+    ptrdiff_t b = _load(&d->bottom, memory_order_relaxed);
+    ptrdiff_t t = _load(&d->top, memory_order_acquire);
+    _array_t *a = _load_array(d, memory_order_relaxed);
+    if ((size_t)(b - t) >= a->capacity)
+    {
+        a = _grow(d, a, t, b);
+    }
+    _put(a, b, e);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+}
+
+bool uwsdeque_pop(uwsdeque_t *d, ugeneric_t *e)
+{
+    UASSERT_INPUT(d);
+    UASSERT_INPUT(e);
+
+    ptrdiff_t b = _load(&d->bottom, memory_order_relaxed) - 1;
+    _array_t *a = _load_array(d, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    ptrdiff_t t = _load(&d->top, memory_order_relaxed);
+
+    if (t > b)
+    {
+        // Empty, restore bottom.
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *e = _get(a, b);
+    if (t == b)
+    {
+        // The last element, race thieves for it.
+        bool won = atomic_compare_exchange_strong_explicit(
+            &d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return won;
+    }
+
+    return true;
+}
+
+bool uwsdeque_steal(uwsdeque_t *d, ugeneric_t *e)
+{
+    UASSERT_INPUT(d);
+    UASSERT_INPUT(e);
+
+    ptrdiff_t t = _load(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    ptrdiff_t b = _load(&d->bottom, memory_order_acquire);
+    if (t >= b)
+    {
+        return false;
+    }
+
+    _array_t *a = _load_array(d, memory_order_acquire);
+    ugeneric_t x = _get(a, t);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+    {
+        return false;
+    }
+    *e = x;
+
+    return true;
+}
+
+size_t uwsdeque_get_size(const uwsdeque_t *d)
+{
+    UASSERT_INPUT(d);
+
+    ptrdiff_t b = _load(&d->bottom, memory_order_acquire);
+    ptrdiff_t t = _load(&d->top, memory_order_acquire);
+
+    return (b > t) ? (size_t)(b - t) : 0;
+}
+
+size_t uwsdeque_get_capacity(const uwsdeque_t *d)
+{
+    UASSERT_INPUT(d);
+    return _load_array(d, memory_order_acquire)->capacity;
+}
+
+bool uwsdeque_is_empty(const uwsdeque_t *d)
+{
+    return uwsdeque_get_size(d) == 0;
+}
+
+umemusage_t uwsdeque_get_memory_usage(const uwsdeque_t *d)
+{
+    UASSERT_INPUT(d);
+
+    _array_t *a = _load_array(d, memory_order_relaxed);
+    ptrdiff_t b = _load(&d->bottom, memory_order_relaxed);
+    ptrdiff_t t = _load(&d->top, memory_order_relaxed);
+    size_t size = uwsdeque_get_size(d);
+
+    umemusage_t u = {0};
+    u.structure = sizeof(*d) + sizeof(*a) + size * sizeof(a->cells[0]);
+    u.slack = (a->capacity - size) * sizeof(a->cells[0]);
+    for (_array_t *r = a->retired; r; r = r->retired)
+    {
+        u.slack += sizeof(*r) + r->capacity * sizeof(r->cells[0]);
+    }
+    if (d->is_data_owner)
+    {
+        for (ptrdiff_t i = t; i < b; i++)
+        {
+            umemusage_add(&u, ugeneric_get_memory_usage(_get(a, i)));
+        }
+    }
+
+    return u;
+}
+
+ugeneric_base_t *uwsdeque_get_base(uwsdeque_t *d)
+{
+    UASSERT_INPUT(d);
+    return (ugeneric_base_t *)d;
+}
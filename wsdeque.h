@@ -0,0 +1,51 @@
+#ifndef UWSDEQUE_H__
+#define UWSDEQUE_H__
+
+#include "generic.h"
+
+/*
+ * Work-stealing deque (Chase-Lev): the owner thread pushes and pops
+ * elements at the bottom in LIFO order like ustack does, any other thread
+ * steals from the top in FIFO order, so thieves take the oldest (usually
+ * the biggest) pieces of recursive divide and conquer work. Storage is a
+ * circular array which the owner grows when it is full; replaced arrays
+ * may still be read by thieves and are freed only with the deque.
+ *
+ * Owner side: uwsdeque_push(), uwsdeque_pop().
+ * Any thread: uwsdeque_steal(), size and emptiness estimates.
+ * The rest (clear, memory usage, destroy) must not run concurrently with
+ * other operations.
+ */
+
+#ifndef UWSDEQUE_INITIAL_CAPACITY
+#define UWSDEQUE_INITIAL_CAPACITY 32
+#endif
+
+typedef struct uwsdeque_opaq uwsdeque_t;
+
+uwsdeque_t *uwsdeque_create(void);
+/* Destroys elements left in the deque if it owns data. */
+void uwsdeque_destroy(uwsdeque_t *d);
+void uwsdeque_clear(uwsdeque_t *d);
+
+void uwsdeque_push(uwsdeque_t *d, ugeneric_t e);
+/* Returns false if the deque is empty. */
+bool uwsdeque_pop(uwsdeque_t *d, ugeneric_t *e);
+/* Returns false if the deque is empty or another thread has taken the top
+ * element first, a thief looking for work just moves to the next victim.
+ */
+bool uwsdeque_steal(uwsdeque_t *d, ugeneric_t *e);
+
+size_t uwsdeque_get_size(const uwsdeque_t *d);
+size_t uwsdeque_get_capacity(const uwsdeque_t *d);
+bool uwsdeque_is_empty(const uwsdeque_t *d);
+umemusage_t uwsdeque_get_memory_usage(const uwsdeque_t *d);
+
+static void uwsdeque_take_data_ownership(uwsdeque_t *d);
+static void uwsdeque_drop_data_ownership(uwsdeque_t *d);
+static bool uwsdeque_is_data_owner(uwsdeque_t *d);
+
+ugeneric_base_t *uwsdeque_get_base(uwsdeque_t *d);
+DEFINE_BASE_FUNCS(uwsdeque)
+
+#endif